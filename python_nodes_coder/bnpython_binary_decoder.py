@@ -0,0 +1,246 @@
+#!/usr/bin/python3
+# MIT License
+#
+# Copyright (c) 2026 Manuel Bottini
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+#
+
+# Reference decoder for the binary messages of the Bodynodes WiFi nodes.
+# The format is described in templates/node/BnBinaryMessages.h
+#
+# Example, listening like a host that asked for the binary format:
+#     python3 bnpython_binary_decoder.py --port 12345
+
+import argparse
+import socket
+import struct
+import time
+
+BINARY_VERSION = 2
+HEADER_FORMAT = "<2sBBHHI"
+HEADER_BYTES = struct.calcsize(HEADER_FORMAT)
+
+# Every record is preceded by the device time in microseconds of its reading
+FLAG_TIMESTAMPED = 0x01
+# Readings taken while the node was not connected, sent after it connected again
+FLAG_HISTORICAL = 0x02
+# The node clock is in sync with the host one, the timestamps are in host time.
+# The header and record timestamps are microseconds either way
+FLAG_HOST_TIME = 0x04
+TIMESTAMP_FORMAT = "<I"
+TIMESTAMP_BYTES = struct.calcsize(TIMESTAMP_FORMAT)
+
+# record type -> (sensortype, struct format of the payload)
+RECORD_TYPES = {
+    0x01: ("orientation_abs", "<4f"),
+    0x02: ("acceleration_rel", "<3f"),
+    0x03: ("angularvelocity_rel", "<3f"),
+    0x04: ("glove", "<9B"),
+    0x05: ("shoe", "<B"),
+}
+
+# Records that do not belong to the main bodypart of the node
+RECORD_BODYPART_KEYS = {"glove": "bodypart_glove", "shoe": "bodypart_shoe"}
+
+# Control frames to the node, see templates/node/BnControlFrames.h
+CONTROL_VERSION = 1
+CONTROL_MAGIC = 0xBC
+CONTROL_TYPE_ACKH = 0x01
+CONTROL_TYPE_MULTICAST = 0x02
+
+MULTICAST_GROUP = "239.192.1.99"
+MULTICAST_PORT = 12346
+MULTICAST_MESSAGE = b"BN"
+
+
+def is_binary_packet(data):
+    return len(data) >= HEADER_BYTES and data[0:2] == b"BN"
+
+
+def decode_packet(data):
+    """Decodes a binary packet into its header fields and a list of records"""
+    magic, version, flags, node_id, seq, timestamp_us = struct.unpack_from(
+        HEADER_FORMAT, data, 0
+    )
+    if magic != b"BN" or version != BINARY_VERSION:
+        raise ValueError("Not a binary packet of version " + str(BINARY_VERSION))
+
+    timestamp_key = "host_timestamp_us" if flags & FLAG_HOST_TIME else "timestamp_us"
+    records = []
+    offset = HEADER_BYTES
+    while offset < len(data):
+        record = {}
+        if flags & FLAG_TIMESTAMPED:
+            record[timestamp_key] = struct.unpack_from(TIMESTAMP_FORMAT, data, offset)[0]
+            offset += TIMESTAMP_BYTES
+        record_type = data[offset]
+        if record_type not in RECORD_TYPES:
+            raise ValueError("Unknown record type " + hex(record_type))
+        sensortype, payload_format = RECORD_TYPES[record_type]
+        values = list(struct.unpack_from(payload_format, data, offset + 1))
+        offset += 1 + struct.calcsize(payload_format)
+        record["sensortype"] = sensortype
+        record["value"] = values
+        records.append(record)
+
+    return {
+        "flags": flags,
+        "node_id": node_id,
+        "seq": seq,
+        timestamp_key: timestamp_us,
+        "records": records,
+    }
+
+
+def decode_ackn(data):
+    """Returns the node announcement that follows "ACKN\\0", None for a plain ACKN"""
+    if not data.startswith(b"ACKN\0") or len(data) < 9 or data[5:6] != b"B":
+        return None
+    version = data[6]
+    node_id = struct.unpack_from("<H", data, 7)[0]
+    names = [name.decode() for name in data[9:].split(b"\0")[:4]]
+    names += [""] * (4 - len(names))
+    return {
+        "version": version,
+        "node_id": node_id,
+        "player": names[0],
+        "bodypart": names[1],
+        "bodypart_glove": names[2],
+        "bodypart_shoe": names[3],
+    }
+
+
+def host_time_us():
+    """Host clock for the clock sync, microseconds that wrap around at 32 bits like on the nodes"""
+    return (time.monotonic_ns() // 1000) & 0xFFFFFFFF
+
+
+def decode_ackn_tail(data):
+    """Returns the fields that end the ACKN: "t0" for the clock sync and "control_version" """
+    tail = {}
+    offset = 5
+    if data[5:6] == b"B":
+        # Skips the node announcement
+        offset = 9
+        for _ in range(4):
+            end = data.find(b"\0", offset)
+            if end < 0:
+                return tail
+            offset = end + 1
+    while offset < len(data):
+        tag = data[offset:offset + 1]
+        if tag == b"T" and offset + 1 + TIMESTAMP_BYTES <= len(data):
+            tail["t0"] = data[offset + 1:offset + 1 + TIMESTAMP_BYTES]
+            offset += 1 + TIMESTAMP_BYTES
+        elif tag == b"C" and offset + 2 <= len(data):
+            tail["control_version"] = data[offset + 1]
+            offset += 2
+        else:
+            break
+    return tail
+
+
+def control_frame(frame_type, payload):
+    return struct.pack("<BBH", CONTROL_MAGIC, frame_type, len(payload)) + payload
+
+
+def ackh_reply(data, binary, received_us):
+    """Builds the ACKH for an ACKN, with the host times if the node sent its t0"""
+    tail = decode_ackn_tail(data)
+    times = b""
+    if "t0" in tail:
+        times = tail["t0"] + struct.pack("<II", received_us, host_time_us())
+    if tail.get("control_version", 0) >= CONTROL_VERSION:
+        version = BINARY_VERSION if binary else 0
+        return control_frame(CONTROL_TYPE_ACKH, bytes([version]) + times)
+    ackh = b"ACKH"
+    if binary:
+        ackh += b"B" + bytes([BINARY_VERSION])
+    if times:
+        ackh += b"T" + times
+    return ackh
+
+
+def to_json_messages(packet, announcement):
+    """Converts a decoded packet to the same messages the JSON format would carry"""
+    messages = []
+    for record in packet["records"]:
+        bodypart_key = RECORD_BODYPART_KEYS.get(record["sensortype"], "bodypart")
+        bodypart = announcement[bodypart_key]
+        value = record["value"]
+        if record["sensortype"] == "shoe":
+            value = value[0]
+        message = {
+            "player": announcement["player"],
+            "bodypart": bodypart,
+            "sensortype": record["sensortype"],
+            "value": value,
+        }
+        for timestamp_key in ("timestamp_us", "host_timestamp_us"):
+            if timestamp_key in record:
+                message[timestamp_key] = record[timestamp_key]
+        if packet["flags"] & FLAG_HISTORICAL:
+            message["historical"] = True
+        messages.append(message)
+    return messages
+
+
+def listen(port):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.bind(("", port))
+    sock.settimeout(1.0)
+    announcements = {}
+    while True:
+        try:
+            data, address = sock.recvfrom(2048)
+            received_us = host_time_us()
+        except socket.timeout:
+            # Lets the nodes find this host, all the nodes understand the bare message
+            sock.sendto(MULTICAST_MESSAGE, (MULTICAST_GROUP, MULTICAST_PORT))
+            continue
+        announcement = decode_ackn(data)
+        if announcement is not None:
+            announcements[announcement["node_id"]] = announcement
+            sock.sendto(ackh_reply(data, True, received_us), address)
+        elif data.startswith(b"ACKN"):
+            sock.sendto(ackh_reply(data, False, received_us), address)
+        elif is_binary_packet(data):
+            packet = decode_packet(data)
+            if packet["node_id"] not in announcements:
+                print("Unknown node id", packet["node_id"])
+                continue
+            packet_us = packet.get("host_timestamp_us", packet.get("timestamp_us"))
+            for message in to_json_messages(
+                packet, announcements[packet["node_id"]]
+            ):
+                print(packet["seq"], packet_us, message)
+        else:
+            print(data)
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(
+        description="Receive and decode the binary messages of Bodynodes WiFi nodes"
+    )
+    parser.add_argument(
+        "--port", type=int, default=12345, help="UDP port the nodes send to"
+    )
+    args = parser.parse_args()
+    listen(args.port)
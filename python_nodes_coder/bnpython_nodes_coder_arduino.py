@@ -34,13 +34,13 @@ import subprocess
 # Example of JSON Config file:
 # {
 #  "type" : "node",
-#  "board" : "esp-12e",                 # Possible values: "esp-12e", "arduino_nano_33", "redbear_duo", "mpnrf52840", "esp32c3-supermini"
-#  "fqbn" : "xxxx",                     #
-#  "node_communicator": "wifi",         # Possible values: "wifi", "ble"
+#  "board" : "esp-12e",                 # Possible values: "esp-12e", "arduino_nano_33", "redbear_duo", "mpnrf52840", "esp32c3-supermini", "host"
+#  "fqbn" : "xxxx",                     # Use "host" with the "host" board
+#  "node_communicator": "wifi",         # Possible values: "wifi", "ble" ("wifi" only for the "host" board)
 #  "actuators": {
 #      "haptic": "no"                   # Possible values: "no", "yes"
 #  },
-#  "isensors": "mpu6050",               # Possible values: "no", "bno055", "arduino_lsm9ds1", "mpu6050"
+#  "isensors": "mpu6050",               # Possible values: "no", "bno055", "arduino_lsm9ds1", "mpu6050", "host"
 #  "esensors": {
 #    "acceleration_rel" : "no",         # Possible values: "no", "yes"
 #    "angularvelocity_rel" : "no",      # Possible values: "no", "yes"
@@ -95,6 +95,17 @@ def main_node(project_path, config_json):
     files_to_take.append(template_type_folder + "BnDatatypes.h")
     files_to_take.append(template_type_folder + "BnArduinoUtils.cpp")
     files_to_take.append(template_type_folder + "BnArduinoUtils.h")
+    files_to_take.append(template_type_folder + "BnBinaryMessages.cpp")
+    files_to_take.append(template_type_folder + "BnBinaryMessages.h")
+    files_to_take.append(template_type_folder + "BnProfiler.cpp")
+    files_to_take.append(template_type_folder + "BnProfiler.h")
+    files_to_take.append(template_type_folder + "BnChangeDetector.cpp")
+    files_to_take.append(template_type_folder + "BnChangeDetector.h")
+    files_to_take.append(template_type_folder + "BnClockSync.cpp")
+    files_to_take.append(template_type_folder + "BnClockSync.h")
+    files_to_take.append(template_type_folder + "BnControlFrames.cpp")
+    files_to_take.append(template_type_folder + "BnControlFrames.h")
+    files_to_take.append(template_type_folder + "BnRingBuffer.h")
     files_to_take.append(template_type_folder + "bodynode.ino")
 
     # Actuators files
@@ -106,14 +117,21 @@ def main_node(project_path, config_json):
     # Internal Sensors files
     template_node_isensors_folder = "templates/isensors/"
     files_to_take.append(template_node_isensors_folder + "BnISensor.h")
+    files_to_take.append(template_node_isensors_folder + "BnISensorHub.cpp")
+    files_to_take.append(template_node_isensors_folder + "BnISensorHub.h")
     if config_json["isensor"] == "bno055":
         files_to_take.append(template_node_isensors_folder + "BnISensorBNO055.cpp")
     elif config_json["isensor"] == "arduino_lsm9ds1":
         files_to_take.append(
             template_node_isensors_folder + "BnISensorArduinoLSM9DS1.cpp"
         )
+        files_to_take.append(
+            template_node_isensors_folder + "BnISensorArduinoLSM9DS1.h"
+        )
     elif config_json["isensor"] == "mpu6050":
         files_to_take.append(template_node_isensors_folder + "BnISensorMPU6050.cpp")
+    elif config_json["isensor"] == "host":
+        files_to_take.append(template_node_isensors_folder + "BnISensorHost.cpp")
 
     # External Sensors files
     template_node_esensors_folder = "templates/esensors/"
@@ -127,6 +145,8 @@ def main_node(project_path, config_json):
         files_to_take.append(
             template_node_esensors_folder + "BnOrientationAbsSensorFusion.cpp"
         )
+        files_to_take.append(template_node_esensors_folder + "BnSensorFusion.h")
+        files_to_take.append(template_node_esensors_folder + "BnSensorFusion.cpp")
 
     if config_json["esensors"]["acceleration_rel"] == "yes":
         files_to_take.append(
@@ -193,6 +213,32 @@ def main_node(project_path, config_json):
         print("Invalid 'board' = " + config_json["board"])
         return
 
+    # Host shims of the Arduino libraries, to build and run the node on a PC
+    if config_json["board"] == "host":
+        template_host_folder = "templates/host/"
+        files_to_take.append(template_host_folder + "Arduino.h")
+        files_to_take.append(template_host_folder + "WString.h")
+        files_to_take.append(template_host_folder + "Print.h")
+        files_to_take.append(template_host_folder + "Stream.h")
+        files_to_take.append(template_host_folder + "WiFi.h")
+        files_to_take.append(template_host_folder + "WiFiUdp.h")
+        files_to_take.append(template_host_folder + "EEPROM.h")
+        files_to_take.append(template_host_folder + "BnHostArduino.cpp")
+        files_to_take.append(template_host_folder + "BnHostMain.cpp")
+        files_to_take.append(template_host_folder + "Makefile")
+        # Programs of "make test" and "make bench"
+        files_to_take.append(template_host_folder + "BnHostTest.h")
+        files_to_take.append(template_host_folder + "BnHostTestChangeDetector.cpp")
+        files_to_take.append(template_host_folder + "BnHostTestPersMemory.cpp")
+        if config_json["esensors"]["orientation_abs"] == "fusion":
+            files_to_take.append(template_host_folder + "BnHostTestSensorFusion.cpp")
+            files_to_take.append(template_host_folder + "BnHostTestFusionTimeStep.cpp")
+            files_to_take.append(template_host_folder + "BnHostTestMagnAxes.cpp")
+            files_to_take.append(
+                template_node_isensors_folder + "BnISensorArduinoLSM9DS1.h"
+            )
+            files_to_take.append(template_host_folder + "BnHostBenchSensorFusion.cpp")
+
     for file_to_take in files_to_take:
         file_name = os.path.basename(file_to_take)
         is_bodynodeino = False
@@ -561,6 +607,23 @@ def generate_all_configs():
     ]
     all_configs.extend(create_combo(flat_keys, value_lists))
 
+    ####### host
+
+    value_lists = [
+        ["node"],  # type
+        ["host"],  # board
+        ["host"],  # fqbn
+        ["wifi"],  # node_communicator
+        ["yes"],  # actuators->haptic
+        ["host"],  # isensors
+        ["yes"],  # esensors->acceleration_rel
+        ["yes"],  # esensors->angularvelocity_rel
+        ["onboard", "fusion"],  # esensors->orientation_abs
+        ["onboard", "serial"],  # esensors->glove
+        ["onboard"],  # esensors->shoe
+    ]
+    all_configs.extend(create_combo(flat_keys, value_lists))
+
     return all_configs
 
 
@@ -603,6 +666,9 @@ def compile_arduino_cli(test_dir, config_json):
 
     # arduino-cli compile  --fqbn  RedBear:STM32F2:RedBear_Duo_native --build-path ./build
     command = f"arduino-cli compile --fqbn {config_json["fqbn"]} --build-path ./build"
+    if config_json["board"] == "host":
+        # The host board builds with its own Makefile
+        command = "make all test"
 
     # run() waits for the command to finish
     try:
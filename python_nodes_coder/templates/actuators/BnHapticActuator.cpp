@@ -34,7 +34,7 @@ void BnHapticActuator::init(){
 }
 
 void BnHapticActuator::setAction(BnAction &action){
-    if(action["type"] == BN_ACTION_TYPE_HAPTIC_TAG){
+    if(BnActionType_fromTag(action[BN_ACTION_TYPE_TAG].as<const char*>()) == getType()){
         uint16_t duration_ms = action["duration_ms"];
         uint16_t strength = action["strength"];
         DEBUG_PRINT("Haptic triggered with duration and strenght = ");
@@ -55,9 +55,9 @@ void BnHapticActuator::performAction(){
     }
 }
 
-BnType BnHapticActuator::getType(){
+BnActionType BnHapticActuator::getType(){
     // It is well known for this Bodynode
-    return BN_ACTION_TYPE_HAPTIC_TAG;
+    return BN_ACTION_TYPE_HAPTIC;
 }
 
 #endif // __BN_HAPTIC_ACTUATOR_H__
\ No newline at end of file
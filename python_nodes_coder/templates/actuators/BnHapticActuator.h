@@ -42,7 +42,7 @@ public:
     void init();
     void setAction(BnAction &action);
     void performAction();
-    BnType getType();
+    BnActionType getType();
 
 private:
     BnVibration_struct a_vibration;
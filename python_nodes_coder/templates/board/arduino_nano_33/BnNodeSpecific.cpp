@@ -41,12 +41,19 @@ typedef struct {
 
 static NanoBLEFlashPrefs sFlashPrefs;
 static Memory_t sBlock;
+// The flash is written once per commit, only if something changed
+static bool sBlockChanged = false;
 
 void persMemoryInit() {
     sFlashPrefs.readPrefs(&sBlock, sizeof(sBlock));
 }
 
 void persMemoryCommit() {
+    if (!sBlockChanged) {
+        return;
+    }
+    sFlashPrefs.writePrefs(&sBlock, sizeof(sBlock));
+    sBlockChanged = false;
 }
 
 void persMemoryRead(uint16_t address_, uint8_t *out_byte ) {
@@ -54,8 +61,18 @@ void persMemoryRead(uint16_t address_, uint8_t *out_byte ) {
 }
 
 void persMemoryWrite(uint16_t address_, uint8_t in_byte ) {
-    sBlock.memory[address_] = in_byte;
-    sFlashPrefs.writePrefs(&sBlock, sizeof(sBlock));
+    if (sBlock.memory[address_] != in_byte) {
+        sBlock.memory[address_] = in_byte;
+        sBlockChanged = true;
+    }
+}
+
+extern "C" char* sbrk(int incr);
+
+uint32_t getFreeHeapBytes() {
+    // Space left between the top of the heap and the stack
+    char stack_top;
+    return &stack_top - sbrk(0);
 }
 
 void BnHapticActuator_init() {
@@ -70,55 +87,10 @@ void BnHapticActuator_turnOFF() {
     // Not implemeted    
 }
 
-static void convertStringArrayToFloatBytes(char const *message_str, uint8_t slength, uint8_t *bytes_message, uint8_t num_floats) {
-
-    char message_tmp[slength-1];
-    memcpy(message_tmp, message_str+1, slength-1); // removing the [ and ] at the beginning and the end
-    message_tmp[slength-2] = '\0';
-    DEBUG_PRINT("convertStringArrayToFloatBytes message_tmp = ");
-    DEBUG_PRINTLN(message_tmp);
-
-    float fl_array[num_floats];
-    int idl = 0;
-    char* token = strtok(message_tmp, ", ");
-    while (token != NULL && idl < num_floats) {
-        fl_array[idl] = atof(token);  // Convert the token to float
-        token = strtok(NULL, ", "); // Move to the next token
-        ++idl;
-    }
-
-    // BIG ENDIAN CONVERION
-    float_converter fc;
-    for( uint8_t idf = 0; idf < num_floats; ++idf ){
-        fc.number = fl_array[idf];
-        bytes_message[0 + 4*idf] = fc.bytes[3];
-        bytes_message[1 + 4*idf] = fc.bytes[2];
-        bytes_message[2 + 4*idf] = fc.bytes[1];
-        bytes_message[3 + 4*idf] = fc.bytes[0]; 
-    }
-}
-
-
-static void convertStringArrayToUInt8Bytes(char const *message_str, uint8_t slength, uint8_t *bytes_message, uint8_t num_uints) {
-
-    char message_tmp[slength-1];
-    memcpy(message_tmp, message_str+1, slength-1); // removing the [ and ] at the beginning and the end
-    message_tmp[slength-2] = '\0';
-    DEBUG_PRINT("convertStringArrayToFloatBytes message_tmp = ");
-    DEBUG_PRINTLN(message_tmp);
-
-    int idl = 0;
-    char* token = strtok(message_tmp, ", ");
-    while (token != NULL && idl < num_uints) {
-        bytes_message[idl] = (uint8_t)atoi(token);  // Convert the token to int and then to uint8_t
-        token = strtok(NULL, ", "); // Move to the next token
-        ++idl;
-    }
-}
-
 #ifdef BLE_COMMUNICATION
 
 #include <ArduinoBLE.h>
+#include "BnBLENodeCommunicator.h"
 
 #define CHARA_MAX_LENGTH 20
 
@@ -131,11 +103,13 @@ static BLECharacteristic sOrientationAbsChara(BN_BLE_CHARA_ORIENTATION_ABS_VALUE
 static BLECharacteristic sAccelerationRelChara(BN_BLE_CHARA_ACCELERATION_REL_VALUE_UUID, BLENotify, CHARA_MAX_LENGTH);
 static BLECharacteristic sGloveChara(BN_BLE_CHARA_GLOVE_VALUE_UUID, BLENotify, CHARA_MAX_LENGTH);
 static BLECharacteristic sShoeChara(BN_BLE_CHARA_SHOE_UUID, BLENotify, CHARA_MAX_LENGTH);
+static BLECharacteristic sStatsChara(BN_BLE_CHARA_STATS_UUID, BLENotify, CHARA_MAX_LENGTH);
+static BLECharacteristic sControlChara(BN_BLE_CHARA_CONTROL_UUID, BLEWrite | BLEWriteWithoutResponse, BN_BLE_CONTROL_MAX_BYTES);
 
-// This boolean just forces the Player and Bodypart to be set once
-// This is by specifications. The reason is that BLE communication is quite unique in nature and it is just
-// more complex to handle changing parts
-static bool sPlayerBodypartSet = false;
+// Called from BLE.poll() when the central writes the control characteristic
+static void controlWritten(BLEDevice central, BLECharacteristic characteristic) {
+    BnBLENodeCommunicator_onControlWrite(characteristic.value(), characteristic.valueLength());
+}
 
 void BnBLENodeCommunicator_init(){
 
@@ -162,13 +136,20 @@ void BnBLENodeCommunicator_init(){
 #ifdef SHOE_SENSOR_ON_BOARD
     sBodynodesService.addCharacteristic(sShoeChara);
 #endif /*SHOE_SENSOR_ON_BOARD*/
+
+    sBodynodesService.addCharacteristic(sStatsChara);
+
+    sControlChara.setEventHandler(BLEWritten, controlWritten);
+    sBodynodesService.addCharacteristic(sControlChara);
     
     // Add the service
     BLE.addService(sBodynodesService);
     
+    // The central decides, this is only a request
+    BLE.setConnectionInterval(BN_BLE_CONN_INTERVAL_MIN, BN_BLE_CONN_INTERVAL_MAX);
+
     // Start advertising
     BLE.advertise();
-    sPlayerBodypartSet = false;
     DEBUG_PRINTLN("BLE service started and advertising.");
 }
 
@@ -188,46 +169,43 @@ uint8_t BnBLENodeCommunicator_checkAllOk( uint8_t current_conn_status ){
     }
 }
 
-void BnBLENodeCommunicator_sendAllMessages(JsonArray &bnc_messages_list){
-    if(bnc_messages_list.size() == 0) {
-        //DEBUG_PRINTLN("No messages to send");
-        return;
-    }
-    for (JsonObject message_json : bnc_messages_list) {
-        if(!sPlayerBodypartSet) {
-            sPlayerChara.setValue(message_json[BN_MESSAGE_PLAYER_TAG].as<String>().c_str());
-            sBodypartChara.setValue(message_json[BN_MESSAGE_BODYPART_TAG].as<String>().c_str());
-            sPlayerBodypartSet = true;
-        }
-        String sensortype_str = message_json[BN_MESSAGE_SENSORTYPE_TAG].as<String>();
-        String value_str = message_json[BN_MESSAGE_VALUE_TAG].as<String>();
-
-        DEBUG_PRINT("message = ");
-        String output;
-        serializeJson(message_json, output);
-        DEBUG_PRINTLN(output);
-        
-        if(sensortype_str == BN_SENSORTYPE_ORIENTATION_ABS_TAG) {
-            uint8_t bytes_message[16];
-            convertStringArrayToFloatBytes(value_str.c_str(), value_str.length(), bytes_message, 4);
-            sOrientationAbsChara.setValue(bytes_message, 16);
-        } else if(sensortype_str == BN_SENSORTYPE_ACCELERATION_REL_TAG) {
-            uint8_t bytes_message[12];
-            convertStringArrayToFloatBytes(value_str.c_str(), value_str.length(), bytes_message, 3);
-            sAccelerationRelChara.setValue(bytes_message, 12);
-        } else if(sensortype_str == BN_SENSORTYPE_GLOVE_TAG) {
-            uint8_t bytes_message[9];
-            convertStringArrayToUInt8Bytes(value_str.c_str(), value_str.length(), bytes_message, 9);
-            sGloveChara.setValue(bytes_message, 9);
-        } else if(sensortype_str == BN_SENSORTYPE_SHOE_TAG) {
-            //TODO sShoeChara.setValue(message_json[MESSAGE_VALUE_TAG].as<String>().c_str());
-        } 
-    }
-    uint8_t num_messages = bnc_messages_list.size();
-    for (uint8_t index = 0; index<num_messages; ++index) {
-        bnc_messages_list.remove(0);
+void BnBLENodeCommunicator_setNames(const String &player, const String &bodypart){
+    sPlayerChara.setValue(player.c_str());
+    sBodypartChara.setValue(bodypart.c_str());
+}
+
+void BnBLENodeCommunicator_sendRecord(uint8_t record_type, const uint8_t bytes[], uint8_t length){
+    switch(record_type){
+        case BN_BINARY_RECORD_ORIENTATION_ABS:
+            sOrientationAbsChara.setValue(bytes, length);
+            break;
+        case BN_BINARY_RECORD_ACCELERATION_REL:
+            sAccelerationRelChara.setValue(bytes, length);
+            break;
+        case BN_BINARY_RECORD_GLOVE:
+            sGloveChara.setValue(bytes, length);
+            break;
+        case BN_BINARY_RECORD_SHOE:
+            sShoeChara.setValue(bytes, length);
+            break;
     }
+}
+
+uint16_t BnBLENodeCommunicator_streamCapacity(){
+    // No stream characteristic on this board, the readings go to the sensor characteristics
+    return 0;
+}
+
+void BnBLENodeCommunicator_sendStream(const uint8_t bytes[], uint16_t length){
+}
+
+uint16_t BnBLENodeCommunicator_statsCapacity(){
+    // Notifications of the default MTU, the ones the library always negotiates
+    return sStatsChara.subscribed() ? CHARA_MAX_LENGTH : 0;
+}
 
+void BnBLENodeCommunicator_sendStats(const uint8_t bytes[], uint16_t length){
+    sStatsChara.setValue(bytes, length);
 }
 
 #endif
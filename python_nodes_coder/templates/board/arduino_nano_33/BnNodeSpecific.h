@@ -102,6 +102,9 @@
 
 #define MAX_BUFF_LENGTH 100
 
+// Uncomment to measure the time spent in each stage of the loop, see BnProfiler.h
+//#define BN_PROFILE
+
 #define DEBUG_M
 #ifdef DEBUG_M
  #define DEBUG_PRINT(x)  Serial.print (x)
@@ -187,6 +190,8 @@ void persMemoryInit();
 void persMemoryCommit();
 void persMemoryRead(uint16_t address_, uint8_t *out_byte );
 void persMemoryWrite(uint16_t address_, uint8_t in_byte );
+// Free heap in bytes, to debug the memory usage
+uint32_t getFreeHeapBytes();
 void BnHapticActuator_init();
 void BnHapticActuator_turnON(uint8_t strength);
 void BnHapticActuator_turnOFF();
@@ -215,7 +220,14 @@ typedef union
 
 void BnBLENodeCommunicator_init();
 uint8_t BnBLENodeCommunicator_checkAllOk( uint8_t current_conn_status );
-void BnBLENodeCommunicator_sendAllMessages(JsonArray &bnc_messages_list);
+void BnBLENodeCommunicator_setNames(const String &player, const String &bodypart);
+void BnBLENodeCommunicator_sendRecord(uint8_t record_type, const uint8_t bytes[], uint8_t length);
+// Bytes that fit in a notification of the stream characteristic, 0 when no central is subscribed to it
+uint16_t BnBLENodeCommunicator_streamCapacity();
+void BnBLENodeCommunicator_sendStream(const uint8_t bytes[], uint16_t length);
+// Bytes that fit in a notification of the stats characteristic, 0 when no central is subscribed to it
+uint16_t BnBLENodeCommunicator_statsCapacity();
+void BnBLENodeCommunicator_sendStats(const uint8_t bytes[], uint16_t length);
 
 #endif // BLE_COMMUNICATION
 
@@ -28,7 +28,11 @@
 // Sensortypes: XXXX
 // Board: XXXX
 
-bool tryConnectWifi(String ssid, String password){
+bool beginConnectWifi(String ssid, String password){
+
+}
+
+uint8_t pollConnectWifi(){
 
 }
 
@@ -55,3 +59,7 @@ void persMemoryRead(uint16_t address_, uint8_t *out_byte ) {
 void persMemoryWrite(uint16_t address_, uint8_t in_byte ) {
 
 }
+
+uint32_t getFreeHeapBytes() {
+    return 0;
+}
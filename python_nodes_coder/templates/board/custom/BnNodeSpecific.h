@@ -106,6 +106,9 @@ XXXXXX
 
 #define MAX_BUFF_LENGTH 100
 
+// Uncomment to measure the time spent in each stage of the loop, see BnProfiler.h
+//#define BN_PROFILE
+
 #define DEBUG_M
 #ifdef DEBUG_M
  #define DEBUG_PRINT(x)  Serial.print (x)
@@ -181,6 +184,8 @@ void persMemoryInit();
 void persMemoryCommit();
 void persMemoryRead(uint16_t address_, uint8_t *out_byte );
 void persMemoryWrite(uint16_t address_, uint8_t in_byte );
+// Free heap in bytes, to debug the memory usage
+uint32_t getFreeHeapBytes();
 
 void BnHapticActuator_init();
 void BnHapticActuator_turnON(uint8_t strength);
@@ -210,7 +215,14 @@ typedef union
 
 void BnBLENodeCommunicator_init();
 uint8_t BnBLENodeCommunicator_checkAllOk( uint8_t current_conn_status );
-void BnBLENodeCommunicator_sendAllMessages(JsonArray &bnc_messages_list);
+void BnBLENodeCommunicator_setNames(const String &player, const String &bodypart);
+void BnBLENodeCommunicator_sendRecord(uint8_t record_type, const uint8_t bytes[], uint8_t length);
+// Bytes that fit in a notification of the stream characteristic, 0 when no central is subscribed to it
+uint16_t BnBLENodeCommunicator_streamCapacity();
+void BnBLENodeCommunicator_sendStream(const uint8_t bytes[], uint16_t length);
+// Bytes that fit in a notification of the stats characteristic, 0 when no central is subscribed to it
+uint16_t BnBLENodeCommunicator_statsCapacity();
+void BnBLENodeCommunicator_sendStats(const uint8_t bytes[], uint16_t length);
 
 #endif // BLE_COMMUNICATION
 
@@ -220,13 +232,21 @@ void BnBLENodeCommunicator_sendAllMessages(JsonArray &bnc_messages_list);
 #define BN_NODE_SPECIFIC_BN_WIFI_NODE_COMMUNICATOR_HMI_LED_ON do{ digitalWrite(STATUS_CONNECTION_HMI_LED_P, LED_DT_ON); }while(0)
 #define BN_NODE_SPECIFIC_BN_WIFI_NODE_COMMUNICATOR_HMI_LED_OFF do{ digitalWrite(STATUS_CONNECTION_HMI_LED_P, 0); }while(0)
 
-bool tryConnectWifi(String ssid, String password);
+#define BN_WIFI_CONNECTING     0
+#define BN_WIFI_CONNECTED      1
+#define BN_WIFI_CONNECT_FAILED 2
+
+// Starts connecting to the network and returns at once, false when an attempt cannot start yet
+bool beginConnectWifi(String ssid, String password);
+// Returns one of the BN_WIFI_CONNECT* values, to be called until it is not BN_WIFI_CONNECTING anymore
+uint8_t pollConnectWifi();
 void printWifiStatus();
 IPAddress getIPAdressFromStr(String ip_address_str);
 
 #define BN_NODE_SPECIFIC_BN_WIFI_NODE_COMMUNICATOR_INIT_WIFI                  XXXXX
 #define BN_NODE_SPECIFIC_BN_WIFI_NODE_COMMUNICATOR_WRITE_STATUS_PIN_FUNCTION  XXXXX
 #define BN_NODE_SPECIFIC_BN_WIFI_NODE_COMMUNICATOR_UDP_OBJ                    XXXXX
+#define BN_NODE_SPECIFIC_BN_WIFI_NODE_COMMUNICATOR_RSSI                       XXXXX
 #define BN_NODE_SPECIFIC_BN_WIFI_NODE_COMMUNICATOR_BEGIN_MULTICAST            XXXXX
 
 #endif
@@ -113,6 +113,9 @@ extern "C" {
 
 #define MAX_BUFF_LENGTH 100
 
+// Uncomment to measure the time spent in each stage of the loop, see BnProfiler.h
+//#define BN_PROFILE
+
 #define DEBUG_M
 #ifdef DEBUG_M
  #define DEBUG_PRINT(x)  Serial.print (x)
@@ -195,6 +198,8 @@ void persMemoryInit();
 void persMemoryCommit();
 void persMemoryRead(uint16_t address_, uint8_t *out_byte );
 void persMemoryWrite(uint16_t address_, uint8_t in_byte );
+// Free heap in bytes, to debug the memory usage
+uint32_t getFreeHeapBytes();
 void BnHapticActuator_init();
 void BnHapticActuator_turnON(uint8_t strength);
 void BnHapticActuator_turnOFF();
@@ -208,7 +213,14 @@ void BnHapticActuator_turnOFF();
 
 void BnBLENodeCommunicator_init();
 uint8_t BnBLENodeCommunicator_checkAllOk( uint8_t current_conn_status );
-void BnBLENodeCommunicator_sendAllMessages(JsonArray &bnc_messages_list);
+void BnBLENodeCommunicator_setNames(const String &player, const String &bodypart);
+void BnBLENodeCommunicator_sendRecord(uint8_t record_type, const uint8_t bytes[], uint8_t length);
+// Bytes that fit in a notification of the stream characteristic, 0 when no central is subscribed to it
+uint16_t BnBLENodeCommunicator_streamCapacity();
+void BnBLENodeCommunicator_sendStream(const uint8_t bytes[], uint16_t length);
+// Bytes that fit in a notification of the stats characteristic, 0 when no central is subscribed to it
+uint16_t BnBLENodeCommunicator_statsCapacity();
+void BnBLENodeCommunicator_sendStats(const uint8_t bytes[], uint16_t length);
 
 #endif // BLE_COMMUNICATION
 
@@ -218,7 +230,14 @@ void BnBLENodeCommunicator_sendAllMessages(JsonArray &bnc_messages_list);
 #define BN_NODE_SPECIFIC_BN_WIFI_NODE_COMMUNICATOR_HMI_LED_ON do{ digitalWrite(STATUS_CONNECTION_HMI_LED_P, LED_DT_ON); }while(0)
 #define BN_NODE_SPECIFIC_BN_WIFI_NODE_COMMUNICATOR_HMI_LED_OFF do{ digitalWrite(STATUS_CONNECTION_HMI_LED_P, 0); }while(0)
 
-bool tryConnectWifi(String ssid, String password);
+#define BN_WIFI_CONNECTING     0
+#define BN_WIFI_CONNECTED      1
+#define BN_WIFI_CONNECT_FAILED 2
+
+// Starts connecting to the network and returns at once, false when an attempt cannot start yet
+bool beginConnectWifi(String ssid, String password);
+// Returns one of the BN_WIFI_CONNECT* values, to be called until it is not BN_WIFI_CONNECTING anymore
+uint8_t pollConnectWifi();
 void printWifiStatus();
 IPAddress getIPAdressFromStr(String ip_address_str);
 
@@ -226,6 +245,7 @@ IPAddress getIPAdressFromStr(String ip_address_str);
   WiFi.disconnect(true);                                     \
   WiFi.softAPdisconnect(false);                              \
   WiFi.enableAP(false);
+#define BN_NODE_SPECIFIC_BN_WIFI_NODE_COMMUNICATOR_RSSI WiFi.RSSI()
 #define BN_NODE_SPECIFIC_BN_WIFI_NODE_COMMUNICATOR_UDP_OBJ WiFiUDP
 #define BN_NODE_SPECIFIC_BN_WIFI_NODE_COMMUNICATOR_BEGIN_MULTICAST wnc_multicast_connector.beginMulticast(WiFi.localIP(), multicastIP, BN_WIFI_MULTICAST_PORT); // Listen to the Multicast
 
@@ -30,51 +30,60 @@
 
 #ifdef WIFI_COMMUNICATION
 
-bool tryConnectWifi(String ssid, String password){
+static void printWifiScan(){
+    int found = WiFi.scanComplete();
+    if(found < 0) {
+        return;
+    }
+    for (int i=0; i<found; i++) {
+        DEBUG_PRINT("SSID: ");
+        DEBUG_PRINT(WiFi.SSID(i));
+        DEBUG_PRINT(" | Security: ");
+        DEBUG_PRINT(WiFi.encryptionType(i) == WIFI_AUTH_OPEN ? "open" : "something");
+        DEBUG_PRINT(" | Channel: ");
+        DEBUG_PRINT(WiFi.channel(i));
+        DEBUG_PRINT(" | RSSI: ");
+        DEBUG_PRINTLN(WiFi.RSSI(i));
+    }
+    WiFi.scanDelete();
+}
+
+bool beginConnectWifi(String ssid, String password){
     if(WiFi.status() == WL_CONNECTED) {
         return true;
     }
-    
+    // The radio cannot join a network while it is scanning
+    if(WiFi.scanComplete() == WIFI_SCAN_RUNNING) {
+        return false;
+    }
+    printWifiScan();
+
     // attempt to connect to Wifi network:
     DEBUG_PRINT("Attempting to connect to Network named: ");
     // print the network name (SSID);
     DEBUG_PRINTLN(ssid);
+    WiFi.persistent(false);
+    WiFi.mode(WIFI_STA);
     WiFi.begin(ssid, password);
-  
-    while (WiFi.status() != WL_CONNECTED && WiFi.status() != WL_CONNECT_FAILED) {
-        // print dots while we wait to connect
-        DEBUG_PRINT(".");
-        delay(500);
-    }
-    bool conn = WiFi.status() == WL_CONNECTED;
-  
-    if(conn){
-        DEBUG_PRINTLN("Waiting for an IP address");
-        IPAddress localIP = WiFi.localIP();
-        while (localIP[0] == 0) {
-          localIP = WiFi.localIP();
-          DEBUG_PRINTLN("Waiting for an IP address");
-          delay(1000);
+    return true;
+}
+
+uint8_t pollConnectWifi(){
+    int status = WiFi.status();
+    if(status == WL_CONNECTED) {
+        // Connected but still waiting for an IP address
+        if(WiFi.localIP()[0] == 0) {
+            return BN_WIFI_CONNECTING;
         }
-        DEBUG_PRINTLN("IP Address obtained");
-        return true;
-    } else {
-          WiFi.mode(WIFI_STA);
-          WiFi.disconnect();
-          delay(1000);
-          int found = WiFi.scanNetworks();
-          for (int i=0; i<found; i++) {
-              DEBUG_PRINT("SSID: ");
-              DEBUG_PRINT(WiFi.SSID(i));
-              DEBUG_PRINT(" | Security: ");
-              DEBUG_PRINT(WiFi.encryptionType(i) == WIFI_AUTH_OPEN ? "open" : "something");
-              DEBUG_PRINT(" | Channel: ");
-              DEBUG_PRINT(WiFi.channel(i));
-              DEBUG_PRINT(" | RSSI: ");
-              DEBUG_PRINTLN(WiFi.RSSI(i));
-          }
-          return false;
+        return BN_WIFI_CONNECTED;
     }
+    if(status == WL_CONNECT_FAILED || status == WL_NO_SSID_AVAIL) {
+        // Look for the networks around in background, they are printed on the next attempt
+        WiFi.disconnect();
+        WiFi.scanNetworks(true);
+        return BN_WIFI_CONNECT_FAILED;
+    }
+    return BN_WIFI_CONNECTING;
 }
 
 void printWifiStatus() {
@@ -123,6 +132,10 @@ void persMemoryWrite(uint16_t address_, uint8_t in_byte ) {
     EEPROM.write(address_, in_byte);
 }
 
+uint32_t getFreeHeapBytes() {
+    return ESP.getFreeHeap();
+}
+
 void BnHapticActuator_init() {
     pinMode(HAPTIC_MOTOR_PIN_P, OUTPUT);
 }
@@ -0,0 +1,112 @@
+/**
+* MIT License
+*
+* Copyright (c) 2026 Manuel Bottini
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "BnNodeSpecific.h"
+
+// Implements Specification Version Dev 1.0
+// Sensortypes: orientation_abs, acceleration_rel, glove
+// Board: Host (Linux PC)
+
+#ifdef WIFI_COMMUNICATION
+
+bool beginConnectWifi(String ssid, String password){
+    if(WiFi.status() == WL_CONNECTED) {
+        return true;
+    }
+
+    // The PC is already on a network, the connection is immediate
+    DEBUG_PRINT("Attempting to connect to Network named: ");
+    DEBUG_PRINTLN(ssid);
+    WiFi.begin(ssid, password);
+    return true;
+}
+
+uint8_t pollConnectWifi(){
+    if(WiFi.status() == WL_CONNECTED) {
+        return BN_WIFI_CONNECTED;
+    }
+    return BN_WIFI_CONNECT_FAILED;
+}
+
+void printWifiStatus() {
+    // print the SSID of the network you're attached to:
+    DEBUG_PRINT("Network Name: ");
+    DEBUG_PRINTLN(WiFi.SSID());
+  
+    // print your WiFi shield's IP address:
+    IPAddress ip = WiFi.localIP();
+    DEBUG_PRINT("IP Address: ");
+    DEBUG_PRINTLN(ip);
+  
+    DEBUG_PRINT("Gateway IP address for network ");
+    DEBUG_PRINTLN(WiFi.gatewayIP());
+  
+    // print the received signal strength:
+    long rssi = WiFi.RSSI();
+    DEBUG_PRINT("signal strength (RSSI):");
+    DEBUG_PRINT(rssi);
+    DEBUG_PRINTLN(" dBm");
+}
+
+IPAddress getIPAdressFromStr(String ip_address_str) {
+    IPAddress ipAddress;
+    ipAddress.fromString(ip_address_str);
+    return ipAddress;
+}
+
+#endif // WIFI_COMMUNICATION
+
+void persMemoryInit() {
+    EEPROM.begin(512);
+}
+
+void persMemoryCommit() {
+    EEPROM.commit();
+}
+
+void persMemoryRead(uint16_t address_, uint8_t *out_byte ) {
+    *out_byte = EEPROM.read(address_);
+}
+
+void persMemoryWrite(uint16_t address_, uint8_t in_byte ) {
+    EEPROM.write(address_, in_byte);
+}
+
+uint32_t getFreeHeapBytes() {
+    // There is no fixed size heap on the host
+    return 0;
+}
+
+void BnHapticActuator_init() {
+    pinMode(HAPTIC_MOTOR_PIN_P, OUTPUT);
+}
+
+void BnHapticActuator_turnON(uint8_t strength) {
+    (void) strength;
+    digitalWrite(HAPTIC_MOTOR_PIN_P, HIGH);
+}
+
+void BnHapticActuator_turnOFF() {
+    digitalWrite(HAPTIC_MOTOR_PIN_P, LOW);
+}
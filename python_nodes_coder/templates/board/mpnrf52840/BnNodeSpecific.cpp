@@ -36,6 +36,8 @@ typedef struct {
 } Memory_t;
 
 static Memory_t sBlock;
+// The file is written once per commit, only if something changed
+static bool sBlockChanged = false;
 
 void persMemoryInit() {
     if (!InternalFS.begin()) {
@@ -54,6 +56,21 @@ void persMemoryInit() {
 }
 
 void persMemoryCommit() {
+    if (!sBlockChanged) {
+        return;
+    }
+    // FILE_O_WRITE opens at the end, the block is written over the old one from the start.
+    // LittleFS makes the new content valid at the close, a reset before it keeps the old file
+    Adafruit_LittleFS_Namespace::File file = InternalFS.open("/prefs.bin", Adafruit_LittleFS_Namespace::FILE_O_WRITE);
+    if (!file) {
+        DEBUG_PRINTLN("Failed to open file for writing");
+        return;
+    }
+
+    file.seek(0);
+    file.write((uint8_t *)&sBlock, sizeof(sBlock));
+    file.close();
+    sBlockChanged = false;
 }
 
 void persMemoryRead(uint16_t address_, uint8_t *out_byte ) {
@@ -65,22 +82,24 @@ void persMemoryRead(uint16_t address_, uint8_t *out_byte ) {
 }
 
 void persMemoryWrite(uint16_t address_, uint8_t in_byte ) {
-if (address_ < sizeof(sBlock.memory)) {
-        sBlock.memory[address_] = in_byte;
-        
-        Adafruit_LittleFS_Namespace::File file = InternalFS.open("/prefs.bin", Adafruit_LittleFS_Namespace::FILE_O_WRITE);
-        if (!file) {
-            DEBUG_PRINTLN("Failed to open file for writing");
-            return;
+    if (address_ < sizeof(sBlock.memory)) {
+        if (sBlock.memory[address_] != in_byte) {
+            sBlock.memory[address_] = in_byte;
+            sBlockChanged = true;
         }
-
-        file.write((uint8_t *)&sBlock, sizeof(sBlock));
-        file.close();
     } else {
         DEBUG_PRINTLN("Address out of bounds");
     }
 }
 
+extern "C" char* sbrk(int incr);
+
+uint32_t getFreeHeapBytes() {
+    // Space left between the top of the heap and the stack
+    char stack_top;
+    return &stack_top - sbrk(0);
+}
+
 void BnHapticActuator_init() {
     // Not implemeted
 }
@@ -93,52 +112,6 @@ void BnHapticActuator_turnOFF() {
     // Not implemeted    
 }
 
-static void convertStringArrayToFloatBytes(char const *message_str, uint8_t slength, uint8_t *bytes_message, uint8_t num_floats) {
-
-    char message_tmp[slength-1];
-    memcpy(message_tmp, message_str+1, slength-1); // removing the [ and ] at the beginning and the end
-    message_tmp[slength-2] = '\0';
-    DEBUG_PRINT("convertStringArrayToFloatBytes message_tmp = ");
-    DEBUG_PRINTLN(message_tmp);
-
-    float fl_array[num_floats];
-    int idl = 0;
-    char* token = strtok(message_tmp, ", ");
-    while (token != NULL && idl < num_floats) {
-        fl_array[idl] = atof(token);  // Convert the token to float
-        token = strtok(NULL, ", "); // Move to the next token
-        ++idl;
-    }
-
-    // BIG ENDIAN CONVERION
-    float_converter fc;
-    for( uint8_t idf = 0; idf < num_floats; ++idf ){
-        fc.number = fl_array[idf];
-        bytes_message[0 + 4*idf] = fc.bytes[3];
-        bytes_message[1 + 4*idf] = fc.bytes[2];
-        bytes_message[2 + 4*idf] = fc.bytes[1];
-        bytes_message[3 + 4*idf] = fc.bytes[0]; 
-    }
-}
-
-
-static void convertStringArrayToUInt8Bytes(char const *message_str, uint8_t slength, uint8_t *bytes_message, uint8_t num_uints) {
-
-    char message_tmp[slength-1];
-    memcpy(message_tmp, message_str+1, slength-1); // removing the [ and ] at the beginning and the end
-    message_tmp[slength-2] = '\0';
-    DEBUG_PRINT("convertStringArrayToFloatBytes message_tmp = ");
-    DEBUG_PRINTLN(message_tmp);
-
-    int idl = 0;
-    char* token = strtok(message_tmp, ", ");
-    while (token != NULL && idl < num_uints) {
-        bytes_message[idl] = (uint8_t)atoi(token);  // Convert the token to int and then to uint8_t
-        token = strtok(NULL, ", "); // Move to the next token
-        ++idl;
-    }
-}
-
 ////////////// This function is needed to overcome some limitations set by the library, basically mapping is missing pins because we are making use of another board
 /// Basically for some pins we want to overpass the variant.cpp file
 /// Modified from wiring_digital.c
@@ -316,6 +289,7 @@ void rawPinMode( uint32_t rawPin, uint32_t ulMode )
 #ifdef BLE_COMMUNICATION
 
 #include <bluefruit.h>
+#include "BnBLENodeCommunicator.h"
 
 #define CHARA_MAX_LENGTH 20
 
@@ -328,13 +302,12 @@ static BLECharacteristic sOrientationAbsChara(BN_BLE_CHARA_ORIENTATION_ABS_VALUE
 static BLECharacteristic sAccelerationRelChara(BN_BLE_CHARA_ACCELERATION_REL_VALUE_UUID);
 static BLECharacteristic sGloveChara(BN_BLE_CHARA_GLOVE_VALUE_UUID);
 static BLECharacteristic sShoeChara(BN_BLE_CHARA_SHOE_UUID, BLENotify);
-
-// This boolean just forces the Player and Bodypart to be set once
-// This is by specifications. The reason is that BLE communication is quite unique in nature and it is just
-// more complex to handle changing parts
-static bool sPlayerBodypartSet = false;
+static BLECharacteristic sStreamChara(BN_BLE_CHARA_STREAM_UUID);
+static BLECharacteristic sStatsChara(BN_BLE_CHARA_STATS_UUID);
+static BLECharacteristic sControlChara(BN_BLE_CHARA_CONTROL_UUID);
 
 static bool sIsConnected = false;
+static uint16_t sConnHandle = BLE_CONN_HANDLE_INVALID;
 
 // Function to start advertising
 void startAdv(void) {
@@ -352,10 +325,23 @@ void startAdv(void) {
     Bluefruit.Advertising.start(0);
 }
 
+// Callback when the central writes the control characteristic, it runs in the BLE task
+void control_write_callback(uint16_t conn_handle, BLECharacteristic* chara, uint8_t* data, uint16_t len) {
+    BnBLENodeCommunicator_onControlWrite(data, len);
+}
+
 // Callback when connected
 void connect_callback(uint16_t conn_handle) {
     Serial.println("Connected");
     sIsConnected = true;
+    sConnHandle = conn_handle;
+
+    // The central decides, these are only requests
+    BLEConnection* connection = Bluefruit.Connection(conn_handle);
+    connection->requestPHY(BLE_GAP_PHY_2MBPS);
+    connection->requestDataLengthUpdate();
+    connection->requestMtuExchange(BN_BLE_ATT_MTU);
+    connection->requestConnectionParameter(BN_BLE_CONN_INTERVAL_MIN);
 
 }
 
@@ -367,11 +353,15 @@ void disconnect_callback(uint16_t conn_handle, uint8_t reason) {
     // Restart advertising after disconnection
     startAdv();
     sIsConnected = false;
+    sConnHandle = BLE_CONN_HANDLE_INVALID;
 }
 
 void BnBLENodeCommunicator_init(){
     
+    // Room for the largest MTU and data length, and longer connection events
+    Bluefruit.configPrphBandwidth(BANDWIDTH_MAX);
     Bluefruit.begin();
+    Bluefruit.Periph.setConnInterval(BN_BLE_CONN_INTERVAL_MIN, BN_BLE_CONN_INTERVAL_MAX);
     
     Bluefruit.setName(BN_BLE_NAME);
     Bluefruit.setTxPower(4); // Max power
@@ -414,11 +404,26 @@ void BnBLENodeCommunicator_init(){
     sShoeChara.setFixedLen( 1 );  
     sShoeChara.begin( );
 #endif /*SHOE_SENSOR_ON_BOARD*/
+
+    sStreamChara.setProperties( CHR_PROPS_NOTIFY ); // Notify properties
+    sStreamChara.setPermission( SECMODE_OPEN, SECMODE_NO_ACCESS );
+    sStreamChara.setMaxLen( BN_BLE_STREAM_MAX_BYTES );
+    sStreamChara.begin( );
+
+    sStatsChara.setProperties( CHR_PROPS_NOTIFY ); // Notify properties
+    sStatsChara.setPermission( SECMODE_OPEN, SECMODE_NO_ACCESS );
+    sStatsChara.setMaxLen( BN_BLE_STREAM_MAX_BYTES );
+    sStatsChara.begin( );
+
+    sControlChara.setProperties( CHR_PROPS_WRITE | CHR_PROPS_WRITE_WO_RESP ); // Write properties
+    sControlChara.setPermission( SECMODE_NO_ACCESS, SECMODE_OPEN );
+    sControlChara.setMaxLen( BN_BLE_CONTROL_MAX_BYTES );
+    sControlChara.setWriteCallback( control_write_callback );
+    sControlChara.begin( );
     
     
     // Start advertising
     startAdv();
-    sPlayerBodypartSet = false;
     DEBUG_PRINTLN("BLE service started and advertising.");
     sIsConnected = false;
 
@@ -438,50 +443,65 @@ uint8_t BnBLENodeCommunicator_checkAllOk( uint8_t current_conn_status ){
     }
 }
 
-void BnBLENodeCommunicator_sendAllMessages(JsonArray &bnc_messages_list){
-    if(bnc_messages_list.size() == 0) {
-        //DEBUG_PRINTLN("No messages to send");
-        return;
+void BnBLENodeCommunicator_setNames(const String &player, const String &bodypart){
+    sPlayerChara.write(player.c_str());
+    sBodypartChara.write(bodypart.c_str());
+}
+
+void BnBLENodeCommunicator_sendRecord(uint8_t record_type, const uint8_t bytes[], uint8_t length){
+    BLECharacteristic *chara = nullptr;
+    switch(record_type){
+        case BN_BINARY_RECORD_ORIENTATION_ABS:
+            chara = &sOrientationAbsChara;
+            break;
+        case BN_BINARY_RECORD_ACCELERATION_REL:
+            chara = &sAccelerationRelChara;
+            break;
+        case BN_BINARY_RECORD_GLOVE:
+            chara = &sGloveChara;
+            break;
+        case BN_BINARY_RECORD_SHOE:
+            chara = &sShoeChara;
+            break;
+        default:
+            // No characteristic for this sensor type
+            return;
     }
-    for (JsonObject message_json : bnc_messages_list) {
-        if(!sPlayerBodypartSet) {
-            sPlayerChara.write(message_json[BN_MESSAGE_PLAYER_TAG].as<String>().c_str());
-            sBodypartChara.write(message_json[BN_MESSAGE_BODYPART_TAG].as<String>().c_str());
-            sPlayerBodypartSet = true;
-        }
-        String sensortype_str = message_json[BN_MESSAGE_SENSORTYPE_TAG].as<String>();
-        String value_str = message_json[BN_MESSAGE_VALUE_TAG].as<String>();
-
-        DEBUG_PRINT("message = ");
-        String output;
-        serializeJson(message_json, output);
-        DEBUG_PRINTLN(output);
-        
-        if(sensortype_str == BN_SENSORTYPE_ORIENTATION_ABS_TAG) {
-            uint8_t bytes_message[16];
-            convertStringArrayToFloatBytes(value_str.c_str(), value_str.length(), bytes_message, 4);
-            sOrientationAbsChara.write(bytes_message, 16);
-            sOrientationAbsChara.notify(&bytes_message, 16);
-        } else if(sensortype_str == BN_SENSORTYPE_ACCELERATION_REL_TAG) {
-            uint8_t bytes_message[12];
-            convertStringArrayToFloatBytes(value_str.c_str(), value_str.length(), bytes_message, 3);
-            sAccelerationRelChara.write(bytes_message, 12);
-            sAccelerationRelChara.notify(&bytes_message, 12);
-        } else if(sensortype_str == BN_SENSORTYPE_GLOVE_TAG) {
-            uint8_t bytes_message[9];
-            convertStringArrayToUInt8Bytes(value_str.c_str(), value_str.length(), bytes_message, 9);
-            sGloveChara.write(bytes_message, 9);
-            sGloveChara.notify(&bytes_message, 9);
-        } else if(sensortype_str == BN_SENSORTYPE_SHOE_TAG) {
-            //TODO sShoeChara.write(message_json[MESSAGE_VALUE_TAG].as<String>().c_str());
-            //TODO sShoeChara.notify(&bytes_message, 1);
-        } 
+    chara->write(bytes, length);
+    chara->notify(bytes, length);
+}
+
+uint16_t BnBLENodeCommunicator_streamCapacity(){
+    if(!sIsConnected || !sStreamChara.notifyEnabled(sConnHandle)) {
+        return 0;
     }
-    uint8_t num_messages = bnc_messages_list.size();
-    for (uint8_t index = 0; index<num_messages; ++index) {
-        bnc_messages_list.remove(0);
+    BLEConnection* connection = Bluefruit.Connection(sConnHandle);
+    if(connection == nullptr) {
+        return 0;
     }
+    // The ATT header of the notification takes 3 bytes
+    return connection->getMtu() - 3;
+}
+
+void BnBLENodeCommunicator_sendStream(const uint8_t bytes[], uint16_t length){
+    sStreamChara.notify(sConnHandle, bytes, length);
+}
+
+uint16_t BnBLENodeCommunicator_statsCapacity(){
+    if(!sIsConnected || !sStatsChara.notifyEnabled(sConnHandle)) {
+        return 0;
+    }
+    BLEConnection* connection = Bluefruit.Connection(sConnHandle);
+    if(connection == nullptr) {
+        return 0;
+    }
+    // The stream characteristic holds at most BN_BLE_STREAM_MAX_BYTES too
+    const uint16_t capacity = connection->getMtu() - 3;
+    return capacity < BN_BLE_STREAM_MAX_BYTES ? capacity : BN_BLE_STREAM_MAX_BYTES;
+}
 
+void BnBLENodeCommunicator_sendStats(const uint8_t bytes[], uint16_t length){
+    sStatsChara.notify(sConnHandle, bytes, length);
 }
 
 #endif
\ No newline at end of file
@@ -26,62 +26,43 @@
 
 #ifdef WIFI_COMMUNICATION
 
-bool tryConnectWifi(String ssid, String password){
+// Credentials given to the Particle store since the start up. The store cannot give back the password,
+// so they are written once and again only when they change, not at every retry
+static String sCredentialsSsid;
+static String sCredentialsPassword;
+static bool sCredentialsSet = false;
+
+bool beginConnectWifi(String ssid, String password){
+  if(WiFi.ready()) {
+    return true;
+  }
   // attempt to connect to Wifi network:
   DEBUG_PRINT("Attempting to connect to Network named: ");
   // print the network name (SSID);
   DEBUG_PRINTLN(ssid);
 
-  WiFi.off();
-  WiFi.on();
-  WiFi.clearCredentials();
-
-  bool my_wifi = false;
-  WiFiAccessPoint aps[20];
-  int found = WiFi.scan(aps, 20);
-  for (int i=0; i<found; i++) {
-      WiFiAccessPoint& ap = aps[i];
-      DEBUG_PRINT("SSID: ");
-      DEBUG_PRINT(ap.ssid);
-      DEBUG_PRINT(" | Security: ");
-      DEBUG_PRINT(ap.security);
-      DEBUG_PRINT(" | Channel: ");
-      DEBUG_PRINT(ap.channel);
-      DEBUG_PRINT(" | RSSI: ");
-      DEBUG_PRINTLN(ap.rssi);
-      String ap_ssid = ap.ssid; 
-      if(ap_ssid.indexOf(ssid)!=-1) {
-        my_wifi = true;
-      }
+  if(!sCredentialsSet || ssid != sCredentialsSsid || password != sCredentialsPassword) {
+    WiFi.off();
+    WiFi.on();
+    WiFi.clearCredentials();
+    WiFi.setCredentials(ssid, password);
+    sCredentialsSsid = ssid;
+    sCredentialsPassword = password;
+    sCredentialsSet = true;
   }
-  if(!my_wifi) {
-    DEBUG_PRINTLN("Couldn't find my wifi");
-    return false;
-  }
-  DEBUG_PRINTLN("Wifi found!"); 
-  
-  WiFi.setCredentials(ssid, password);
   WiFi.connect();
+  return true;
+}
 
-  while (WiFi.connecting()) {
-    // print dots while we wait to connect
-    DEBUG_PRINT(".");
-    delay(500);
+uint8_t pollConnectWifi(){
+  if(WiFi.connecting() || !WiFi.ready()) {
+    // There is no failed state to wait for, the attempt simply times out
+    return BN_WIFI_CONNECTING;
   }
-  bool conn = WiFi.ready();
-
-  if(conn){
-    DEBUG_PRINTLN("Waiting for an IP address");
-    IPAddress localIP = WiFi.localIP();
-    while (localIP[0] == 0) {
-      localIP = WiFi.localIP();
-      DEBUG_PRINTLN("Waiting for an IP address");
-      delay(1000);
-    }
-    DEBUG_PRINTLN("IP Address obtained");
-    return true;
+  if(WiFi.localIP()[0] == 0) {
+    return BN_WIFI_CONNECTING;
   }
-  return false;
+  return BN_WIFI_CONNECTED;
 }
 
 void printWifiStatus() {
@@ -141,6 +122,10 @@ void persMemoryWrite(uint16_t address_, uint8_t in_byte ) {
   EEPROM.write(address_, in_byte);
 }
 
+uint32_t getFreeHeapBytes() {
+  return System.freeMemory();
+}
+
 void BnHapticActuator_init() {
     pinMode(HAPTIC_MOTOR_PIN_P, OUTPUT);
 }
@@ -154,54 +139,10 @@ void BnHapticActuator_turnOFF() {
     digitalWrite(HAPTIC_MOTOR_PIN_P, LOW);
 }
 
-static void convertStringArrayToFloatBytes(char const *message_str, uint8_t slength, uint8_t *bytes_message, uint8_t num_floats) {
-
-    char message_tmp[slength-1];
-    memcpy(message_tmp, message_str+1, slength-1); // removing the [ and ] at the beginning and the end
-    message_tmp[slength-2] = '\0';
-    DEBUG_PRINT("convertStringArrayToFloatBytes message_tmp = ");
-    DEBUG_PRINTLN(message_tmp);
-
-    float fl_array[num_floats];
-    int idl = 0;
-    char* token = strtok(message_tmp, ", ");
-    while (token != NULL && idl < num_floats) {
-        fl_array[idl] = atof(token);  // Convert the token to float
-        token = strtok(NULL, ", "); // Move to the next token
-        ++idl;
-    }
-
-    // BIG ENDIAN CONVERION
-    float_converter fc;
-    for( uint8_t idf = 0; idf < num_floats; ++idf ){
-        fc.number = fl_array[idf];
-        bytes_message[0 + 4*idf] = fc.bytes[3];
-        bytes_message[1 + 4*idf] = fc.bytes[2];
-        bytes_message[2 + 4*idf] = fc.bytes[1];
-        bytes_message[3 + 4*idf] = fc.bytes[0]; 
-    }
-}
-
-
-static void convertStringArrayToUInt8Bytes(char const *message_str, uint8_t slength, uint8_t *bytes_message, uint8_t num_uints) {
-
-    char message_tmp[slength-1];
-    memcpy(message_tmp, message_str+1, slength-1); // removing the [ and ] at the beginning and the end
-    message_tmp[slength-2] = '\0';
-    DEBUG_PRINT("convertStringArrayToFloatBytes message_tmp = ");
-    DEBUG_PRINTLN(message_tmp);
-
-    int idl = 0;
-    char* token = strtok(message_tmp, ", ");
-    while (token != NULL && idl < num_uints) {
-        bytes_message[idl] = (uint8_t)atoi(token);  // Convert the token to int and then to uint8_t
-        token = strtok(NULL, ", "); // Move to the next token
-        ++idl;
-    }
-}
-
 #ifdef BLE_COMMUNICATION
 
+#include "BnBLENodeCommunicator.h"
+
 #define HEX_TO_UINT8(c) ( ((c) >= '0' && (c) <= '9') ? ((c) - '0') : \
                           ((c) >= 'a' && (c) <= 'f') ? ((c) - 'a' + 10) : \
                           ((c) >= 'A' && (c) <= 'F') ? ((c) - 'A' + 10) : 0 )
@@ -277,11 +218,8 @@ static uint8_t sAccelerationRelChara_uuid[] = UUID_TO_UINT8( BN_BLE_CHARA_ACCELE
 static uint8_t sAngularvelocityRelChara_uuid[] = UUID_TO_UINT8( BN_BLE_CHARA_ANGULARVELOCITY_REL_VALUE_UUID );
 static uint8_t sGloveChara_uuid[] = UUID_TO_UINT8( BN_BLE_CHARA_GLOVE_VALUE_UUID );
 static uint8_t sShoeChara_uuid[] = UUID_TO_UINT8( BN_BLE_CHARA_SHOE_UUID );
-
-// This boolean just forces the Player and Bodypart to be set once
-// This is by specifications. The reason is that BLE communication is quite unique in nature and it is just
-// more complex to handle changing parts
-static bool sPlayerBodypartSet = false;
+static uint8_t sStatsChara_uuid[] = UUID_TO_UINT8( BN_BLE_CHARA_STATS_UUID );
+static uint8_t sControlChara_uuid[] = UUID_TO_UINT8( BN_BLE_CHARA_CONTROL_UUID );
 
 static bool sIsConnected = false;
 
@@ -294,6 +232,8 @@ static uint16_t sAccelerationRelChara_handle = 0x0000;
 static uint16_t sAngularvelocityRelChara_handle = 0x0000;
 static uint16_t sGloveChara_handle = 0x0000;
 static uint16_t sShoeChara_handle = 0x0000;
+static uint16_t sStatsChara_handle = 0x0000;
+static uint16_t sControlChara_handle = 0x0000;
 
 static uint8_t sPlayerChara_data[BLE_CHARACTERISTIC_MAX_LEN] = { 0x00 };
 static uint8_t sBodypartChara_data[BLE_CHARACTERISTIC_MAX_LEN] = { 0x00 };
@@ -362,6 +302,22 @@ uint16_t BNC_gattReadCallback(uint16_t value_handle, uint8_t * buffer, uint16_t
     return characteristic_len;
 }
 
+/**
+ * @brief Callback for writing event.
+ *
+ * @param[in]  value_handle
+ * @param[in]  buffer
+ * @param[in]  size
+ *
+ * @retval  0
+ */
+int BNC_gattWriteCallback(uint16_t value_handle, uint8_t *buffer, uint16_t size) {
+    if ( value_handle == sControlChara_handle ){
+        BnBLENodeCommunicator_onControlWrite(buffer, size);
+    }
+    return 0;
+}
+
 void BnBLENodeCommunicator_init(){
 
     ble.init();
@@ -373,6 +329,7 @@ void BnBLENodeCommunicator_init(){
     ble.setAdvertisementData(sizeof(BNC_adv_data), BNC_adv_data);
     ble.setScanResponseData(sizeof(BNC_scan_response), BNC_scan_response);
     ble.onDataReadCallback(BNC_gattReadCallback);
+    ble.onDataWriteCallback(BNC_gattWriteCallback);
     ble.onConnectedCallback(BNC_deviceConnectedCallback);
     ble.onDisconnectedCallback(BNC_deviceDisconnectedCallback);
 
@@ -438,11 +395,22 @@ void BnBLENodeCommunicator_init(){
 
 #endif /*SHOE_SENSOR_ON_BOARD*/
 
+    sStatsChara_handle = ble.addCharacteristicDynamic(
+        sStatsChara_uuid,
+        ATT_PROPERTY_NOTIFY,
+        (uint8_t*)" ",
+        BLE_CHARACTERISTIC_MAX_LEN);
+
+    sControlChara_handle = ble.addCharacteristicDynamic(
+        sControlChara_uuid,
+        ATT_PROPERTY_WRITE | ATT_PROPERTY_WRITE_WITHOUT_RESPONSE,
+        (uint8_t*)" ",
+        BN_BLE_CONTROL_MAX_BYTES);
+
     // Start advertising
     startAdv();
     sPlayerChara_dataLength = 0;
     sBodypartChara_dataLength = 0;
-    sPlayerBodypartSet = false;
     DEBUG_PRINTLN("BLE service started and advertising.");
     sIsConnected = false;
 
@@ -462,56 +430,51 @@ uint8_t BnBLENodeCommunicator_checkAllOk( uint8_t current_conn_status ){
     }
 }
 
-void BnBLENodeCommunicator_sendAllMessages(JsonArray &bnc_messages_list){
-    if(bnc_messages_list.size() == 0) {
-        //DEBUG_PRINTLN("No messages to send");
-        return;
+void BnBLENodeCommunicator_setNames(const String &player, const String &bodypart){
+    // Keeping the space for the terminator
+    sPlayerChara_dataLength = player.length() < BLE_CHARACTERISTIC_MAX_LEN ? player.length() : BLE_CHARACTERISTIC_MAX_LEN - 1;
+    sBodypartChara_dataLength = bodypart.length() < BLE_CHARACTERISTIC_MAX_LEN ? bodypart.length() : BLE_CHARACTERISTIC_MAX_LEN - 1;
+    memcpy( sPlayerChara_data, player.c_str(), sPlayerChara_dataLength );
+    memcpy( sBodypartChara_data, bodypart.c_str(), sBodypartChara_dataLength );
+    sPlayerChara_data[sPlayerChara_dataLength] = '\0';
+    sBodypartChara_data[sBodypartChara_dataLength] = '\0';
+}
+
+void BnBLENodeCommunicator_sendRecord(uint8_t record_type, const uint8_t bytes[], uint8_t length){
+    switch(record_type){
+        case BN_BINARY_RECORD_ORIENTATION_ABS:
+            ble.sendNotify(sOrientationAbsChara_handle, (uint8_t*)bytes, length);
+            break;
+        case BN_BINARY_RECORD_ACCELERATION_REL:
+            ble.sendNotify(sAccelerationRelChara_handle, (uint8_t*)bytes, length);
+            break;
+        case BN_BINARY_RECORD_ANGULARVELOCITY_REL:
+            ble.sendNotify(sAngularvelocityRelChara_handle, (uint8_t*)bytes, length);
+            break;
+        case BN_BINARY_RECORD_GLOVE:
+            ble.sendNotify(sGloveChara_handle, (uint8_t*)bytes, length);
+            break;
+        case BN_BINARY_RECORD_SHOE:
+            ble.sendNotify(sShoeChara_handle, (uint8_t*)bytes, length);
+            break;
     }
-    for (JsonObject message_json : bnc_messages_list) {
-        if(!sPlayerBodypartSet) {
+}
+
+uint16_t BnBLENodeCommunicator_streamCapacity(){
+    // No stream characteristic on this board, the readings go to the sensor characteristics
+    return 0;
+}
 
-            sPlayerChara_dataLength = message_json[BN_MESSAGE_PLAYER_TAG].as<String>().length();
-            sBodypartChara_dataLength = message_json[BN_MESSAGE_BODYPART_TAG].as<String>().length();
-            memcpy( sPlayerChara_data, message_json[BN_MESSAGE_PLAYER_TAG].as<String>().c_str() , sPlayerChara_dataLength+1 );
-            memcpy( sBodypartChara_data, message_json[BN_MESSAGE_BODYPART_TAG].as<String>().c_str() , sBodypartChara_dataLength+1 );
+void BnBLENodeCommunicator_sendStream(const uint8_t bytes[], uint16_t length){
+}
 
-            sPlayerBodypartSet = true;
-        }
-        String sensortype_str = message_json[BN_MESSAGE_SENSORTYPE_TAG].as<String>();
-        String value_str = message_json[BN_MESSAGE_VALUE_TAG].as<String>();
-
-        DEBUG_PRINT("message = ");
-        String output;
-        serializeJson(message_json, output);
-        DEBUG_PRINTLN(output);
-
-        if(sensortype_str == BN_SENSORTYPE_ORIENTATION_ABS_TAG) {
-            uint8_t bytes_message[BLE_CHARACTERISTIC_ORIABS_MAX_LEN];
-            convertStringArrayToFloatBytes(value_str.c_str(), value_str.length(), bytes_message, BLE_CHARACTERISTIC_ORIABS_MAX_LEN/4);
-            ble.sendNotify(sOrientationAbsChara_handle, bytes_message, BLE_CHARACTERISTIC_ORIABS_MAX_LEN);
-        } else if(sensortype_str == BN_SENSORTYPE_ACCELERATION_REL_TAG) {
-            uint8_t bytes_message[BLE_CHARACTERISTIC_ACCREL_MAX_LEN];
-            convertStringArrayToFloatBytes(value_str.c_str(), value_str.length(), bytes_message, BLE_CHARACTERISTIC_ACCREL_MAX_LEN/4);
-            ble.sendNotify(sAccelerationRelChara_handle, bytes_message, BLE_CHARACTERISTIC_ACCREL_MAX_LEN);
-        } else if(sensortype_str == BN_SENSORTYPE_GLOVE_TAG) {
-            uint8_t bytes_message[BLE_CHARACTERISTIC_GLOVE_MAX_LEN];
-            convertStringArrayToUInt8Bytes(value_str.c_str(), value_str.length(), bytes_message, BLE_CHARACTERISTIC_GLOVE_MAX_LEN);
-            ble.sendNotify(sGloveChara_handle, bytes_message, BLE_CHARACTERISTIC_GLOVE_MAX_LEN);
-        } else if(sensortype_str == BN_SENSORTYPE_SHOE_TAG) {
-            uint8_t bytes_message[BLE_CHARACTERISTIC_SHOE_MAX_LEN];
-            convertStringArrayToUInt8Bytes(value_str.c_str(), value_str.length(), bytes_message, BLE_CHARACTERISTIC_SHOE_MAX_LEN);
-            ble.sendNotify(sShoeChara_handle, bytes_message, BLE_CHARACTERISTIC_SHOE_MAX_LEN);
-        } else if(sensortype_str == BN_SENSORTYPE_ANGULARVELOCITY_REL_TAG) {
-            uint8_t bytes_message[BLE_CHARACTERISTIC_ANGVELREL_MAX_LEN];
-            convertStringArrayToFloatBytes(value_str.c_str(), value_str.length(), bytes_message, BLE_CHARACTERISTIC_ANGVELREL_MAX_LEN/4);
-            ble.sendNotify(sAngularvelocityRelChara_handle, bytes_message, BLE_CHARACTERISTIC_ANGVELREL_MAX_LEN);            
-        } 
-    }
-    uint8_t num_messages = bnc_messages_list.size();
-    for (uint8_t index = 0; index<num_messages; ++index) {
-        bnc_messages_list.remove(0);
-    }
+uint16_t BnBLENodeCommunicator_statsCapacity(){
+    // Notifications of the default MTU, like the sensor characteristics
+    return sIsConnected ? BLE_CHARACTERISTIC_MAX_LEN : 0;
+}
 
+void BnBLENodeCommunicator_sendStats(const uint8_t bytes[], uint16_t length){
+    ble.sendNotify(sStatsChara_handle, (uint8_t*)bytes, length);
 }
 
 #endif
@@ -34,8 +34,9 @@ void BnAccelerationRelSensor::init(){
     s_sensorInit=false;
     s_lastReadSensorTime=millis();
     s_sensorReconnectionTime=millis();
+    s_isensorHub.subscribe(BN_ISENSOR_DATATYPE_ACCELEROMETER, SENSOR_READ_INTERVAL_MS * 1000UL);
     /* Initialise the sensor */
-    if(s_isensor.init()) {
+    if(s_isensorHub.init()) {
          setStatus(BN_SENSOR_STATUS_WORKING);
     } else {
          setStatus(BN_SENSOR_STATUS_NOT_ACCESSIBLE);
@@ -59,7 +60,7 @@ bool BnAccelerationRelSensor::checkAllOk(){
         }
         DEBUG_PRINTLN("Sensor not connected");
         s_sensorReconnectionTime=millis();
-        if (s_isensor.init()) {
+        if (s_isensorHub.init()) {
             setStatus(BN_SENSOR_STATUS_WORKING);
             return true;
         } else {
@@ -72,7 +73,8 @@ bool BnAccelerationRelSensor::checkAllOk(){
     }
 
     float acc_values[3];
-    if( !s_isensor.getData(acc_values, BN_ISENSOR_DATATYPE_ACCELEROMETER) ) {
+    // Same instant as the other esensors of this tick
+    if( !s_isensorHub.getData(acc_values, BN_ISENSOR_DATATYPE_ACCELEROMETER) ) {
         return false;
     }
 
@@ -89,7 +91,7 @@ bool BnAccelerationRelSensor::checkAllOk(){
 }
 
 bool BnAccelerationRelSensor::isCalibrated(){
-    if( s_isensor.isCalibrated() ){
+    if( s_isensorHub.isCalibrated() ){
         setStatus(BN_SENSOR_STATUS_WORKING);
         return true;
     } else {
@@ -111,12 +113,12 @@ BnSensorData BnAccelerationRelSensor::getData(){
   DEBUG_PRINTLN(s_values[3]);
   */
   BnSensorData sensorData;
-  sensorData.setValues(s_values, BN_SENSORTYPE_ACCELERATION_REL_TAG);
+  sensorData.setValues(s_values, BN_SENSORTYPE_ACCELERATION_REL);
   return sensorData;
 }
 
 BnType BnAccelerationRelSensor::getType(){
-    return BN_SENSORTYPE_ACCELERATION_REL_TAG;
+    return BN_SENSORTYPE_ACCELERATION_REL;
 }
 
 void BnAccelerationRelSensor::setEnable(bool enable_status){
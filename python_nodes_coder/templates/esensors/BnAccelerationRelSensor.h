@@ -31,7 +31,7 @@
 
 #include "BnDatatypes.h"
 #include "BnArduinoUtils.h"
-#include "BnISensor.h"
+#include "BnISensorHub.h"
 
 class BnAccelerationRelSensor {
 public:
@@ -39,7 +39,7 @@ public:
     bool checkAllOk();
     bool isCalibrated();
     BnSensorData getData();
-    String getType();
+    BnType getType();
     void setEnable(bool enable_status);
     bool isEnabled();
 
@@ -47,7 +47,7 @@ private:
     void setStatus(int sensor_status);
     void realignAxis(float values[], float revalues[]);
 
-    BnISensor s_isensor;
+    BnISensorHub s_isensorHub;
     bool s_enabled;
     bool s_sensorInit;
     unsigned long s_lastReadSensorTime;
@@ -32,8 +32,9 @@ void BnAngularVelocityRelSensor::init(){
     s_sensorInit=false;
     s_lastReadSensorTime=millis();
     s_sensorReconnectionTime=millis();
+    s_isensorHub.subscribe(BN_ISENSOR_DATATYPE_GYROSCOPE, SENSOR_READ_INTERVAL_MS * 1000UL);
     /* Initialise the sensor */
-    if(s_isensor.init()) {
+    if(s_isensorHub.init()) {
          setStatus(BN_SENSOR_STATUS_WORKING);
     } else {
          setStatus(BN_SENSOR_STATUS_NOT_ACCESSIBLE);
@@ -57,7 +58,7 @@ bool BnAngularVelocityRelSensor::checkAllOk(){
         }
         DEBUG_PRINTLN("Sensor not connected");
         s_sensorReconnectionTime=millis();
-        if (s_isensor.init()) {
+        if (s_isensorHub.init()) {
             setStatus(BN_SENSOR_STATUS_WORKING);
             return true;
         } else {
@@ -70,7 +71,8 @@ bool BnAngularVelocityRelSensor::checkAllOk(){
     }
 
     float gyro_values[3];
-    if( !s_isensor.getData(gyro_values, BN_ISENSOR_DATATYPE_GYROSCOPE) ) {
+    // Same instant as the other esensors of this tick
+    if( !s_isensorHub.getData(gyro_values, BN_ISENSOR_DATATYPE_GYROSCOPE) ) {
         return false;
     }
     
@@ -85,7 +87,7 @@ bool BnAngularVelocityRelSensor::checkAllOk(){
 }
 
 bool BnAngularVelocityRelSensor::isCalibrated(){
-    if( s_isensor.isCalibrated() ){
+    if( s_isensorHub.isCalibrated() ){
         setStatus(BN_SENSOR_STATUS_WORKING);
         return true;
     } else {
@@ -107,12 +109,12 @@ BnSensorData BnAngularVelocityRelSensor::getData(){
   DEBUG_PRINTLN(s_values[3]);
   */
   BnSensorData sensorData;
-  sensorData.setValues(s_values, BN_SENSORTYPE_ANGULARVELOCITY_REL_TAG);
+  sensorData.setValues(s_values, BN_SENSORTYPE_ANGULARVELOCITY_REL);
   return sensorData;
 }
 
 BnType BnAngularVelocityRelSensor::getType(){
-    return BN_SENSORTYPE_ANGULARVELOCITY_REL_TAG;
+    return BN_SENSORTYPE_ANGULARVELOCITY_REL;
 }
 
 void BnAngularVelocityRelSensor::setEnable(bool enable_status){
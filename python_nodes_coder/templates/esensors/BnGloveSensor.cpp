@@ -178,8 +178,8 @@ void BnGloveSensor::getData(int *values){
 
 }
 
-String BnGloveSensor::getType(){
-    return BN_SENSORTYPE_GLOVE_TAG;
+BnType BnGloveSensor::getType(){
+    return BN_SENSORTYPE_GLOVE;
 }
 
 void BnGloveSensor::setEnable(bool enable_status){
@@ -68,8 +68,8 @@ void BnGloveSensorReaderSerial::getData(int *values){
     }
 }
 
-String BnGloveSensorReaderSerial::getType(){
-    return BN_SENSORTYPE_GLOVE_TAG;
+BnType BnGloveSensorReaderSerial::getType(){
+    return BN_SENSORTYPE_GLOVE;
 }
 
 void BnGloveSensorReaderSerial::setEnable(bool enable_status){
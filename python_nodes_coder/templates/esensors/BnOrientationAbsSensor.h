@@ -32,7 +32,7 @@
 
 #include "BnDatatypes.h"
 #include "BnArduinoUtils.h"
-#include "BnISensor.h"
+#include "BnISensorHub.h"
 
 class BnOrientationAbsSensor {
 public:
@@ -40,14 +40,16 @@ public:
     bool checkAllOk();
     bool isCalibrated();
     BnSensorData getData();
-    String getType();
+    BnType getType();
     void setEnable(bool enable_status);
     bool isEnabled();
+    // Collects the magnetometer min/max for duration_ms, then stores the resulting calibration
+    void calibrateMagn(uint32_t duration_ms);
 
 private:
     void realignAxis(float values[], float revalues[]);
 
-    BnISensor s_isensor;
+    BnISensorHub s_isensorHub;
     bool s_enabled;
     bool s_sensorInit;
     unsigned long s_lastReadSensorTime;
@@ -32,8 +32,9 @@ void BnOrientationAbsSensor::init(){
     s_sensorInit=false;
     s_lastReadSensorTime=millis();
     s_sensorReconnectionTime=millis();
+    s_isensorHub.subscribe(BN_ISENSOR_DATATYPE_ABSOLUTEORIENTATION, SENSOR_READ_INTERVAL_MS * 1000UL);
     /* Initialise the sensor */
-    if(s_isensor.init()) {
+    if(s_isensorHub.init()) {
         s_sensorInit=true;
         s_firstZeros=true;
     }
@@ -47,7 +48,7 @@ bool BnOrientationAbsSensor::checkAllOk(){
         }
         DEBUG_PRINTLN("Sensor not connected");
         s_sensorReconnectionTime=millis();
-        if(s_isensor.init()) {
+        if(s_isensorHub.init()) {
             s_firstZeros=true;
             s_sensorInit=true;
             return true;
@@ -61,7 +62,7 @@ bool BnOrientationAbsSensor::checkAllOk(){
 
 
     float svalues[4];
-    if( !s_isensor.getData(svalues, BN_ISENSOR_DATATYPE_ABSOLUTEORIENTATION) ) {
+    if( !s_isensorHub.getData(svalues, BN_ISENSOR_DATATYPE_ABSOLUTEORIENTATION) ) {
         return false;
     }
     
@@ -75,7 +76,7 @@ bool BnOrientationAbsSensor::checkAllOk(){
 
     if (tvalues[0] == 0 && tvalues[1]==0 && tvalues[2]==0 && tvalues[3]==0 && !s_firstZeros){
         DEBUG_PRINTLN("Sensor might have gotten disconnected!");
-        s_isensor.setStatus(BN_SENSOR_STATUS_NOT_ACCESSIBLE);
+        s_isensorHub.setStatus(BN_SENSOR_STATUS_NOT_ACCESSIBLE);
         return false;
     }
 
@@ -88,7 +89,7 @@ bool BnOrientationAbsSensor::checkAllOk(){
 }
 
 bool BnOrientationAbsSensor::isCalibrated(){
-    return s_isensor.isCalibrated();
+    return s_isensorHub.isCalibrated();
 }
 
 BnSensorData BnOrientationAbsSensor::getData(){
@@ -104,18 +105,23 @@ BnSensorData BnOrientationAbsSensor::getData(){
     DEBUG_PRINTLN(s_values[3]);
     */
     BnSensorData sensorData;
-    sensorData.setValues(s_values, BN_SENSORTYPE_ORIENTATION_ABS_TAG);
+    sensorData.setValues(s_values, BN_SENSORTYPE_ORIENTATION_ABS);
     return sensorData;
 }
 
 BnType BnOrientationAbsSensor::getType(){
-    return BN_SENSORTYPE_ORIENTATION_ABS_TAG;
+    return BN_SENSORTYPE_ORIENTATION_ABS;
 }
 
 void BnOrientationAbsSensor::setEnable(bool enable_status){
     s_enabled = enable_status;
 }
 
+void BnOrientationAbsSensor::calibrateMagn(uint32_t duration_ms){
+    // The on board fusion calibrates the magnetometer by itself
+    DEBUG_PRINTLN("Magnetometer calibration not needed");
+}
+
 bool BnOrientationAbsSensor::isEnabled(){
     return s_enabled;
 }
@@ -0,0 +1,554 @@
+/**
+* MIT License
+* 
+* Copyright (c) 2024-2026 Manuel Bottini
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+/*
+The implementation of the sensor fusion algorithm in BnOrientationAbsSensor took inspiration
+from here https://github.com/Mayitzin/ahrs/blob/master/ahrs/filters/madgwick.py
+Thank you Mario García for providing the code on GitHub.
+
+The algorithm here has been modified for the purpose of being practical in motion capture
+applications and Bodynodes in particular
+
+*/
+
+/**
+The MIT License (MIT)
+
+Copyright (c) 2019-2020, Mario García.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "BnSensorFusion.h"
+
+///////////////// BnQuat START
+
+void BnQuat::conjugate() {
+    // [w, -x, -y, -z]
+    x( -x() );
+    y( -y() );
+    z( -z() );
+}
+
+// The result must not alias one of the inputs
+void BnQuat::productHamilton(BnQuat &result, const BnQuat &quatL, const BnQuat &quatR ) {
+    result.w( quatL.w()*quatR.w() - quatL.x()*quatR.x() - quatL.y()*quatR.y() - quatL.z()*quatR.z());
+    result.x( quatL.w()*quatR.x() + quatL.x()*quatR.w() + quatL.y()*quatR.z() - quatL.z()*quatR.y());
+    result.y( quatL.w()*quatR.y() - quatL.x()*quatR.z() + quatL.y()*quatR.w() + quatL.z()*quatR.x());
+    result.z( quatL.w()*quatR.z() + quatL.x()*quatR.y() - quatL.y()*quatR.x() + quatL.z()*quatR.w());
+}
+
+///////////////// BnQuat END
+
+///////////////// BnSensorFusionMadgwickAHRS START
+
+BnSensorFusionMadgwickAHRS::BnSensorFusionMadgwickAHRS(
+        const float samplePeriod_s,
+        const float gain,
+        const float rescaleGyro,
+        const BnVec3 &axisSigns):
+
+        m_nominalSamplePeriod_s(samplePeriod_s),
+        m_samplePeriod_s(samplePeriod_s),
+        m_gain(gain),
+        m_rescaleGyro(rescaleGyro),
+        m_axisSigns(axisSigns),
+        m_internalQuat(),
+        m_lastTime_us(0),
+        m_hasLastTime(false) {} ;
+
+void BnSensorFusionMadgwickAHRS::init(const BnQuat &initialQuat) {
+    m_internalQuat = initialQuat;
+    m_samplePeriod_s = m_nominalSamplePeriod_s;
+    m_hasLastTime = false;
+}
+
+void BnSensorFusionMadgwickAHRS::updateSamplePeriod(const uint32_t time_now_us) {
+    if(m_hasLastTime) {
+        // The unsigned difference stays correct across the micros() wraparound (~71 minutes)
+        const uint32_t elapsed_us = time_now_us - m_lastTime_us;
+        if(elapsed_us > BN_SENSOR_FUSION_MAX_PERIOD_US) {
+            // After a stall (i.e. a blocking reconnection) the gyroscope tells nothing about
+            // the time passed, integrating it over the whole gap would only add error
+            m_samplePeriod_s = m_nominalSamplePeriod_s;
+        } else {
+            m_samplePeriod_s = static_cast<float>(elapsed_us) * 1e-6f;
+        }
+    }
+    m_lastTime_us = time_now_us;
+    m_hasLastTime = true;
+}
+
+void BnSensorFusionMadgwickAHRS::updateIMU(
+    const BnVec3 &gyro,
+    const BnVec3 &accel,
+    const uint32_t time_now_us) {
+
+    BnVec3 gyro_i;
+    BnVec3::productElementwise( gyro_i, gyro, m_axisSigns );
+    gyro_i.multiply( m_rescaleGyro );
+    BnVec3 accel_i;
+    BnVec3::productElementwise( accel_i, accel, m_axisSigns );
+    updateSamplePeriod(time_now_us);
+
+#if BN_SENSOR_FUSION_SCALAR_KERNEL
+    integrateIMU(gyro_i, accel_i);
+#else
+    integrateIMUMatrix(gyro_i, accel_i);
+#endif
+}
+
+void BnSensorFusionMadgwickAHRS::updateMAGR(
+    const BnVec3 &gyro,
+    const BnVec3 &accel,
+    const BnVec3 &magn,
+    const uint32_t time_now_us) {
+
+    BnVec3 gyro_i;
+    BnVec3::productElementwise( gyro_i, gyro, m_axisSigns );
+    gyro_i.multiply( m_rescaleGyro );
+    BnVec3 accel_i;
+    BnVec3::productElementwise( accel_i, accel, m_axisSigns );
+    BnVec3 magn_i;
+    BnVec3::productElementwise( magn_i, magn, m_axisSigns );
+    updateSamplePeriod(time_now_us);
+
+#if BN_SENSOR_FUSION_SCALAR_KERNEL
+    integrateMAGR(gyro_i, accel_i, magn_i);
+#else
+    integrateMAGRMatrix(gyro_i, accel_i, magn_i);
+#endif
+}
+
+// Inverse square root with the well known bit-level first guess, refined with two Newton iterations.
+// Relative error is below 1e-5, which is way below the noise of the sensors, and on boards
+// without a FPU it is much faster than a division by std::sqrt
+static inline float invSqrt(const float x) {
+    const float halfx = 0.5f * x;
+    float y = x;
+    uint32_t i;
+    memcpy(&i, &y, sizeof(i));
+    i = 0x5f3759df - (i >> 1);
+    memcpy(&y, &i, sizeof(y));
+    y = y * (1.5f - (halfx * y * y));
+    y = y * (1.5f - (halfx * y * y));
+    return y;
+}
+
+void BnSensorFusionMadgwickAHRS::gradientIMU(const BnQuat &quat, const BnVec3 &accel, BnQuat &gradient) {
+    const float qw = quat.w();
+    const float qx = quat.x();
+    const float qy = quat.y();
+    const float qz = quat.z();
+    const float _2qw = 2.0f * qw;
+    const float _2qx = 2.0f * qx;
+    const float _2qy = 2.0f * qy;
+    const float _2qz = 2.0f * qz;
+    const float _4qx = 4.0f * qx;
+    const float _4qy = 4.0f * qy;
+
+    //# Objective function
+    const float f1 = _2qx * qz - _2qw * qy - accel.x();
+    const float f2 = _2qw * qx + _2qy * qz - accel.y();
+    const float f3 = 1.0f - _2qx * qx - _2qy * qy - accel.z();
+
+    //# Objective Function Gradient, transposed Jacobian (eq. 26) times the objective function
+    //# (eq. 34)
+    gradient.w( -_2qy * f1 + _2qx * f2 );
+    gradient.x(  _2qz * f1 + _2qw * f2 - _4qx * f3 );
+    gradient.y( -_2qw * f1 + _2qz * f2 - _4qy * f3 );
+    gradient.z(  _2qx * f1 + _2qy * f2 );
+}
+
+void BnSensorFusionMadgwickAHRS::gradientMAGR(const BnQuat &quat, const BnVec3 &accel, const BnVec3 &magn, BnQuat &gradient) {
+    const float qw = quat.w();
+    const float qx = quat.x();
+    const float qy = quat.y();
+    const float qz = quat.z();
+    const float mx = magn.x();
+    const float my = magn.y();
+    const float mz = magn.z();
+    const float _2qw = 2.0f * qw;
+    const float _2qx = 2.0f * qx;
+    const float _2qy = 2.0f * qy;
+    const float _2qz = 2.0f * qz;
+    const float _4qx = 4.0f * qx;
+    const float _4qy = 4.0f * qy;
+    const float qwqx = qw * qx;
+    const float qwqy = qw * qy;
+    const float qwqz = qw * qz;
+    const float qxqx = qx * qx;
+    const float qxqy = qx * qy;
+    const float qxqz = qx * qz;
+    const float qyqy = qy * qy;
+    const float qyqz = qy * qz;
+    const float qzqz = qz * qz;
+
+    //# Rotate normalized magnetometer measurements
+    //# (eq. 45)
+    const float hx = 2.0f * ( mx * (0.5f - qyqy - qzqz) + my * (qxqy - qwqz) + mz * (qxqz + qwqy) );
+    const float hy = 2.0f * ( mx * (qxqy + qwqz) + my * (0.5f - qxqx - qzqz) + mz * (qyqz - qwqx) );
+    const float hz = 2.0f * ( mx * (qxqz - qwqy) + my * (qyqz + qwqx) + mz * (0.5f - qxqx - qyqy) );
+
+    //# (eq. 46)
+    const float hxySquares = hx * hx + hy * hy;
+    const float _2bx = hxySquares > 0.0f ? 2.0f * hxySquares * invSqrt(hxySquares) : 0.0f;
+    const float _2bz = 2.0f * hz;
+    const float _4bx = 2.0f * _2bx;
+    const float _4bz = 2.0f * _2bz;
+
+    //# Objective function
+    const float f1 = 2.0f * (qxqz - qwqy) - accel.x();
+    const float f2 = 2.0f * (qwqx + qyqz) - accel.y();
+    const float f3 = 1.0f - 2.0f * (qxqx + qyqy) - accel.z();
+    const float f4 = _2bx * (0.5f - qyqy - qzqz) + _2bz * (qxqz - qwqy) - mx;
+    const float f5 = _2bx * (qxqy - qwqz) + _2bz * (qwqx + qyqz) - my;
+    const float f6 = _2bx * (qwqy + qxqz) + _2bz * (0.5f - qxqx - qyqy) - mz;
+
+    //# Objective Function Gradient, transposed Jacobian (eq. 26) times the objective function
+    //# (eq. 34)
+    gradient.w( -_2qy * f1 + _2qx * f2
+        - _2bz * qy * f4
+        + (-_2bx * qz + _2bz * qx) * f5
+        + _2bx * qy * f6 );
+    gradient.x( _2qz * f1 + _2qw * f2 - _4qx * f3
+        + _2bz * qz * f4
+        + (_2bx * qy + _2bz * qw) * f5
+        + (_2bx * qz - _4bz * qx) * f6 );
+    gradient.y( -_2qw * f1 + _2qz * f2 - _4qy * f3
+        + (-_4bx * qy - _2bz * qw) * f4
+        + (_2bx * qx + _2bz * qz) * f5
+        + (_2bx * qw - _4bz * qy) * f6 );
+    gradient.z( _2qx * f1 + _2qy * f2
+        + (-_4bx * qz + _2bz * qx) * f4
+        + (-_2bx * qw + _2bz * qy) * f5
+        + _2bx * qx * f6 );
+}
+
+void BnSensorFusionMadgwickAHRS::integrateIMU(const BnVec3 &gyro_i, BnVec3 &accel_i) {
+    float qw = m_internalQuat.w();
+    float qx = m_internalQuat.x();
+    float qy = m_internalQuat.y();
+    float qz = m_internalQuat.z();
+    const float gx = gyro_i.x();
+    const float gy = gyro_i.y();
+    const float gz = gyro_i.z();
+
+    //# (eq. 12)
+    float qDotW = 0.5f * (-qx * gx - qy * gy - qz * gz);
+    float qDotX = 0.5f * ( qw * gx + qy * gz - qz * gy);
+    float qDotY = 0.5f * ( qw * gy - qx * gz + qz * gx);
+    float qDotZ = 0.5f * ( qw * gz + qx * gy - qy * gx);
+
+    float ax = accel_i.x();
+    float ay = accel_i.y();
+    float az = accel_i.z();
+    const float accelSquares = ax * ax + ay * ay + az * az;
+    if( accelSquares > 0.0f ) {
+        const float accelRecipNorm = invSqrt(accelSquares);
+        ax *= accelRecipNorm;
+        ay *= accelRecipNorm;
+        az *= accelRecipNorm;
+    }
+
+    float quatRecipNorm = invSqrt(qw * qw + qx * qx + qy * qy + qz * qz);
+    qw *= quatRecipNorm;
+    qx *= quatRecipNorm;
+    qy *= quatRecipNorm;
+    qz *= quatRecipNorm;
+
+    BnQuat gradient;
+    gradientIMU(BnQuat(qw, qx, qy, qz), BnVec3(ax, ay, az), gradient);
+    const float s0 = gradient.w();
+    const float s1 = gradient.x();
+    const float s2 = gradient.y();
+    const float s3 = gradient.z();
+
+    const float gradientSquares = s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3;
+    if( gradientSquares > 0.0f ) {
+        const float gradientScale = m_gain * invSqrt(gradientSquares);
+        //# (eq. 33)
+        qDotW -= gradientScale * s0;
+        qDotX -= gradientScale * s1;
+        qDotY -= gradientScale * s2;
+        qDotZ -= gradientScale * s3;
+    }
+
+    //# (eq. 13)
+    const float dt = m_samplePeriod_s;
+    qw += qDotW * dt;
+    qx += qDotX * dt;
+    qy += qDotY * dt;
+    qz += qDotZ * dt;
+
+    quatRecipNorm = invSqrt(qw * qw + qx * qx + qy * qy + qz * qz);
+    m_internalQuat.w( qw * quatRecipNorm );
+    m_internalQuat.x( qx * quatRecipNorm );
+    m_internalQuat.y( qy * quatRecipNorm );
+    m_internalQuat.z( qz * quatRecipNorm );
+}
+
+void BnSensorFusionMadgwickAHRS::integrateMAGR(const BnVec3 &gyro_i, BnVec3 &accel_i, BnVec3 &magn_i) {
+    float qw = m_internalQuat.w();
+    float qx = m_internalQuat.x();
+    float qy = m_internalQuat.y();
+    float qz = m_internalQuat.z();
+    const float gx = gyro_i.x();
+    const float gy = gyro_i.y();
+    const float gz = gyro_i.z();
+
+    //# (eq. 12)
+    float qDotW = 0.5f * (-qx * gx - qy * gy - qz * gz);
+    float qDotX = 0.5f * ( qw * gx + qy * gz - qz * gy);
+    float qDotY = 0.5f * ( qw * gy - qx * gz + qz * gx);
+    float qDotZ = 0.5f * ( qw * gz + qx * gy - qy * gx);
+
+    float ax = accel_i.x();
+    float ay = accel_i.y();
+    float az = accel_i.z();
+    const float accelSquares = ax * ax + ay * ay + az * az;
+    if( accelSquares > 0.0f ) {
+        const float accelRecipNorm = invSqrt(accelSquares);
+        ax *= accelRecipNorm;
+        ay *= accelRecipNorm;
+        az *= accelRecipNorm;
+    }
+
+    float mx = magn_i.x();
+    float my = magn_i.y();
+    float mz = magn_i.z();
+    const float magnSquares = mx * mx + my * my + mz * mz;
+    if( magnSquares > 0.0f ) {
+        const float magnRecipNorm = invSqrt(magnSquares);
+        mx *= magnRecipNorm;
+        my *= magnRecipNorm;
+        mz *= magnRecipNorm;
+    }
+
+    float quatRecipNorm = invSqrt(qw * qw + qx * qx + qy * qy + qz * qz);
+    qw *= quatRecipNorm;
+    qx *= quatRecipNorm;
+    qy *= quatRecipNorm;
+    qz *= quatRecipNorm;
+
+    BnQuat gradient;
+    gradientMAGR(BnQuat(qw, qx, qy, qz), BnVec3(ax, ay, az), BnVec3(mx, my, mz), gradient);
+    const float s0 = gradient.w();
+    const float s1 = gradient.x();
+    const float s2 = gradient.y();
+    const float s3 = gradient.z();
+
+    const float gradientSquares = s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3;
+    if( gradientSquares > 0.0f ) {
+        const float gradientScale = m_gain * invSqrt(gradientSquares);
+        //# (eq. 33)
+        qDotW -= gradientScale * s0;
+        qDotX -= gradientScale * s1;
+        qDotY -= gradientScale * s2;
+        qDotZ -= gradientScale * s3;
+    }
+
+    //# (eq. 13)
+    const float dt = m_samplePeriod_s;
+    qw += qDotW * dt;
+    qx += qDotX * dt;
+    qy += qDotY * dt;
+    qz += qDotZ * dt;
+
+    quatRecipNorm = invSqrt(qw * qw + qx * qx + qy * qy + qz * qz);
+    m_internalQuat.w( qw * quatRecipNorm );
+    m_internalQuat.x( qx * quatRecipNorm );
+    m_internalQuat.y( qy * quatRecipNorm );
+    m_internalQuat.z( qz * quatRecipNorm );
+}
+
+void BnSensorFusionMadgwickAHRS::gradientIMUMatrix(const BnQuat &quat, const BnVec3 &accel, BnQuat &gradient) {
+    const float qw = quat.w();
+    const float qx = quat.x();
+    const float qy = quat.y();
+    const float qz = quat.z();
+    BnVectorN<3> vecF;
+    vecF.val(0, 2.0f * ( qx* qz - qw*qy) - accel.x() );
+    vecF.val(1, 2.0f * ( qw* qx + qy*qz) - accel.y() );
+    vecF.val(2, 2.0f * ( 0.5f - qx* qx - qy*qy) - accel.z() );
+
+    //# Transposed Jacobian (eq. 26)
+    BnMatrixN<4,3> matrJT;
+    matrJT.val( 0,0, -2.0f*qy );
+    matrJT.val( 1,0, 2.0f*qz );
+    matrJT.val( 2,0, -2.0f*qw );
+    matrJT.val( 3,0, 2.0f*qx );
+
+    matrJT.val( 0,1, 2.0f*qx );
+    matrJT.val( 1,1, 2.0f*qw );
+    matrJT.val( 2,1, 2.0f*qz );
+    matrJT.val( 3,1, 2.0f*qy );
+
+    matrJT.val( 0,2, 0.0f );
+    matrJT.val( 1,2, -4.0f*qx );
+    matrJT.val( 2,2, -4.0f*qy );
+    matrJT.val( 3,2, 0.0f );
+
+    //# Objective Function Gradient
+    //# (eq. 34)
+    BnMatrixN<4,1>::multiply( gradient, matrJT, vecF );
+}
+
+void BnSensorFusionMadgwickAHRS::gradientMAGRMatrix(const BnQuat &quat, const BnVec3 &accel, const BnVec3 &magn, BnQuat &gradient) {
+    //# Rotate normalized magnetometer measurements
+    //# (eq. 45)
+
+    // h = quat_prod(self.internalQuat, quat_prod([0, *m], quat_conj(self.internalQuat)))
+    BnQuat quatConj = quat;
+    quatConj.conjugate();
+    const BnQuat quatMagn( 0, magn.x(), magn.y(), magn.z() );
+    BnQuat quatTmp;
+    BnQuat::productHamilton( quatTmp, quatMagn, quatConj );
+    BnQuat quatH;
+    BnQuat::productHamilton( quatH, quat, quatTmp );
+
+    //# (eq. 46)
+    const float bx = std::sqrt( quatH.x()*quatH.x() + quatH.y()*quatH.y() );
+    const float bz = quatH.z();
+
+    const float qw = quat.w();
+    const float qx = quat.x();
+    const float qy = quat.y();
+    const float qz = quat.z();
+
+    BnVectorN<6> vecF;
+    vecF.val(0, 2.0f * ( qx* qz - qw*qy) - accel.x() );
+    vecF.val(1, 2.0f * ( qw* qx + qy*qz) - accel.y() );
+    vecF.val(2, 2.0f * ( 0.5f - qx* qx - qy*qy) - accel.z() );
+    vecF.val(3, 2.0f*bx*(0.5f - qy*qy - qz*qz ) + 2.0f*bz*( qx*qz - qw*qy) - magn.x() );
+    vecF.val(4, 2.0f*bx*(qx* qy - qw*qz) + 2.0f*bz*(qw* qx + qy*qz) - magn.y() );
+    vecF.val(5, 2.0f*bx*(qw*qy + qx* qz) + 2.0f*bz*(0.5f - qx* qx - qy*qy) - magn.z() );
+
+    //# Transposed Jacobian (eq. 26)
+    BnMatrixN<4,6> matrJT;
+    matrJT.val( 0,0, -2.0f*qy );
+    matrJT.val( 1,0, 2.0f*qz );
+    matrJT.val( 2,0, -2.0f*qw );
+    matrJT.val( 3,0, 2.0f*qx );
+
+    matrJT.val( 0,1, 2.0f*qx );
+    matrJT.val( 1,1, 2.0f*qw );
+    matrJT.val( 2,1, 2.0f*qz );
+    matrJT.val( 3,1, 2.0f*qy );
+
+    matrJT.val( 0,2, 0.0f);
+    matrJT.val( 1,2, -4.0f*qx );
+    matrJT.val( 2,2, -4.0f*qy );
+    matrJT.val( 3,2, 0.0f );
+
+    matrJT.val( 0,3, -2.0f*bz*qy );
+    matrJT.val( 1,3, 2.0f*bz*qz );
+    matrJT.val( 2,3, -4.0f*bx*qy-2.0f*bz*qw );
+    matrJT.val( 3,3, -4.0f*bx*qz+2.0f*bz*qx );
+
+    matrJT.val( 0,4, -2.0f*bx*qz+2.0f*bz*qx );
+    matrJT.val( 1,4, 2.0f*bx*qy+2.0f*bz*qw );
+    matrJT.val( 2,4, 2.0f*bx*qx+2.0f*bz*qz );
+    matrJT.val( 3,4, -2.0f*bx*qw+2.0f*bz*qy );
+
+    matrJT.val( 0,5, 2.0f*bx*qy );
+    matrJT.val( 1,5, 2.0f*bx*qz-4.0f*bz*qx );
+    matrJT.val( 2,5, 2.0f*bx*qw-4.0f*bz*qy );
+    matrJT.val( 3,5, 2.0f*bx*qx  );
+
+    //# Objective Function Gradient
+    //# (eq. 34)
+    BnMatrixN<4,1>::multiply( gradient, matrJT, vecF );
+}
+
+void BnSensorFusionMadgwickAHRS::integrateIMUMatrix(const BnVec3 &gyro_i, BnVec3 &accel_i) {
+    //# (eq. 12)
+    const BnQuat quatGyro( 0, gyro_i.x(), gyro_i.y(), gyro_i.z() );
+    BnQuat qDot;
+    BnQuat::productHamilton( qDot, m_internalQuat, quatGyro );
+    qDot.multiply(0.5f);
+
+    accel_i.normalize();
+    m_internalQuat.normalize();
+
+    BnQuat gradient;
+    gradientIMUMatrix( m_internalQuat, accel_i, gradient );
+    gradient.normalize();
+    gradient.multiply(m_gain);
+    //# (eq. 33)
+    BnMatrixN<4,1>::subtract( qDot, qDot, gradient );
+
+    //# (eq. 13)
+    qDot.multiply( m_samplePeriod_s );
+    BnMatrixN<4,1>::sum( m_internalQuat, m_internalQuat, qDot );
+    m_internalQuat.normalize();
+}
+
+void BnSensorFusionMadgwickAHRS::integrateMAGRMatrix(const BnVec3 &gyro_i, BnVec3 &accel_i, BnVec3 &magn_i) {
+    //# (eq. 12)
+    const BnQuat quatGyro( 0, gyro_i.x(), gyro_i.y(), gyro_i.z() );
+    BnQuat qDot;
+    BnQuat::productHamilton( qDot, m_internalQuat, quatGyro );
+    qDot.multiply(0.5f);
+
+    accel_i.normalize();
+    magn_i.normalize();
+    m_internalQuat.normalize();
+
+    BnQuat gradient;
+    gradientMAGRMatrix( m_internalQuat, accel_i, magn_i, gradient );
+    gradient.normalize();
+    gradient.multiply(m_gain);
+    //# (eq. 33)
+    BnMatrixN<4,1>::subtract( qDot, qDot, gradient );
+
+    //# (eq. 13)
+    qDot.multiply( m_samplePeriod_s );
+    BnMatrixN<4,1>::sum( m_internalQuat, m_internalQuat, qDot );
+    m_internalQuat.normalize();
+}
+
+void BnSensorFusionMadgwickAHRS::getQuaternion(BnQuat &out) const {
+    out = m_internalQuat;
+}
+
+
+///////////////// BnSensorFusionMadgwickAHRS END
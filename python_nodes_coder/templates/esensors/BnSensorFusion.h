@@ -0,0 +1,383 @@
+/**
+* MIT License
+* 
+* Copyright (c) 2024-2026 Manuel Bottini
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+/*
+The implementation of the sensor fusion algorithm in BnOrientationAbsSensor took inspiration
+from here https://github.com/Mayitzin/ahrs/blob/master/ahrs/filters/madgwick.py
+Thank you Mario García for providing the code on GitHub.
+
+The algorithm here has been modified for the purpose of being practical in motion capture
+applications and Bodynodes in particular
+
+*/
+
+/**
+The MIT License (MIT)
+
+Copyright (c) 2019-2020, Mario García.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "BnNodeSpecific.h"
+
+#ifndef __BN_SENSOR_FUSION_H__
+#define __BN_SENSOR_FUSION_H__
+
+#include <stdio.h>
+#include <string.h>
+#include <cmath>
+#include <cstdint>
+
+// The Madgwick AHRS filter of the fusion orientation_abs sensor and the fixed-size matrices it
+// uses, apart from the sensor so that the host tests and benchmarks can run it on its own.
+
+// When set to 1 the fusion computes the Madgwick gradient with a closed-form scalar kernel,
+// as in the reference implementation from Madgwick. When set to 0 it builds the
+// transposed Jacobian and multiplies it by the objective function with BnMatrixN.
+// The two paths produce the same orientation, the scalar one just takes fewer cycles
+#ifndef BN_SENSOR_FUSION_SCALAR_KERNEL
+#define BN_SENSOR_FUSION_SCALAR_KERNEL 1
+#endif
+
+// Sample periods longer than this are treated as stalls rather than as samples
+#ifndef BN_SENSOR_FUSION_MAX_PERIOD_US
+#define BN_SENSOR_FUSION_MAX_PERIOD_US 100000
+#endif
+
+// Fixed-size matrices, vectors and quaternions.
+// The values live inside the object, so creating, copying and combining them
+// never touches the heap. They are meant for the sensor fusion, which runs at
+// every sensor read and cannot afford malloc/free on small MCUs.
+template<uint16_t ROWS, uint16_t COLUMNS>
+class BnMatrixN {
+public:
+
+    BnMatrixN();
+    BnMatrixN(const float *values);
+
+    float val(const uint16_t row, const uint16_t column) const;
+    void val(const uint16_t row, const uint16_t column, float value);
+
+    static constexpr uint16_t rows() { return ROWS; }
+    static constexpr uint16_t columns() { return COLUMNS; }
+    const float* values() const;
+    float* values();
+    void print() const;
+    BnMatrixN<COLUMNS, ROWS> transposed() const;
+    void multiply(const float mult);
+
+    template<uint16_t INNER>
+    static void multiply(BnMatrixN<ROWS, COLUMNS> &result, const BnMatrixN<ROWS, INNER> &matrL, const BnMatrixN<INNER, COLUMNS> &matrR );
+    static void sum(BnMatrixN<ROWS, COLUMNS> &result, const BnMatrixN<ROWS, COLUMNS> &matrL, const BnMatrixN<ROWS, COLUMNS> &matrR );
+    static void subtract(BnMatrixN<ROWS, COLUMNS> &result, const BnMatrixN<ROWS, COLUMNS> &matrL, const BnMatrixN<ROWS, COLUMNS> &matrR );
+    static bool equal( const BnMatrixN<ROWS, COLUMNS> &matrL, const BnMatrixN<ROWS, COLUMNS> &matrR );
+    static BnMatrixN<ROWS, COLUMNS> identity();
+
+protected:
+
+    float m_values[ROWS*COLUMNS];
+};
+
+template<uint16_t ROWS>
+class BnVectorN : public BnMatrixN<ROWS, 1> {
+
+public:
+
+    BnVectorN() : BnMatrixN<ROWS, 1>() {}
+    BnVectorN(const float *values) : BnMatrixN<ROWS, 1>(values) {}
+    BnVectorN(const BnMatrixN<ROWS, 1>& other) : BnMatrixN<ROWS, 1>(other) {}
+
+    float val(const uint16_t row) const { return this->m_values[row]; }
+    void val(const uint16_t row, float value) { this->m_values[row] = value; }
+    using BnMatrixN<ROWS, 1>::val;
+
+    float norm() const;
+    void normalize();
+
+    static void productElementwise(BnVectorN<ROWS> &result, const BnVectorN<ROWS> &vecL, const BnVectorN<ROWS> &vecR );
+};
+
+class BnVec3 : public BnVectorN<3> {
+
+public:
+
+    BnVec3() : BnVectorN<3>() {}
+    BnVec3(const float x_v, const float y_v, const float z_v) : BnVectorN<3>() {
+        x(x_v);
+        y(y_v);
+        z(z_v);
+    }
+    BnVec3(const BnMatrixN<3, 1>& other) : BnVectorN<3>(other) {}
+
+    float x() const { return m_values[0]; }
+    float y() const { return m_values[1]; }
+    float z() const { return m_values[2]; }
+    void x(const float value) { m_values[0] = value; }
+    void y(const float value) { m_values[1] = value; }
+    void z(const float value) { m_values[2] = value; }
+};
+
+class BnQuat : public BnVectorN<4> {
+
+public:
+
+    // Identity rotation
+    BnQuat() : BnVectorN<4>() {
+        w(1);
+    }
+    BnQuat(const float w_v, const float x_v, const float y_v, const float z_v) : BnVectorN<4>() {
+        w(w_v);
+        x(x_v);
+        y(y_v);
+        z(z_v);
+    }
+    BnQuat(const BnMatrixN<4, 1>& other) : BnVectorN<4>(other) {}
+
+    void conjugate();
+
+    float w() const { return m_values[0]; }
+    float x() const { return m_values[1]; }
+    float y() const { return m_values[2]; }
+    float z() const { return m_values[3]; }
+    void w(const float value) { m_values[0] = value; }
+    void x(const float value) { m_values[1] = value; }
+    void y(const float value) { m_values[2] = value; }
+    void z(const float value) { m_values[3] = value; }
+
+    static void productHamilton(BnQuat &result, const BnQuat &quatL, const BnQuat &quatR );
+};
+
+class BnSensorFusionMadgwickAHRS {
+
+public:
+
+    BnSensorFusionMadgwickAHRS(
+        const float samplePeriod_s,
+        const float gain,
+        const float rescaleGyro,
+        const BnVec3 &axisSigns);
+
+    void init(const BnQuat &initialQuat);
+
+    void updateIMU(
+        const BnVec3 &gyro,
+        const BnVec3 &accel,
+        const uint32_t time_now_us);
+    void updateMAGR(
+        const BnVec3 &gyro,
+        const BnVec3 &accel,
+        const BnVec3 &magn,
+        const uint32_t time_now_us);
+    void getQuaternion(BnQuat &out) const;
+
+    // One integration step over the current sample period, gyro_i in rad/s with the axis signs
+    // applied. The scalar kernel is the closed form of the BnMatrixN one, updateIMU and
+    // updateMAGR use the one selected with BN_SENSOR_FUSION_SCALAR_KERNEL.
+    // accel_i and magn_i can be normalized in place
+    void integrateIMU(const BnVec3 &gyro_i, BnVec3 &accel_i);
+    void integrateMAGR(const BnVec3 &gyro_i, BnVec3 &accel_i, BnVec3 &magn_i);
+    void integrateIMUMatrix(const BnVec3 &gyro_i, BnVec3 &accel_i);
+    void integrateMAGRMatrix(const BnVec3 &gyro_i, BnVec3 &accel_i, BnVec3 &magn_i);
+
+    // Objective function gradient (eq. 34), not normalized, for a unit quaternion and unit
+    // measurements: the closed form and the transposed Jacobian times the objective function
+    static void gradientIMU(const BnQuat &quat, const BnVec3 &accel, BnQuat &gradient);
+    static void gradientMAGR(const BnQuat &quat, const BnVec3 &accel, const BnVec3 &magn, BnQuat &gradient);
+    static void gradientIMUMatrix(const BnQuat &quat, const BnVec3 &accel, BnQuat &gradient);
+    static void gradientMAGRMatrix(const BnQuat &quat, const BnVec3 &accel, const BnVec3 &magn, BnQuat &gradient);
+
+private:
+
+    void updateSamplePeriod(const uint32_t time_now_us);
+
+    // Nominal period, used for the first sample and in place of outliers
+    float m_nominalSamplePeriod_s;
+    float m_samplePeriod_s;
+    float m_gain;
+    float m_rescaleGyro;
+    BnVec3 m_axisSigns;
+    BnQuat m_internalQuat;
+    uint32_t m_lastTime_us;
+    bool m_hasLastTime;
+
+};
+
+///////////////// BnMatrixN START
+
+template<uint16_t ROWS, uint16_t COLUMNS>
+BnMatrixN<ROWS, COLUMNS>::BnMatrixN() {
+    for(uint16_t el_counter = 0; el_counter < ROWS*COLUMNS; ++el_counter) {
+        m_values[el_counter] = 0;
+    }
+}
+
+template<uint16_t ROWS, uint16_t COLUMNS>
+BnMatrixN<ROWS, COLUMNS>::BnMatrixN(const float *values) {
+    memcpy(m_values, values, sizeof(m_values));
+}
+
+template<uint16_t ROWS, uint16_t COLUMNS>
+float BnMatrixN<ROWS, COLUMNS>::val(const uint16_t row, const uint16_t column) const {
+    return m_values[column + row * COLUMNS];
+}
+
+template<uint16_t ROWS, uint16_t COLUMNS>
+void BnMatrixN<ROWS, COLUMNS>::val(const uint16_t row, const uint16_t column, float value) {
+    m_values[column + row * COLUMNS] = value;
+}
+
+template<uint16_t ROWS, uint16_t COLUMNS>
+const float* BnMatrixN<ROWS, COLUMNS>::values() const {
+    return m_values;
+}
+
+template<uint16_t ROWS, uint16_t COLUMNS>
+float* BnMatrixN<ROWS, COLUMNS>::values() {
+    return m_values;
+}
+
+template<uint16_t ROWS, uint16_t COLUMNS>
+void BnMatrixN<ROWS, COLUMNS>::print() const {
+    for(uint16_t row_counter = 0; row_counter < ROWS; ++row_counter ){
+        for(uint16_t col_counter = 0; col_counter < COLUMNS; ++col_counter ){
+            printf("%.4f ",  val(row_counter, col_counter));
+        }
+        printf("\n");
+    }
+}
+
+template<uint16_t ROWS, uint16_t COLUMNS>
+BnMatrixN<COLUMNS, ROWS> BnMatrixN<ROWS, COLUMNS>::transposed() const {
+    BnMatrixN<COLUMNS, ROWS> transp;
+    for(uint16_t row_counter = 0; row_counter < ROWS; ++row_counter ){
+        for(uint16_t col_counter = 0; col_counter < COLUMNS; ++col_counter ){
+            transp.val(col_counter, row_counter, val(row_counter, col_counter));
+        }
+    }
+    return transp;
+}
+
+template<uint16_t ROWS, uint16_t COLUMNS>
+void BnMatrixN<ROWS, COLUMNS>::multiply(const float mult) {
+    for(uint16_t el_counter = 0; el_counter < ROWS*COLUMNS; ++el_counter) {
+        m_values[el_counter] *= mult;
+    }
+}
+
+// The shapes are checked at compile time, so there is no
+// runtime validation. The result must not alias one of the inputs
+template<uint16_t ROWS, uint16_t COLUMNS>
+template<uint16_t INNER>
+void BnMatrixN<ROWS, COLUMNS>::multiply(BnMatrixN<ROWS, COLUMNS> &result, const BnMatrixN<ROWS, INNER> &matrL, const BnMatrixN<INNER, COLUMNS> &matrR ) {
+    for(uint16_t row_counter = 0; row_counter < ROWS; ++row_counter ){
+        for(uint16_t col_counter = 0; col_counter < COLUMNS; ++col_counter ){
+            float res = 0;
+            for(uint16_t inner_counter = 0; inner_counter < INNER; ++inner_counter ){
+                res += matrL.val(row_counter, inner_counter) * matrR.val(inner_counter, col_counter);
+            }
+            result.val(row_counter, col_counter, res);
+        }
+    }
+}
+
+template<uint16_t ROWS, uint16_t COLUMNS>
+void BnMatrixN<ROWS, COLUMNS>::sum(BnMatrixN<ROWS, COLUMNS> &result, const BnMatrixN<ROWS, COLUMNS> &matrL, const BnMatrixN<ROWS, COLUMNS> &matrR ) {
+    for(uint16_t el_counter = 0; el_counter < ROWS*COLUMNS; ++el_counter) {
+        result.m_values[el_counter] = matrL.m_values[el_counter] + matrR.m_values[el_counter];
+    }
+}
+
+template<uint16_t ROWS, uint16_t COLUMNS>
+void BnMatrixN<ROWS, COLUMNS>::subtract(BnMatrixN<ROWS, COLUMNS> &result, const BnMatrixN<ROWS, COLUMNS> &matrL, const BnMatrixN<ROWS, COLUMNS> &matrR ) {
+    for(uint16_t el_counter = 0; el_counter < ROWS*COLUMNS; ++el_counter) {
+        result.m_values[el_counter] = matrL.m_values[el_counter] - matrR.m_values[el_counter];
+    }
+}
+
+template<uint16_t ROWS, uint16_t COLUMNS>
+bool BnMatrixN<ROWS, COLUMNS>::equal( const BnMatrixN<ROWS, COLUMNS> &matrL, const BnMatrixN<ROWS, COLUMNS> &matrR ) {
+    for(uint16_t el_counter = 0; el_counter < ROWS*COLUMNS; ++el_counter) {
+        if( std::fabs(matrL.m_values[el_counter] - matrR.m_values[el_counter]) > 0.0001f ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template<uint16_t ROWS, uint16_t COLUMNS>
+BnMatrixN<ROWS, COLUMNS> BnMatrixN<ROWS, COLUMNS>::identity() {
+    BnMatrixN<ROWS, COLUMNS> result;
+    for(uint16_t el_counter = 0; el_counter < ROWS && el_counter < COLUMNS; ++el_counter) {
+        result.val(el_counter, el_counter, 1);
+    }
+    return result;
+}
+
+template<uint16_t ROWS>
+float BnVectorN<ROWS>::norm() const {
+    float sum_squares = 0;
+    for(uint16_t elem_counter = 0; elem_counter < ROWS; ++elem_counter) {
+        sum_squares += this->m_values[elem_counter] * this->m_values[elem_counter];
+    }
+    return std::sqrt( sum_squares );
+}
+
+template<uint16_t ROWS>
+void BnVectorN<ROWS>::normalize() {
+    const float vec_norm = norm();
+    if( vec_norm == 0 ) {
+        // Nothing to normalize, avoiding to fill the vector with NaNs
+        return;
+    }
+    this->multiply( 1.0f / vec_norm );
+}
+
+template<uint16_t ROWS>
+void BnVectorN<ROWS>::productElementwise(BnVectorN<ROWS> &result, const BnVectorN<ROWS> &vecL, const BnVectorN<ROWS> &vecR ) {
+    for(uint16_t elems_counter = 0; elems_counter < ROWS; ++elems_counter ){
+        result.val(elems_counter, vecL.val(elems_counter) * vecR.val(elems_counter) );
+    }
+}
+
+///////////////// BnMatrixN END
+
+#endif // __BN_SENSOR_FUSION_H__
@@ -45,8 +45,8 @@ void BnShoeSensor::getData(int *values){
     DEBUG_PRINTLN(values[0]);
 }
 
-String BnShoeSensor::getType(){
-    return BN_SENSORTYPE_SHOE_TAG;
+BnType BnShoeSensor::getType(){
+    return BN_SENSORTYPE_SHOE;
 }
 
 void BnShoeSensor::setEnable(bool enable_status){
@@ -41,7 +41,7 @@ public:
     // Returns the data read
     void getData(int *values);
     // Returns the type of the sensor as string
-    String getType();
+    BnType getType();
     // Enable/Disable Sensor
     void setEnable(bool enable_status);
     // Returns if sensor is enabled or not
@@ -0,0 +1,130 @@
+/**
+* MIT License
+* 
+* Copyright (c) 2026 Manuel Bottini
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+// Host (Linux) implementation of the Arduino core API used by the Bodynodes templates.
+// It lets the generated project run on a PC for debugging and benchmarking, see the Makefile.
+// Time is the monotonic clock of the process, pins read as LOW, Serial is stdout.
+
+#ifndef __BN_HOST_ARDUINO_H
+#define __BN_HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+
+#include "WString.h"
+#include "Print.h"
+#include "Stream.h"
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#define CHANGE 1
+#define FALLING 2
+#define RISING 3
+
+#define A0 14
+
+#define IRAM_ATTR
+
+using std::min;
+using std::max;
+
+#ifndef constrain
+#define constrain(amt,low,high) ((amt)<(low)?(low):((amt)>(high)?(high):(amt)))
+#endif
+
+// They wrap around at 32 bits like on the boards.
+// Set BN_HOST_TIME_OFFSET_US in the environment to start close to the wrap around,
+// and BN_HOST_TIME_DRIFT_PPM to make the clock run faster (or slower if negative)
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+void analogWrite(uint8_t pin, int value);
+int digitalPinToInterrupt(uint8_t pin);
+void attachInterrupt(uint8_t interrupt, void (*callback)(void), int mode);
+void detachInterrupt(uint8_t interrupt);
+void noInterrupts();
+void interrupts();
+
+class IPAddress : public Printable {
+public:
+    IPAddress() : m_address{0, 0, 0, 0} {}
+    IPAddress(uint8_t first, uint8_t second, uint8_t third, uint8_t fourth) : m_address{first, second, third, fourth} {}
+    // Network byte order, as in a sockaddr_in
+    IPAddress(uint32_t address) { memcpy(m_address, &address, sizeof(m_address)); }
+
+    bool fromString(const char *address);
+    bool fromString(const String &address) { return fromString(address.c_str()); }
+    String toString() const;
+
+    operator uint32_t() const { uint32_t address; memcpy(&address, m_address, sizeof(address)); return address; }
+    bool operator==(const IPAddress &other) const { return memcmp(m_address, other.m_address, sizeof(m_address)) == 0; }
+    bool operator!=(const IPAddress &other) const { return !(*this == other); }
+    uint8_t operator[](int index) const { return m_address[index]; }
+    uint8_t &operator[](int index) { return m_address[index]; }
+
+    size_t printTo(Print &p) const override { return p.print(toString()); }
+
+private:
+    uint8_t m_address[4];
+};
+
+// Serial writes on stdout, and reads nothing
+class HardwareSerial : public Stream {
+public:
+    void begin(unsigned long baud) { (void) baud; }
+    void end() {}
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *buffer, size_t size) override;
+    using Print::write;
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+    void flush() override;
+    explicit operator bool() const { return true; }
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
+
+#endif // __BN_HOST_ARDUINO_H
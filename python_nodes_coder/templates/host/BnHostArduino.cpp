@@ -0,0 +1,488 @@
+/**
+* MIT License
+* 
+* Copyright (c) 2026 Manuel Bottini
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+// Implementation of the host Arduino shims, see Arduino.h
+
+#include "Arduino.h"
+#include "WiFi.h"
+#include "WiFiUdp.h"
+#include "EEPROM.h"
+
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+HardwareSerial Serial;
+HardwareSerial Serial1;
+WiFiClass WiFi;
+EEPROMClass EEPROM;
+
+// Time
+
+static uint64_t monotonicMicros() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000000ULL + now.tv_nsec / 1000;
+}
+
+static uint64_t startMicros() {
+    static const uint64_t sStart_us = monotonicMicros();
+    return sStart_us;
+}
+
+static uint64_t elapsedMicros() {
+    static const char *sOffsetStr = getenv("BN_HOST_TIME_OFFSET_US");
+    static const uint64_t sOffset_us = sOffsetStr != nullptr ? strtoull(sOffsetStr, nullptr, 10) : 0;
+    static const char *sDriftStr = getenv("BN_HOST_TIME_DRIFT_PPM");
+    static const double sDrift_ppm = sDriftStr != nullptr ? strtod(sDriftStr, nullptr) : 0;
+    uint64_t elapsed_us = monotonicMicros() - startMicros();
+    if(sDrift_ppm != 0) {
+        elapsed_us += static_cast<int64_t>(elapsed_us * sDrift_ppm / 1000000.0);
+    }
+    return elapsed_us + sOffset_us;
+}
+
+unsigned long micros() {
+    return static_cast<uint32_t>(elapsedMicros());
+}
+
+unsigned long millis() {
+    return static_cast<uint32_t>(elapsedMicros() / 1000);
+}
+
+void delay(unsigned long ms) {
+    usleep(ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us) {
+    usleep(us);
+}
+
+void yield() {
+}
+
+// Pins
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    (void) pin; (void) mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+    (void) pin; (void) value;
+}
+
+int digitalRead(uint8_t pin) {
+    (void) pin;
+    return LOW;
+}
+
+int analogRead(uint8_t pin) {
+    (void) pin;
+    return 0;
+}
+
+void analogWrite(uint8_t pin, int value) {
+    (void) pin; (void) value;
+}
+
+int digitalPinToInterrupt(uint8_t pin) {
+    return pin;
+}
+
+void attachInterrupt(uint8_t interrupt, void (*callback)(void), int mode) {
+    (void) interrupt; (void) callback; (void) mode;
+}
+
+void detachInterrupt(uint8_t interrupt) {
+    (void) interrupt;
+}
+
+void noInterrupts() {
+}
+
+void interrupts() {
+}
+
+// String
+
+static std::string numberToStr(unsigned long value, bool negative, unsigned char base) {
+    if(base < 2 || base > 36) {
+        base = 10;
+    }
+    char buf[8 * sizeof(unsigned long) + 2];
+    char *str = &buf[sizeof(buf) - 1];
+    *str = '\0';
+    do {
+        char digit = value % base;
+        *--str = digit < 10 ? '0' + digit : 'a' + digit - 10;
+        value /= base;
+    } while(value != 0);
+    if(negative) {
+        *--str = '-';
+    }
+    return std::string(str);
+}
+
+static std::string floatToStr(double value, unsigned char decimalPlaces) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.*f", decimalPlaces, value);
+    return std::string(buf);
+}
+
+String::String(unsigned char value, unsigned char base) : m_str(numberToStr(value, false, base)) {}
+String::String(int value, unsigned char base) : String(static_cast<long>(value), base) {}
+String::String(unsigned int value, unsigned char base) : m_str(numberToStr(value, false, base)) {}
+String::String(long value, unsigned char base)
+    : m_str(base == 10 && value < 0 ? numberToStr(0UL - static_cast<unsigned long>(value), true, base)
+                                     : numberToStr(static_cast<unsigned long>(value), false, base)) {}
+String::String(unsigned long value, unsigned char base) : m_str(numberToStr(value, false, base)) {}
+String::String(float value, unsigned char decimalPlaces) : m_str(floatToStr(value, decimalPlaces)) {}
+String::String(double value, unsigned char decimalPlaces) : m_str(floatToStr(value, decimalPlaces)) {}
+
+int String::indexOf(char c, unsigned int fromIndex) const {
+    size_t pos = m_str.find(c, fromIndex);
+    return pos == std::string::npos ? -1 : static_cast<int>(pos);
+}
+
+int String::indexOf(const String &str, unsigned int fromIndex) const {
+    size_t pos = m_str.find(str.m_str, fromIndex);
+    return pos == std::string::npos ? -1 : static_cast<int>(pos);
+}
+
+String String::substring(unsigned int beginIndex) const {
+    return substring(beginIndex, m_str.size());
+}
+
+String String::substring(unsigned int beginIndex, unsigned int endIndex) const {
+    if(beginIndex > endIndex) {
+        std::swap(beginIndex, endIndex);
+    }
+    if(beginIndex >= m_str.size()) {
+        return String();
+    }
+    return String(m_str.substr(beginIndex, endIndex - beginIndex));
+}
+
+void String::trim() {
+    size_t first = m_str.find_first_not_of(" \t\r\n\f\v");
+    if(first == std::string::npos) {
+        m_str.clear();
+        return;
+    }
+    size_t last = m_str.find_last_not_of(" \t\r\n\f\v");
+    m_str = m_str.substr(first, last - first + 1);
+}
+
+void String::toCharArray(char *buf, unsigned int bufsize, unsigned int index) const {
+    if(bufsize == 0 || buf == nullptr) {
+        return;
+    }
+    if(index >= m_str.size()) {
+        buf[0] = '\0';
+        return;
+    }
+    size_t len = std::min<size_t>(bufsize - 1, m_str.size() - index);
+    memcpy(buf, m_str.c_str() + index, len);
+    buf[len] = '\0';
+}
+
+StringSumHelper operator+(const String &lhs, const String &rhs) {
+    String sum(lhs);
+    sum.concat(rhs);
+    return sum;
+}
+
+StringSumHelper operator+(const String &lhs, const char *rhs) {
+    String sum(lhs);
+    sum.concat(rhs);
+    return sum;
+}
+
+StringSumHelper operator+(const char *lhs, const String &rhs) {
+    String sum(lhs);
+    sum.concat(rhs);
+    return sum;
+}
+
+StringSumHelper operator+(const String &lhs, char rhs) {
+    String sum(lhs);
+    sum.concat(rhs);
+    return sum;
+}
+
+// Print, Stream, Serial
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+    size_t n = 0;
+    while(size-- > 0 && write(*buffer++) == 1) {
+        ++n;
+    }
+    return n;
+}
+
+size_t Print::print(long value, int base) {
+    return print(String(value, static_cast<unsigned char>(base)));
+}
+
+size_t Print::print(unsigned long value, int base) {
+    return print(String(value, static_cast<unsigned char>(base)));
+}
+
+size_t Print::print(double value, int digits) {
+    return print(String(value, static_cast<unsigned char>(digits)));
+}
+
+size_t Stream::readBytes(char *buffer, size_t length) {
+    size_t count = 0;
+    while(count < length) {
+        int c = read();
+        if(c < 0) {
+            break;
+        }
+        buffer[count++] = static_cast<char>(c);
+    }
+    return count;
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+    return fputc(c, stdout) == EOF ? 0 : 1;
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size) {
+    return fwrite(buffer, 1, size, stdout);
+}
+
+void HardwareSerial::flush() {
+    fflush(stdout);
+}
+
+// IPAddress
+
+bool IPAddress::fromString(const char *address) {
+    struct in_addr parsed;
+    if(address == nullptr || inet_pton(AF_INET, address, &parsed) != 1) {
+        return false;
+    }
+    memcpy(m_address, &parsed.s_addr, sizeof(m_address));
+    return true;
+}
+
+String IPAddress::toString() const {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%u.%u.%u.%u", m_address[0], m_address[1], m_address[2], m_address[3]);
+    return String(buf);
+}
+
+// WiFi
+
+int WiFiClass::begin(const String &ssid, const String &password) {
+    (void) password;
+    m_ssid = ssid;
+    m_status = WL_CONNECTED;
+    // To try the node without a network, e.g. BN_HOST_WIFI_SSID=none
+    const char *ssidStr = getenv("BN_HOST_WIFI_SSID");
+    if(ssidStr != nullptr && ssid != ssidStr) {
+        m_status = WL_NO_SSID_AVAIL;
+    }
+    return m_status;
+}
+
+IPAddress WiFiClass::localIP() {
+    IPAddress address(127, 0, 0, 1);
+    const char *localIpStr = getenv("BN_HOST_LOCAL_IP");
+    if(localIpStr != nullptr) {
+        address.fromString(localIpStr);
+    }
+    return address;
+}
+
+// WiFiUDP
+
+WiFiUDP::~WiFiUDP() {
+    stop();
+}
+
+bool WiFiUDP::openSocket() {
+    if(m_fd >= 0) {
+        return true;
+    }
+    m_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if(m_fd < 0) {
+        perror("WiFiUDP socket");
+        return false;
+    }
+    int enable = 1;
+    setsockopt(m_fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+    setsockopt(m_fd, SOL_SOCKET, SO_BROADCAST, &enable, sizeof(enable));
+    fcntl(m_fd, F_SETFL, fcntl(m_fd, F_GETFL, 0) | O_NONBLOCK);
+    return true;
+}
+
+uint8_t WiFiUDP::begin(uint16_t port) {
+    stop();
+    if(!openSocket()) {
+        return 0;
+    }
+    struct sockaddr_in local = {};
+    local.sin_family = AF_INET;
+    local.sin_port = htons(port);
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    if(bind(m_fd, reinterpret_cast<struct sockaddr *>(&local), sizeof(local)) < 0) {
+        perror("WiFiUDP bind");
+        stop();
+        return 0;
+    }
+    return 1;
+}
+
+uint8_t WiFiUDP::beginMulticast(IPAddress interfaceAddr, IPAddress multicast, uint16_t port) {
+    (void) interfaceAddr;
+    if(!begin(port)) {
+        return 0;
+    }
+    IPAddress multicastIf(127, 0, 0, 1);
+    const char *multicastIfStr = getenv("BN_HOST_MULTICAST_IF");
+    if(multicastIfStr != nullptr) {
+        multicastIf.fromString(multicastIfStr);
+    }
+    struct ip_mreq membership = {};
+    membership.imr_multiaddr.s_addr = static_cast<uint32_t>(multicast);
+    membership.imr_interface.s_addr = static_cast<uint32_t>(multicastIf);
+    if(setsockopt(m_fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership, sizeof(membership)) < 0) {
+        perror("WiFiUDP IP_ADD_MEMBERSHIP");
+        stop();
+        return 0;
+    }
+    return 1;
+}
+
+void WiFiUDP::stop() {
+    if(m_fd >= 0) {
+        close(m_fd);
+        m_fd = -1;
+    }
+    m_in_len = 0;
+    m_in_pos = 0;
+}
+
+int WiFiUDP::beginPacket(IPAddress ip, uint16_t port) {
+    m_out_ip = ip;
+    m_out_port = port;
+    m_out_len = 0;
+    return openSocket() ? 1 : 0;
+}
+
+int WiFiUDP::beginPacket(const char *host, uint16_t port) {
+    IPAddress ip;
+    if(!ip.fromString(host)) {
+        return 0;
+    }
+    return beginPacket(ip, port);
+}
+
+size_t WiFiUDP::write(uint8_t c) {
+    if(m_out_len >= sizeof(m_out_packet)) {
+        return 0;
+    }
+    m_out_packet[m_out_len++] = c;
+    return 1;
+}
+
+size_t WiFiUDP::write(const uint8_t *buffer, size_t size) {
+    size_t len = std::min(size, sizeof(m_out_packet) - m_out_len);
+    memcpy(m_out_packet + m_out_len, buffer, len);
+    m_out_len += len;
+    return len;
+}
+
+int WiFiUDP::endPacket() {
+    if(m_fd < 0) {
+        return 0;
+    }
+    static const char *sRemotePortStr = getenv("BN_HOST_REMOTE_PORT");
+    struct sockaddr_in remote = {};
+    remote.sin_family = AF_INET;
+    remote.sin_port = htons(sRemotePortStr != nullptr ? atoi(sRemotePortStr) : m_out_port);
+    remote.sin_addr.s_addr = static_cast<uint32_t>(m_out_ip);
+    ssize_t sent = sendto(m_fd, m_out_packet, m_out_len, 0, reinterpret_cast<struct sockaddr *>(&remote), sizeof(remote));
+    m_out_len = 0;
+    return sent >= 0 ? 1 : 0;
+}
+
+int WiFiUDP::parsePacket() {
+    m_in_len = 0;
+    m_in_pos = 0;
+    if(m_fd < 0) {
+        return 0;
+    }
+    struct sockaddr_in remote = {};
+    socklen_t remote_len = sizeof(remote);
+    ssize_t received = recvfrom(m_fd, m_in_packet, sizeof(m_in_packet), 0, reinterpret_cast<struct sockaddr *>(&remote), &remote_len);
+    if(received <= 0) {
+        return 0;
+    }
+    m_in_len = received;
+    m_remote_ip = IPAddress(static_cast<uint32_t>(remote.sin_addr.s_addr));
+    m_remote_port = ntohs(remote.sin_port);
+    return m_in_len;
+}
+
+int WiFiUDP::read(unsigned char *buffer, size_t len) {
+    size_t count = std::min(len, static_cast<size_t>(m_in_len - m_in_pos));
+    memcpy(buffer, m_in_packet + m_in_pos, count);
+    m_in_pos += count;
+    return count;
+}
+
+// EEPROM
+
+static const char *eepromFile() {
+    const char *path = getenv("BN_HOST_EEPROM_FILE");
+    return path != nullptr ? path : "bn_eeprom.bin";
+}
+
+void EEPROMClass::begin(size_t size) {
+    m_size = std::min(size, sizeof(m_data));
+    // A blank EEPROM reads as 0xFF
+    memset(m_data, 0xFF, sizeof(m_data));
+    FILE *file = fopen(eepromFile(), "rb");
+    if(file != nullptr) {
+        size_t len = fread(m_data, 1, m_size, file);
+        (void) len;
+        fclose(file);
+    }
+}
+
+bool EEPROMClass::commit() {
+    FILE *file = fopen(eepromFile(), "wb");
+    if(file == nullptr) {
+        return false;
+    }
+    bool written = fwrite(m_data, 1, m_size, file) == m_size;
+    fclose(file);
+    return written;
+}
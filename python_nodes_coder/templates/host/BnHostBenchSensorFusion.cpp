@@ -0,0 +1,107 @@
+/**
+* MIT License
+* 
+* Copyright (c) 2026 Manuel Bottini
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+// Cost per sample of the two kernels of the Madgwick fusion (templates/esensors/BnSensorFusion.h),
+// with and without the magnetometer. Run with "make bench", the numbers are for this PC: on the
+// boards without a FPU the gap between the kernels is larger.
+// Each line is like
+//   BN_HOST_BENCH fusion_imu_scalar samples=N ns_per_sample=N cycles_per_sample=N
+// where the cycles are the x86 time stamp counter, 0 on the other CPUs.
+
+#include <chrono>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "BnSensorFusion.h"
+
+#define NUM_INPUTS 1024
+#define NUM_SAMPLES 2000000
+
+static BnVec3 sGyros[NUM_INPUTS];
+static BnVec3 sAccels[NUM_INPUTS];
+static BnVec3 sMagns[NUM_INPUTS];
+static volatile float sSink;
+
+static uint32_t sRandomState = 20260101;
+
+static float randomUniform(float low, float high) {
+    sRandomState = sRandomState * 1664525u + 1013904223u;
+    return low + (high - low) * ((sRandomState >> 8) / 16777216.0f);
+}
+
+static uint64_t cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+template<typename Step>
+static void bench(const char *name, Step step) {
+    BnSensorFusionMadgwickAHRS fusion(0.005f, 0.1f, 1.0f, BnVec3(1, 1, 1));
+    fusion.init(BnQuat());
+    const auto start_time = std::chrono::steady_clock::now();
+    const uint64_t start_cycles = cycles();
+    for(uint32_t sample = 0; sample < NUM_SAMPLES; ++sample) {
+        const uint32_t input = sample % NUM_INPUTS;
+        // The kernels normalize the measurements in place
+        BnVec3 accel = sAccels[input];
+        BnVec3 magn = sMagns[input];
+        step(fusion, sGyros[input], accel, magn);
+    }
+    const uint64_t end_cycles = cycles();
+    const auto end_time = std::chrono::steady_clock::now();
+    BnQuat quat;
+    fusion.getQuaternion(quat);
+    sSink = quat.w();
+    const double total_ns = std::chrono::duration<double, std::nano>(end_time - start_time).count();
+    printf("BN_HOST_BENCH %s samples=%u ns_per_sample=%.1f cycles_per_sample=%.1f\n", name, NUM_SAMPLES,
+        total_ns / NUM_SAMPLES, static_cast<double>(end_cycles - start_cycles) / NUM_SAMPLES);
+}
+
+int main() {
+    for(uint32_t input = 0; input < NUM_INPUTS; ++input) {
+        sGyros[input] = BnVec3(randomUniform(-4, 4), randomUniform(-4, 4), randomUniform(-4, 4));
+        sAccels[input] = BnVec3(randomUniform(-1, 1), randomUniform(-1, 1), 9.8f + randomUniform(-1, 1));
+        sMagns[input] = BnVec3(20 + randomUniform(-5, 5), randomUniform(-5, 5), -40 + randomUniform(-5, 5));
+    }
+
+    bench("fusion_imu_scalar", [](BnSensorFusionMadgwickAHRS &fusion, const BnVec3 &gyro, BnVec3 &accel, BnVec3 &magn) {
+        (void) magn;
+        fusion.integrateIMU(gyro, accel);
+    });
+    bench("fusion_imu_matrix", [](BnSensorFusionMadgwickAHRS &fusion, const BnVec3 &gyro, BnVec3 &accel, BnVec3 &magn) {
+        (void) magn;
+        fusion.integrateIMUMatrix(gyro, accel);
+    });
+    bench("fusion_magr_scalar", [](BnSensorFusionMadgwickAHRS &fusion, const BnVec3 &gyro, BnVec3 &accel, BnVec3 &magn) {
+        fusion.integrateMAGR(gyro, accel, magn);
+    });
+    bench("fusion_magr_matrix", [](BnSensorFusionMadgwickAHRS &fusion, const BnVec3 &gyro, BnVec3 &accel, BnVec3 &magn) {
+        fusion.integrateMAGRMatrix(gyro, accel, magn);
+    });
+    return 0;
+}
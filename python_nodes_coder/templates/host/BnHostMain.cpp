@@ -0,0 +1,96 @@
+/**
+* MIT License
+* 
+* Copyright (c) 2026 Manuel Bottini
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+// Entry point of the host build: it runs setup() once and then loop() until stopped,
+// measuring how long each loop() takes.
+//
+// Usage: bodynode_host [-n loops] [-t duration_ms]
+// Without arguments it runs until Ctrl+C. At exit it prints a summary line like
+//   BN_HOST_LOOP_STATS loops=N total_us=N avg_us=N min_us=N max_us=N
+// that can be parsed to catch performance regressions.
+
+#include "Arduino.h"
+
+#include <signal.h>
+
+void setup();
+void loop();
+
+static volatile sig_atomic_t sStop = 0;
+
+static void onSignal(int signum) {
+    (void) signum;
+    sStop = 1;
+}
+
+static void printUsage(const char *program) {
+    fprintf(stderr, "Usage: %s [-n loops] [-t duration_ms]\n", program);
+}
+
+int main(int argc, char **argv) {
+    unsigned long max_loops = 0;
+    unsigned long duration_ms = 0;
+    for(int index = 1; index < argc; ++index) {
+        if(strcmp(argv[index], "-n") == 0 && index + 1 < argc) {
+            max_loops = strtoul(argv[++index], nullptr, 10);
+        } else if(strcmp(argv[index], "-t") == 0 && index + 1 < argc) {
+            duration_ms = strtoul(argv[++index], nullptr, 10);
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    setup();
+
+    unsigned long start_time_ms = millis();
+    unsigned long loops = 0;
+    uint64_t total_us = 0;
+    uint32_t min_us = UINT32_MAX;
+    uint32_t max_us = 0;
+    while(!sStop) {
+        if(max_loops > 0 && loops >= max_loops) {
+            break;
+        }
+        if(duration_ms > 0 && millis() - start_time_ms >= duration_ms) {
+            break;
+        }
+        uint32_t loop_start_us = micros();
+        loop();
+        uint32_t loop_us = micros() - loop_start_us;
+        total_us += loop_us;
+        min_us = std::min(min_us, loop_us);
+        max_us = std::max(max_us, loop_us);
+        ++loops;
+    }
+
+    fflush(stdout);
+    fprintf(stderr, "BN_HOST_LOOP_STATS loops=%lu total_us=%llu avg_us=%.2f min_us=%u max_us=%u\n",
+        loops, static_cast<unsigned long long>(total_us), loops > 0 ? static_cast<double>(total_us) / loops : 0.0,
+        loops > 0 ? min_us : 0, max_us);
+    return 0;
+}
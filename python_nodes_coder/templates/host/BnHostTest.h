@@ -0,0 +1,63 @@
+/**
+* MIT License
+* 
+* Copyright (c) 2026 Manuel Bottini
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+// Checks for the host tests (BnHostTest*.cpp, see the Makefile). A failed check prints where it
+// is and the test goes on, bnTestResult() prints the summary and is the exit code of main().
+
+#ifndef __BN_HOST_TEST_H
+#define __BN_HOST_TEST_H
+
+#include <stdio.h>
+#include <math.h>
+
+static int sTestChecks = 0;
+static int sTestFailures = 0;
+
+static inline bool bnTestCheck(bool passed, const char *condition, const char *file, int line) {
+    ++sTestChecks;
+    if(!passed) {
+        ++sTestFailures;
+        printf("FAILED %s:%d: %s\n", file, line, condition);
+    }
+    return passed;
+}
+
+static inline bool bnTestCheckNear(double value, double expected, double tolerance, const char *condition, const char *file, int line) {
+    const bool passed = fabs(value - expected) <= tolerance;
+    if(!bnTestCheck(passed, condition, file, line)) {
+        printf("    value %.9g expected %.9g tolerance %.3g\n", value, expected, tolerance);
+    }
+    return passed;
+}
+
+static inline int bnTestResult(const char *name) {
+    printf("%s: %s, %d checks, %d failed\n", name, sTestFailures == 0 ? "PASSED" : "FAILED", sTestChecks, sTestFailures);
+    return sTestFailures == 0 ? 0 : 1;
+}
+
+#define BN_TEST_CHECK(condition) bnTestCheck((condition), #condition, __FILE__, __LINE__)
+#define BN_TEST_CHECK_NEAR(value, expected, tolerance) \
+    bnTestCheckNear((value), (expected), (tolerance), #value " ~ " #expected, __FILE__, __LINE__)
+
+#endif // __BN_HOST_TEST_H
@@ -0,0 +1,209 @@
+/**
+* MIT License
+* 
+* Copyright (c) 2026 Manuel Bottini
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+// BnChangeDetector (templates/node/BnChangeDetector.h): the policies, the first reading, hysteresis
+// and keepalive, and the traffic of the default orientation threshold on a synthetic motion.
+// Run with "make test".
+
+#include "BnHostTest.h"
+#include "BnChangeDetector.h"
+
+static void testQuaternionAngle() {
+    BnChangeDetector detector;
+    detector.setPolicy(BN_CHANGE_POLICY_QUATERNION_ANGLE, 0.01f);
+    detector.setMaxSilence(0);
+    const float half = 0.004f / 2;
+    const float quat[4] = { 1, 0, 0, 0 };
+    const float quat_neg[4] = { -1, 0, 0, 0 };
+    // 0.004 and 0.02 rad around x
+    const float quat_small[4] = { cosf(half), sinf(half), 0, 0 };
+    const float quat_big[4] = { cosf(0.01f), sinf(0.01f), 0, 0 };
+    BN_TEST_CHECK(detector.hasChanged(quat, 4, 0));
+    // q and -q are the same rotation
+    BN_TEST_CHECK(!detector.hasChanged(quat_neg, 4, 10));
+    BN_TEST_CHECK(!detector.hasChanged(quat_small, 4, 20));
+    BN_TEST_CHECK(detector.hasChanged(quat_big, 4, 30));
+    const float quat_big_neg[4] = { -quat_big[0], -quat_big[1], 0, 0 };
+    BN_TEST_CHECK(!detector.hasChanged(quat_big_neg, 4, 40));
+}
+
+// The previous bigChanges took an all-zero reading as "no data yet" and sent every following one
+static void testAllZeroFirstReading() {
+    BnChangeDetector detector;
+    detector.setPolicy(BN_CHANGE_POLICY_COMPONENT, 0);
+    detector.setMaxSilence(0);
+    const int zeros[9] = { 0 };
+    BN_TEST_CHECK(detector.hasChanged(zeros, 9, 0));
+    BN_TEST_CHECK(!detector.hasChanged(zeros, 9, 10));
+    BN_TEST_CHECK(!detector.hasChanged(zeros, 9, 20));
+    detector.reset();
+    BN_TEST_CHECK(detector.hasChanged(zeros, 9, 30));
+}
+
+static void testComponent() {
+    BnChangeDetector detector;
+    detector.setPolicy(BN_CHANGE_POLICY_COMPONENT, 5);
+    detector.setComponentThreshold(2, 0);
+    detector.setMaxSilence(0);
+    int values[3] = { 10, 10, 1 };
+    BN_TEST_CHECK(detector.hasChanged(values, 3, 0));
+    values[0] = 15;
+    BN_TEST_CHECK(!detector.hasChanged(values, 3, 10));
+    values[1] = 4;
+    BN_TEST_CHECK(detector.hasChanged(values, 3, 20));
+    // Any change of a component with threshold 0
+    values[2] = 0;
+    BN_TEST_CHECK(detector.hasChanged(values, 3, 30));
+    BN_TEST_CHECK(!detector.hasChanged(values, 3, 40));
+    // A different number of values is always sent
+    BN_TEST_CHECK(detector.hasChanged(values, 2, 50));
+}
+
+static void testVectorNorm() {
+    BnChangeDetector detector;
+    detector.setPolicy(BN_CHANGE_POLICY_VECTOR_NORM, 1);
+    detector.setMaxSilence(0);
+    float vec[3] = { 0, 0, 0 };
+    BN_TEST_CHECK(detector.hasChanged(vec, 3, 0));
+    // Every component below the threshold, the norm 1.04 above it
+    vec[0] = 0.6f;
+    vec[1] = 0.6f;
+    vec[2] = 0.6f;
+    BN_TEST_CHECK(detector.hasChanged(vec, 3, 10));
+    vec[0] = 1.5f;
+    BN_TEST_CHECK(!detector.hasChanged(vec, 3, 20));
+}
+
+static void testHysteresis() {
+    BnChangeDetector detector;
+    detector.setPolicy(BN_CHANGE_POLICY_VECTOR_NORM, 1);
+    detector.setHysteresis(0.25f);
+    detector.setMaxSilence(0);
+    float vec[1] = { 0 };
+    BN_TEST_CHECK(detector.hasChanged(vec, 1, 0));
+    vec[0] = 0.5f;
+    BN_TEST_CHECK(!detector.hasChanged(vec, 1, 10));
+    vec[0] = 1.5f;
+    BN_TEST_CHECK(detector.hasChanged(vec, 1, 20));
+    // Moving, the steps above threshold_low are sent
+    vec[0] = 1.8f;
+    BN_TEST_CHECK(detector.hasChanged(vec, 1, 30));
+    vec[0] = 1.9f;
+    BN_TEST_CHECK(!detector.hasChanged(vec, 1, 40));
+    // Stopped, back to the threshold
+    vec[0] = 2.5f;
+    BN_TEST_CHECK(!detector.hasChanged(vec, 1, 50));
+    vec[0] = 3.0f;
+    BN_TEST_CHECK(detector.hasChanged(vec, 1, 60));
+    // setPolicy clears the hysteresis
+    detector.setPolicy(BN_CHANGE_POLICY_VECTOR_NORM, 1);
+    vec[0] = 3.5f;
+    BN_TEST_CHECK(!detector.hasChanged(vec, 1, 70));
+}
+
+static void testKeepaliveAcrossMillisWrap() {
+    BnChangeDetector detector;
+    detector.setPolicy(BN_CHANGE_POLICY_QUATERNION_ANGLE, 0.01f);
+    detector.setMaxSilence(1000);
+    const float quat[4] = { 1, 0, 0, 0 };
+    const uint32_t start_ms = UINT32_MAX - 500;
+    BN_TEST_CHECK(detector.hasChanged(quat, 4, start_ms));
+    BN_TEST_CHECK(!detector.hasChanged(quat, 4, start_ms + 400));
+    // 999 ms later, after the wrap around
+    BN_TEST_CHECK(!detector.hasChanged(quat, 4, start_ms + 999));
+    BN_TEST_CHECK(detector.hasChanged(quat, 4, start_ms + 1000));
+    BN_TEST_CHECK(!detector.hasChanged(quat, 4, start_ms + 1500));
+    BN_TEST_CHECK(detector.hasChanged(quat, 4, start_ms + 2000));
+    detector.setMaxSilence(0);
+    BN_TEST_CHECK(!detector.hasChanged(quat, 4, start_ms + 10000));
+}
+
+// The bigChanges of the previous versions: any component moved more than BIG_QUAT_DIFF, no keepalive
+static bool previousBigChanges(const float values[], float prev_values[]) {
+    for(uint8_t index = 0; index < 4; ++index) {
+        if(fabsf(values[index] - prev_values[index]) > BIG_QUAT_DIFF) {
+            for(uint8_t copy = 0; copy < 4; ++copy) {
+                prev_values[copy] = values[copy];
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+static uint32_t sRandomState = 20260101;
+
+static float randomUniform(float low, float high) {
+    sRandomState = sRandomState * 1664525u + 1013904223u;
+    return low + (high - low) * ((sRandomState >> 8) / 16777216.0f);
+}
+
+// 20 s sampled every 30 ms: rest, a 1 Hz arm swing, rest, a slow turn, with about 0.1 degrees of
+// noise. The default orientation threshold must not send more than the previous rule
+static void testDefaultTraffic() {
+    BnChangeDetector detector;
+    detector.setPolicy(BN_CHANGE_POLICY_QUATERNION_ANGLE, BIG_QUAT_ANGLE);
+    float prev_values[4] = { 0 };
+    uint32_t num_readings = 0;
+    uint32_t num_sent = 0;
+    uint32_t num_sent_previous = 0;
+    for(uint32_t now_ms = 0; now_ms < 20000; now_ms += 30) {
+        const float time_s = now_ms / 1000.0f;
+        float pitch = 0;
+        float yaw = 0;
+        if(time_s >= 4 && time_s < 10) {
+            pitch = 0.6f * sinf(2 * M_PI * (time_s - 4));
+        } else if(time_s >= 14) {
+            yaw = 0.3f * (time_s - 14);
+        }
+        pitch += randomUniform(-0.0009f, 0.0009f);
+        yaw += randomUniform(-0.0009f, 0.0009f);
+        const float quat[4] = {
+            cosf(pitch / 2) * cosf(yaw / 2),
+            -sinf(pitch / 2) * sinf(yaw / 2),
+            sinf(pitch / 2) * cosf(yaw / 2),
+            cosf(pitch / 2) * sinf(yaw / 2)
+        };
+        ++num_readings;
+        if(previousBigChanges(quat, prev_values)) {
+            ++num_sent_previous;
+        }
+        if(detector.hasChanged(quat, 4, now_ms)) {
+            ++num_sent;
+        }
+    }
+    printf("%u orientations, default sends %u, previous rule sent %u\n", num_readings, num_sent, num_sent_previous);
+    BN_TEST_CHECK(num_sent <= num_sent_previous);
+}
+
+int main() {
+    testQuaternionAngle();
+    testAllZeroFirstReading();
+    testComponent();
+    testVectorNorm();
+    testHysteresis();
+    testKeepaliveAcrossMillisWrap();
+    testDefaultTraffic();
+    return bnTestResult("BnHostTestChangeDetector");
+}
@@ -0,0 +1,140 @@
+/**
+* MIT License
+* 
+* Copyright (c) 2026 Manuel Bottini
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+// Time step of the Madgwick fusion (templates/esensors/BnSensorFusion.h): updateIMU integrates each
+// sample over the microseconds since the previous one. A body turning at a constant rate is replayed
+// at several sample rates with jitter, across the micros() wrap around and through a stall, and the
+// orientation must stay close to the true one. Run with "make test".
+
+#include "BnHostTest.h"
+#include "BnSensorFusion.h"
+
+#define NOMINAL_PERIOD_US 5000
+// rad/s around z, the gravity is on z so the accelerometer does not pull the heading
+#define TURN_RATE 1.0f
+#define MAX_ERROR_DEG 0.05
+
+static uint32_t sRandomState = 20260101;
+
+static float randomUniform(float low, float high) {
+    sRandomState = sRandomState * 1664525u + 1013904223u;
+    return low + (high - low) * ((sRandomState >> 8) / 16777216.0f);
+}
+
+static BnSensorFusionMadgwickAHRS createFusion() {
+    BnSensorFusionMadgwickAHRS fusion(NOMINAL_PERIOD_US * 1e-6f, 0.1f, 1.0f, BnVec3(1, 1, 1));
+    fusion.init(BnQuat());
+    return fusion;
+}
+
+// Heading in radians of a rotation around z
+static double headingOf(const BnSensorFusionMadgwickAHRS &fusion) {
+    BnQuat quat;
+    fusion.getQuaternion(quat);
+    return 2.0 * atan2(quat.z(), quat.w());
+}
+
+static double headingErrorDeg(double heading, double expected) {
+    const double error = remainder(heading - expected, 2.0 * M_PI);
+    return fabs(error) * 180.0 / M_PI;
+}
+
+// Feeds the samples of duration_s at period_us, each one off by up to jitter of the period.
+// Returns the time of the last sample. The first sample has no previous one and is integrated
+// over the nominal period, see elapsedOf
+static uint32_t replay(BnSensorFusionMadgwickAHRS &fusion, uint32_t start_us, uint32_t period_us, float jitter, double duration_s) {
+    const BnVec3 gyro(0, 0, TURN_RATE);
+    const BnVec3 accel(0, 0, 9.81f);
+    uint32_t time_us = start_us;
+    const uint32_t num_samples = static_cast<uint32_t>(duration_s * 1e6 / period_us);
+    for(uint32_t sample = 0; sample < num_samples; ++sample) {
+        fusion.updateIMU(gyro, accel, time_us);
+        time_us += static_cast<uint32_t>(period_us * (1.0f + randomUniform(-jitter, jitter)));
+    }
+    fusion.updateIMU(gyro, accel, time_us);
+    return time_us;
+}
+
+// Time integrated by the fusion between start_us and end_us
+static double elapsedOf(uint32_t start_us, uint32_t end_us) {
+    return (static_cast<uint32_t>(end_us - start_us) + NOMINAL_PERIOD_US) * 1e-6;
+}
+
+static void testRates() {
+    const uint32_t periods_us[] = { 20000, 10000, 5000, 2000, 1000 };
+    for(uint32_t period_us : periods_us) {
+        BnSensorFusionMadgwickAHRS fusion = createFusion();
+        const uint32_t start_us = 1000000;
+        const uint32_t end_us = replay(fusion, start_us, period_us, 0.2f, 10.0);
+        const double expected = TURN_RATE * elapsedOf(start_us, end_us);
+        const double error_deg = headingErrorDeg(headingOf(fusion), expected);
+        printf("%5u us period, 10 s with 20%% jitter: heading error %.4f deg\n", period_us, error_deg);
+        BN_TEST_CHECK(error_deg <= MAX_ERROR_DEG);
+    }
+}
+
+static void testMicrosWrap() {
+    BnSensorFusionMadgwickAHRS fusion = createFusion();
+    // 2.5 s before the wrap around
+    const uint32_t start_us = UINT32_MAX - 2500000u;
+    const uint32_t end_us = replay(fusion, start_us, NOMINAL_PERIOD_US, 0.2f, 5.0);
+    BN_TEST_CHECK(end_us < start_us);
+    const double expected = TURN_RATE * elapsedOf(start_us, end_us);
+    const double error_deg = headingErrorDeg(headingOf(fusion), expected);
+    printf("micros() wrap around: heading error %.4f deg\n", error_deg);
+    BN_TEST_CHECK(error_deg <= MAX_ERROR_DEG);
+}
+
+// A gap longer than BN_SENSOR_FUSION_MAX_PERIOD_US is integrated as one nominal period, a shorter
+// one over its own length
+static void testStall() {
+    const BnVec3 gyro(0, 0, TURN_RATE);
+    const BnVec3 accel(0, 0, 9.81f);
+    const uint32_t gaps_us[] = { BN_SENSOR_FUSION_MAX_PERIOD_US / 2, 2000000 };
+    for(uint32_t gap_us : gaps_us) {
+        BnSensorFusionMadgwickAHRS fusion = createFusion();
+        const uint32_t last_us = replay(fusion, 0, NOMINAL_PERIOD_US, 0.0f, 1.0);
+        const double before = headingOf(fusion);
+        fusion.updateIMU(gyro, accel, last_us + gap_us);
+        const double step = remainder(headingOf(fusion) - before, 2.0 * M_PI);
+        const uint32_t integrated_us = gap_us > BN_SENSOR_FUSION_MAX_PERIOD_US ? NOMINAL_PERIOD_US : gap_us;
+        printf("%7u us gap: heading step %.5f rad\n", gap_us, step);
+        BN_TEST_CHECK_NEAR(step, TURN_RATE * integrated_us * 1e-6, 1e-4);
+
+        // The samples after the stall are integrated normally, the first one repeats the last time
+        // so it adds nothing
+        const double after = headingOf(fusion);
+        const uint32_t start_us = last_us + gap_us;
+        const uint32_t end_us = replay(fusion, start_us, NOMINAL_PERIOD_US, 0.2f, 1.0);
+        const double error_deg = headingErrorDeg(headingOf(fusion), after + TURN_RATE * (end_us - start_us) * 1e-6);
+        BN_TEST_CHECK(error_deg <= MAX_ERROR_DEG);
+    }
+}
+
+int main() {
+    testRates();
+    testMicrosWrap();
+    testStall();
+    return bnTestResult("BnHostTestFusionTimeStep");
+}
@@ -0,0 +1,123 @@
+/**
+* MIT License
+* 
+* Copyright (c) 2026 Manuel Bottini
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+// Magnetometer of the LSM9DS1 (templates/isensors/BnISensorArduinoLSM9DS1.h): its readings are brought
+// into the accelerometer and gyroscope frame before the fusion. A still node in a known pose gives the
+// readings of the chip, and the heading found by the MARG fusion must be the one of the pose.
+// Run with "make test".
+
+#include "BnHostTest.h"
+#include "BnSensorFusion.h"
+#include "BnISensorArduinoLSM9DS1.h"
+
+#define NUM_SAMPLES 4000
+#define MAX_YAW_ERROR_DEG 1.0
+// Inclination of the earth magnetic field, pointing down
+#define INCLINATION_RAD 1.1f
+
+struct Pose {
+    float yaw_deg;
+    float pitch_deg;
+    float roll_deg;
+};
+
+static float toRad(float deg) {
+    return deg * static_cast<float>(M_PI) / 180.0f;
+}
+
+// Earth vector in the node frame: the transpose of the rotation Rz(yaw) Ry(pitch) Rx(roll)
+static BnVec3 toNodeFrame(const Pose &pose, const BnVec3 &earth) {
+    const float cy = cosf(toRad(pose.yaw_deg)), sy = sinf(toRad(pose.yaw_deg));
+    const float cp = cosf(toRad(pose.pitch_deg)), sp = sinf(toRad(pose.pitch_deg));
+    const float cr = cosf(toRad(pose.roll_deg)), sr = sinf(toRad(pose.roll_deg));
+    const float rot[3][3] = {
+        { cy * cp, cy * sp * sr - sy * cr, cy * sp * cr + sy * sr },
+        { sy * cp, sy * sp * sr + cy * cr, sy * sp * cr - cy * sr },
+        { -sp, cp * sr, cp * cr }
+    };
+    BnVec3 node;
+    for(uint8_t row = 0; row < 3; ++row) {
+        node.val(row, rot[0][row] * earth.x() + rot[1][row] * earth.y() + rot[2][row] * earth.z());
+    }
+    return node;
+}
+
+static float yawDegOf(const BnQuat &quat) {
+    const float yaw = atan2f(2 * (quat.w() * quat.z() + quat.x() * quat.y()),
+        1 - 2 * (quat.y() * quat.y() + quat.z() * quat.z()));
+    return yaw * 180.0f / static_cast<float>(M_PI);
+}
+
+static float angleDiffDeg(float angle, float expected) {
+    return fabsf(remainderf(angle - expected, 360.0f));
+}
+
+// Heading found by the fusion from the chip readings, aligned or as the chip gives them
+static float fusedYawDeg(const Pose &pose, bool align) {
+    const BnVec3 accel = toNodeFrame(pose, BnVec3(0, 0, 9.81f));
+    const BnVec3 magn_node = toNodeFrame(pose, BnVec3(40 * cosf(INCLINATION_RAD), 0, -40 * sinf(INCLINATION_RAD)));
+    // What IMU.readMagneticField gives
+    float magn_chip[3] = { -magn_node.x(), magn_node.y(), magn_node.z() };
+    if(align) {
+        BnISensorLSM9DS1_alignMagn(magn_chip);
+    }
+    const BnVec3 magn(magn_chip[0], magn_chip[1], magn_chip[2]);
+
+    BnSensorFusionMadgwickAHRS fusion(0.01f, 0.5f, 1.0f, BnVec3(1, 1, 1));
+    fusion.init(BnQuat());
+    uint32_t time_us = 0;
+    for(uint32_t sample = 0; sample < NUM_SAMPLES; ++sample) {
+        fusion.updateMAGR(BnVec3(0, 0, 0), accel, magn, time_us);
+        time_us += 10000;
+    }
+    BnQuat quat;
+    fusion.getQuaternion(quat);
+    return yawDegOf(quat);
+}
+
+static void testPoses() {
+    const Pose poses[] = {
+        { 0, 0, 0 },
+        { 30, 0, 0 },
+        { 120, 20, -15 },
+        { -100, -25, 30 },
+        { 170, 10, 40 }
+    };
+    for(const Pose &pose : poses) {
+        const float yaw_error = angleDiffDeg(fusedYawDeg(pose, true), pose.yaw_deg);
+        const float raw_yaw_error = angleDiffDeg(fusedYawDeg(pose, false), pose.yaw_deg);
+        printf("yaw %6.1f pitch %5.1f roll %5.1f: heading error %.3f deg aligned, %.1f deg as read\n",
+            pose.yaw_deg, pose.pitch_deg, pose.roll_deg, yaw_error, raw_yaw_error);
+        BN_TEST_CHECK(yaw_error <= MAX_YAW_ERROR_DEG);
+        if(pose.yaw_deg != 0) {
+            // The readings as the chip gives them point to a mirrored north
+            BN_TEST_CHECK(raw_yaw_error > 10 * MAX_YAW_ERROR_DEG);
+        }
+    }
+}
+
+int main() {
+    testPoses();
+    return bnTestResult("BnHostTestMagnAxes");
+}
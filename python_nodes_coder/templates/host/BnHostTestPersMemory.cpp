@@ -0,0 +1,209 @@
+/**
+* MIT License
+* 
+* Copyright (c) 2026 Manuel Bottini
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+// BnPersMemory (templates/node/BnArduinoUtils.h) on a memory written byte by byte, like the EEPROM of
+// the RedBear Duo: the writes are cut after each number of bytes, as by a reset, and the values read
+// at the next start must be the ones before or after the change that was being written.
+// Run with "make test".
+
+#include "BnHostTest.h"
+#include "BnArduinoUtils.h"
+#include "EEPROM.h"
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#define TEST_EEPROM_FILE "bn_eeprom_test.bin"
+#define NUM_CHANGES 40
+
+static const BnMemoryKey sChangedKeys[3] = {
+    BN_MEMORY_KEY_BODYPART, BN_MEMORY_KEY_WIFI_SSID, BN_MEMORY_KEY_WIFI_PASSWORD
+};
+
+struct MemoryState {
+    std::string values[3];
+
+    bool operator==(const MemoryState &other) const {
+        return values[0] == other.values[0] && values[1] == other.values[1] && values[2] == other.values[2];
+    }
+};
+
+static MemoryState readState() {
+    MemoryState state;
+    for(uint8_t index = 0; index < 3; ++index) {
+        state.values[index] = BnPersMemory::getValue(sChangedKeys[index]).c_str();
+    }
+    return state;
+}
+
+static void eraseMemory() {
+    remove(TEST_EEPROM_FILE);
+    EEPROM.loseWritesAfter(-1);
+}
+
+// What is in the memory is kept, and read again from the start
+static void restart() {
+    EEPROM.loseWritesAfter(-1);
+    EEPROM.commit();
+    BnPersMemory::init();
+}
+
+static void setupMemory() {
+    eraseMemory();
+    BnPersMemory::init();
+    BnPersMemory::setValue(BN_MEMORY_KEY_PLAYER, "player_kept");
+}
+
+// Change number index, each one a different value of one of the keys
+static void applyChange(uint16_t index, MemoryState &state) {
+    const uint8_t key_index = index % 3;
+    const std::string value = "value_" + std::to_string(index) + "_of_key_" + std::to_string(key_index);
+    BnPersMemory::setValue(sChangedKeys[key_index], value.c_str());
+    state.values[key_index] = value;
+}
+
+// Many appends and compactions into both banks, cut after every write
+static void testChangesCut() {
+    setupMemory();
+    std::vector<MemoryState> states(1, readState());
+    std::vector<uint32_t> writes_done;
+    const uint32_t start_writes = EEPROM.writes();
+    for(uint16_t index = 0; index < NUM_CHANGES; ++index) {
+        MemoryState state = states.back();
+        applyChange(index, state);
+        states.push_back(state);
+        writes_done.push_back(EEPROM.writes() - start_writes);
+    }
+    BN_TEST_CHECK(readState() == states.back());
+    restart();
+    BN_TEST_CHECK(readState() == states.back());
+
+    uint32_t num_cuts = 0;
+    uint32_t num_wrong = 0;
+    for(uint32_t max_writes = 0; max_writes <= writes_done.back(); ++max_writes) {
+        setupMemory();
+        EEPROM.loseWritesAfter(max_writes);
+        MemoryState ignored = states.front();
+        for(uint16_t index = 0; index < NUM_CHANGES; ++index) {
+            applyChange(index, ignored);
+        }
+        restart();
+        uint16_t num_done = 0;
+        while(num_done < NUM_CHANGES && writes_done[num_done] <= max_writes) {
+            ++num_done;
+        }
+        const MemoryState state = readState();
+        const bool before = state == states[num_done];
+        const bool after = num_done < NUM_CHANGES && state == states[num_done + 1];
+        if((!before && !after) || BnPersMemory::getValue(BN_MEMORY_KEY_PLAYER) != "player_kept") {
+            if(num_wrong == 0) {
+                printf("Cut after %u writes, in change %u: %s %s %s\n", max_writes, num_done,
+                    state.values[0].c_str(), state.values[1].c_str(), state.values[2].c_str());
+            }
+            ++num_wrong;
+        }
+        ++num_cuts;
+    }
+    printf("%u changes cut at %u points, %u wrong values after the restart\n", NUM_CHANGES, num_cuts, num_wrong);
+    BN_TEST_CHECK(num_wrong == 0);
+}
+
+// Layout of the versions before the log
+static void writeLegacyValue(uint16_t addr_nbytes, const char *value) {
+    const uint8_t len = strlen(value) + 1;
+    EEPROM.write(addr_nbytes, len);
+    for(uint8_t index = 0; index < len; ++index) {
+        EEPROM.write(addr_nbytes + 1 + index, index + 1 < len ? value[index] : 0);
+    }
+}
+
+static void writeLegacyMemory() {
+    eraseMemory();
+    EEPROM.begin(512);
+    const uint8_t checkkey[5] = {0x00, 0x00, 0x00, 0x00, 0x01};
+    for(uint8_t index = 0; index < 5; ++index) {
+        EEPROM.write(index, checkkey[index]);
+    }
+    writeLegacyValue(50, "legacy_player");
+    writeLegacyValue(100, "legacy_bodypart");
+    writeLegacyValue(150, "legacy_glove");
+    writeLegacyValue(200, "legacy_shoe");
+    writeLegacyValue(250, "legacy_ssid_with_a_long_name");
+    writeLegacyValue(300, "legacy_password");
+    writeLegacyValue(350, "legacy_multicast");
+    writeLegacyValue(400, "1.0,2.0,3.0,1.1,1.2,1.3");
+    EEPROM.commit();
+}
+
+// The move to the log cut after every write: the values are the old ones, or the defaults for the
+// ones stored where the log is written
+static void testLegacyCut() {
+    writeLegacyMemory();
+    const uint32_t start_writes = EEPROM.writes();
+    BnPersMemory::init();
+    const uint32_t move_writes = EEPROM.writes() - start_writes;
+    BN_TEST_CHECK(BnPersMemory::getValue(BN_MEMORY_KEY_WIFI_PASSWORD) == "legacy_password");
+    restart();
+    BN_TEST_CHECK(BnPersMemory::getValue(BN_MEMORY_KEY_WIFI_SSID) == "legacy_ssid_with_a_long_name");
+    BN_TEST_CHECK(BnPersMemory::getValue(BN_MEMORY_KEY_MAGN_CALIBRATION) == "1.0,2.0,3.0,1.1,1.2,1.3");
+
+    uint32_t num_wrong = 0;
+    uint32_t num_defaults = 0;
+    for(uint32_t max_writes = 0; max_writes <= move_writes; ++max_writes) {
+        writeLegacyMemory();
+        EEPROM.loseWritesAfter(max_writes);
+        BnPersMemory::init();
+        restart();
+        const bool kept = BnPersMemory::getValue(BN_MEMORY_KEY_PLAYER) == "legacy_player"
+            && BnPersMemory::getValue(BN_MEMORY_KEY_BODYPART) == "legacy_bodypart"
+            && BnPersMemory::getValue(BN_MEMORY_KEY_BODYPART_GLOVE) == "legacy_glove"
+            && BnPersMemory::getValue(BN_MEMORY_KEY_BODYPART_SHOE) == "legacy_shoe";
+        const bool legacy = BnPersMemory::getValue(BN_MEMORY_KEY_WIFI_SSID) == "legacy_ssid_with_a_long_name"
+            && BnPersMemory::getValue(BN_MEMORY_KEY_WIFI_PASSWORD) == "legacy_password"
+            && BnPersMemory::getValue(BN_MEMORY_KEY_WIFI_MULTICASTMESSAGE) == "legacy_multicast"
+            && BnPersMemory::getValue(BN_MEMORY_KEY_MAGN_CALIBRATION) == "1.0,2.0,3.0,1.1,1.2,1.3";
+        const bool defaults = BnPersMemory::getValue(BN_MEMORY_KEY_WIFI_SSID) == BN_WIFI_SSID_DEFAULT
+            && BnPersMemory::getValue(BN_MEMORY_KEY_WIFI_PASSWORD) == BN_WIFI_PASSWORD_DEFAULT
+            && BnPersMemory::getValue(BN_MEMORY_KEY_WIFI_MULTICASTMESSAGE) == BN_WIFI_MULTICASTMESSAGE_DEFAULT
+            && BnPersMemory::getValue(BN_MEMORY_KEY_MAGN_CALIBRATION) == "";
+        if(!kept || (!legacy && !defaults) || (max_writes >= move_writes && !legacy)) {
+            ++num_wrong;
+        }
+        if(defaults) {
+            ++num_defaults;
+        }
+    }
+    printf("Move to the log of %u writes cut at each one, %u back to the defaults, %u wrong\n",
+        move_writes, num_defaults, num_wrong);
+    BN_TEST_CHECK(num_wrong == 0);
+}
+
+int main() {
+    setenv("BN_HOST_EEPROM_FILE", TEST_EEPROM_FILE, 1);
+    testChangesCut();
+    testLegacyCut();
+    remove(TEST_EEPROM_FILE);
+    return bnTestResult("BnHostTestPersMemory");
+}
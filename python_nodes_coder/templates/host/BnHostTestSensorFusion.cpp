@@ -0,0 +1,176 @@
+/**
+* MIT License
+* 
+* Copyright (c) 2026 Manuel Bottini
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+// Equivalence of the two kernels of the Madgwick fusion (templates/esensors/BnSensorFusion.h):
+// the closed-form scalar gradients must match the transposed Jacobian times the objective
+// function, and integrating the same IMU and MARG samples with each kernel must give the same
+// orientation. Run with "make test".
+
+#include "BnHostTest.h"
+#include "BnSensorFusion.h"
+
+// Relative error of the scalar gradients. The scalar kernel uses a fast inverse square root (relative
+// error about 1e-5), which the MAGR gradient amplifies when it is small
+#define GRADIENT_TOLERANCE 1e-3
+// Degrees between the orientations of the two kernels
+#define ORIENTATION_TOLERANCE_DEG 0.01
+
+#define SAMPLE_PERIOD_S 0.005f
+#define GAIN 0.1f
+
+static uint32_t sRandomState = 20260101;
+
+// Same numbers on every run
+static float randomUniform(float low, float high) {
+    sRandomState = sRandomState * 1664525u + 1013904223u;
+    return low + (high - low) * ((sRandomState >> 8) / 16777216.0f);
+}
+
+static BnQuat randomQuat() {
+    BnQuat quat(randomUniform(-1, 1), randomUniform(-1, 1), randomUniform(-1, 1), randomUniform(-1, 1));
+    quat.normalize();
+    return quat;
+}
+
+static BnVec3 randomUnitVec3() {
+    BnVec3 vec(randomUniform(-1, 1), randomUniform(-1, 1), randomUniform(-1, 1));
+    vec.normalize();
+    return vec;
+}
+
+static double gradientError(const BnQuat &scalar, const BnQuat &matrix) {
+    double difference = 0;
+    double norm = 0;
+    for(uint16_t index = 0; index < 4; ++index) {
+        const double delta = scalar.val(index) - matrix.val(index);
+        difference += delta * delta;
+        norm += static_cast<double>(matrix.val(index)) * matrix.val(index);
+    }
+    return sqrt(difference) / (norm > 1e-12 ? sqrt(norm) : 1.0);
+}
+
+// Rotation angle between the two orientations, q and -q are the same
+static double angleDeg(const BnQuat &quatL, const BnQuat &quatR) {
+    double minus = 0;
+    double plus = 0;
+    for(uint16_t index = 0; index < 4; ++index) {
+        const double valueL = quatL.val(index);
+        const double valueR = quatR.val(index);
+        minus += (valueL - valueR) * (valueL - valueR);
+        plus += (valueL + valueR) * (valueL + valueR);
+    }
+    const double chord = sqrt(minus < plus ? minus : plus);
+    return 4.0 * asin(chord < 2.0 ? chord / 2.0 : 1.0) * 180.0 / M_PI;
+}
+
+static void testGradients() {
+    double maxErrorIMU = 0;
+    double maxErrorMAGR = 0;
+    for(int sample = 0; sample < 10000; ++sample) {
+        const BnQuat quat = randomQuat();
+        const BnVec3 accel = randomUnitVec3();
+        const BnVec3 magn = randomUnitVec3();
+
+        BnQuat scalar;
+        BnQuat matrix;
+        BnSensorFusionMadgwickAHRS::gradientIMU(quat, accel, scalar);
+        BnSensorFusionMadgwickAHRS::gradientIMUMatrix(quat, accel, matrix);
+        maxErrorIMU = fmax(maxErrorIMU, gradientError(scalar, matrix));
+
+        BnSensorFusionMadgwickAHRS::gradientMAGR(quat, accel, magn, scalar);
+        BnSensorFusionMadgwickAHRS::gradientMAGRMatrix(quat, accel, magn, matrix);
+        maxErrorMAGR = fmax(maxErrorMAGR, gradientError(scalar, matrix));
+    }
+    printf("gradient IMU max relative error %.3g, MAGR %.3g\n", maxErrorIMU, maxErrorMAGR);
+    BN_TEST_CHECK(maxErrorIMU <= GRADIENT_TOLERANCE);
+    BN_TEST_CHECK(maxErrorMAGR <= GRADIENT_TOLERANCE);
+}
+
+// The body turns with a gyroscope that changes a bit at every sample, the accelerometer and the
+// magnetometer are the gravity and the field seen from the body, plus noise
+static void testIntegration(bool useMagn) {
+    BnSensorFusionMadgwickAHRS scalarFusion(SAMPLE_PERIOD_S, GAIN, 1.0f, BnVec3(1, 1, 1));
+    BnSensorFusionMadgwickAHRS matrixFusion(SAMPLE_PERIOD_S, GAIN, 1.0f, BnVec3(1, 1, 1));
+    const BnQuat initialQuat = randomQuat();
+    scalarFusion.init(initialQuat);
+    matrixFusion.init(initialQuat);
+
+    BnQuat bodyQuat = initialQuat;
+    BnVec3 gyro(0, 0, 0);
+    double maxAngleDeg = 0;
+    for(int sample = 0; sample < 20000; ++sample) {
+        gyro = BnVec3(
+            fminf(fmaxf(gyro.x() + randomUniform(-0.2f, 0.2f), -4.0f), 4.0f),
+            fminf(fmaxf(gyro.y() + randomUniform(-0.2f, 0.2f), -4.0f), 4.0f),
+            fminf(fmaxf(gyro.z() + randomUniform(-0.2f, 0.2f), -4.0f), 4.0f));
+        BnQuat bodyStep;
+        BnQuat::productHamilton(bodyStep, bodyQuat, BnQuat(1, 0.5f * SAMPLE_PERIOD_S * gyro.x(),
+            0.5f * SAMPLE_PERIOD_S * gyro.y(), 0.5f * SAMPLE_PERIOD_S * gyro.z()));
+        bodyQuat = bodyStep;
+        bodyQuat.normalize();
+
+        // Gravity [0, 0, 1] and field [0.5, 0, -0.8] in the body frame, R(q)^T v
+        const float qw = bodyQuat.w();
+        const float qx = bodyQuat.x();
+        const float qy = bodyQuat.y();
+        const float qz = bodyQuat.z();
+        BnVec3 accel(2 * (qx * qz - qw * qy), 2 * (qw * qx + qy * qz), 1 - 2 * (qx * qx + qy * qy));
+        BnVec3 magn(
+            0.5f * (1 - 2 * (qy * qy + qz * qz)) - 0.8f * 2 * (qx * qz - qw * qy),
+            0.5f * 2 * (qx * qy - qw * qz) - 0.8f * 2 * (qw * qx + qy * qz),
+            0.5f * 2 * (qx * qz + qw * qy) - 0.8f * (1 - 2 * (qx * qx + qy * qy)));
+        for(uint16_t index = 0; index < 3; ++index) {
+            accel.val(index, accel.val(index) + randomUniform(-0.05f, 0.05f));
+            magn.val(index, magn.val(index) + randomUniform(-0.05f, 0.05f));
+        }
+
+        // The kernels normalize the measurements in place
+        BnVec3 scalarAccel = accel;
+        BnVec3 matrixAccel = accel;
+        if(useMagn) {
+            BnVec3 scalarMagn = magn;
+            BnVec3 matrixMagn = magn;
+            scalarFusion.integrateMAGR(gyro, scalarAccel, scalarMagn);
+            matrixFusion.integrateMAGRMatrix(gyro, matrixAccel, matrixMagn);
+        } else {
+            scalarFusion.integrateIMU(gyro, scalarAccel);
+            matrixFusion.integrateIMUMatrix(gyro, matrixAccel);
+        }
+
+        BnQuat scalarQuat;
+        BnQuat matrixQuat;
+        scalarFusion.getQuaternion(scalarQuat);
+        matrixFusion.getQuaternion(matrixQuat);
+        maxAngleDeg = fmax(maxAngleDeg, angleDeg(scalarQuat, matrixQuat));
+    }
+    printf("%s orientation max difference %.3g deg\n", useMagn ? "MAGR" : "IMU", maxAngleDeg);
+    BN_TEST_CHECK(maxAngleDeg <= ORIENTATION_TOLERANCE_DEG);
+}
+
+int main() {
+    testGradients();
+    testIntegration(false);
+    testIntegration(true);
+    return bnTestResult("BnHostTestSensorFusion");
+}
@@ -0,0 +1,79 @@
+/**
+* MIT License
+* 
+* Copyright (c) 2026 Manuel Bottini
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+// Host implementation of the EEPROM, backed by a file so that the memory survives restarts.
+// The file is BN_HOST_EEPROM_FILE in the environment, bn_eeprom.bin otherwise
+
+#ifndef __BN_HOST_EEPROM_H
+#define __BN_HOST_EEPROM_H
+
+#include "Arduino.h"
+
+#define BN_HOST_EEPROM_MAX_BYTES 4096
+
+class EEPROMClass {
+public:
+    void begin(size_t size);
+    bool commit();
+    void end() { commit(); }
+
+    uint8_t read(int address) const { return isValid(address, 1) ? m_data[address] : 0; }
+    void write(int address, uint8_t value) {
+        if(m_writes_left == 0) { return; }
+        if(m_writes_left > 0) { --m_writes_left; }
+        ++m_writes;
+        if(isValid(address, 1)) { m_data[address] = value; }
+    }
+
+    template<typename T>
+    T &get(int address, T &t) const {
+        if(isValid(address, sizeof(T))) { memcpy(&t, m_data + address, sizeof(T)); }
+        return t;
+    }
+    template<typename T>
+    const T &put(int address, const T &t) {
+        if(isValid(address, sizeof(T))) { memcpy(m_data + address, &t, sizeof(T)); }
+        return t;
+    }
+
+    size_t length() const { return m_size; }
+
+    // For the host tests: the writes after the next max_writes ones are lost, as at a reset.
+    // -1 for no limit
+    void loseWritesAfter(int max_writes) { m_writes_left = max_writes; }
+    // Number of writes that reached the memory
+    uint32_t writes() const { return m_writes; }
+
+private:
+    bool isValid(int address, size_t len) const { return address >= 0 && address + len <= m_size; }
+
+    uint8_t m_data[BN_HOST_EEPROM_MAX_BYTES];
+    size_t m_size = 0;
+    int m_writes_left = -1;
+    uint32_t m_writes = 0;
+};
+
+extern EEPROMClass EEPROM;
+
+#endif // __BN_HOST_EEPROM_H
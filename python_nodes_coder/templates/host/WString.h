@@ -0,0 +1,104 @@
+/**
+* MIT License
+* 
+* Copyright (c) 2026 Manuel Bottini
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+// Host implementation of the Arduino String, only the part used by the Bodynodes
+// templates and by ArduinoJson
+
+#ifndef __BN_HOST_WSTRING_H
+#define __BN_HOST_WSTRING_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+class String {
+public:
+    String() {}
+    String(const char *cstr) : m_str(cstr ? cstr : "") {}
+    String(const std::string &str) : m_str(str) {}
+    explicit String(char c) : m_str(1, c) {}
+    explicit String(unsigned char value, unsigned char base = 10);
+    explicit String(int value, unsigned char base = 10);
+    explicit String(unsigned int value, unsigned char base = 10);
+    explicit String(long value, unsigned char base = 10);
+    explicit String(unsigned long value, unsigned char base = 10);
+    explicit String(float value, unsigned char decimalPlaces = 2);
+    explicit String(double value, unsigned char decimalPlaces = 2);
+
+    unsigned int length() const { return m_str.size(); }
+    const char *c_str() const { return m_str.c_str(); }
+    bool reserve(unsigned int size) { m_str.reserve(size); return true; }
+
+    char charAt(unsigned int index) const { return index < m_str.size() ? m_str[index] : 0; }
+    char operator[](unsigned int index) const { return charAt(index); }
+    char &operator[](unsigned int index) { return m_str[index]; }
+
+    bool equals(const String &other) const { return m_str == other.m_str; }
+    bool equals(const char *other) const { return m_str == (other ? other : ""); }
+    bool operator==(const String &other) const { return equals(other); }
+    bool operator==(const char *other) const { return equals(other); }
+    bool operator!=(const String &other) const { return !equals(other); }
+    bool operator!=(const char *other) const { return !equals(other); }
+    bool startsWith(const String &prefix) const { return m_str.compare(0, prefix.m_str.size(), prefix.m_str) == 0; }
+
+    bool concat(const String &other) { m_str += other.m_str; return true; }
+    bool concat(const char *cstr) { if(cstr) { m_str += cstr; } return cstr != nullptr; }
+    bool concat(const char *cstr, unsigned int length) { if(cstr) { m_str.append(cstr, length); } return cstr != nullptr; }
+    bool concat(char c) { m_str += c; return true; }
+    String &operator+=(const String &other) { concat(other); return *this; }
+    String &operator+=(const char *cstr) { concat(cstr); return *this; }
+    String &operator+=(char c) { concat(c); return *this; }
+
+    int indexOf(char c, unsigned int fromIndex = 0) const;
+    int indexOf(const String &str, unsigned int fromIndex = 0) const;
+    String substring(unsigned int beginIndex) const;
+    String substring(unsigned int beginIndex, unsigned int endIndex) const;
+    void remove(unsigned int index) { if(index < m_str.size()) { m_str.erase(index); } }
+    void remove(unsigned int index, unsigned int count) { if(index < m_str.size()) { m_str.erase(index, count); } }
+    void trim();
+
+    long toInt() const { return atol(m_str.c_str()); }
+    float toFloat() const { return atof(m_str.c_str()); }
+    void toCharArray(char *buf, unsigned int bufsize, unsigned int index = 0) const;
+    void getBytes(unsigned char *buf, unsigned int bufsize, unsigned int index = 0) const {
+        toCharArray(reinterpret_cast<char *>(buf), bufsize, index);
+    }
+
+private:
+    std::string m_str;
+};
+
+// The result type of the + operators, ArduinoJson expects it to exist
+class StringSumHelper : public String {
+public:
+    StringSumHelper(const String &str) : String(str) {}
+};
+
+StringSumHelper operator+(const String &lhs, const String &rhs);
+StringSumHelper operator+(const String &lhs, const char *rhs);
+StringSumHelper operator+(const char *lhs, const String &rhs);
+StringSumHelper operator+(const String &lhs, char rhs);
+
+#endif // __BN_HOST_WSTRING_H
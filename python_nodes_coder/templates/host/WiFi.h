@@ -0,0 +1,72 @@
+/**
+* MIT License
+* 
+* Copyright (c) 2026 Manuel Bottini
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+// Host implementation of the WiFi object: the PC is already on a network, so it just reports
+// being connected once begin() is called. With BN_HOST_WIFI_SSID set, only that network is found
+
+#ifndef __BN_HOST_WIFI_H
+#define __BN_HOST_WIFI_H
+
+#include "Arduino.h"
+
+#define WL_IDLE_STATUS     0
+#define WL_NO_SSID_AVAIL   1
+#define WL_SCAN_COMPLETED  2
+#define WL_CONNECTED       3
+#define WL_CONNECT_FAILED  4
+#define WL_CONNECTION_LOST 5
+#define WL_DISCONNECTED    6
+
+#define WIFI_STA 1
+#define ENC_TYPE_NONE 7
+
+class WiFiClass {
+public:
+    int begin(const String &ssid, const String &password);
+    int status() { return m_status; }
+    bool disconnect(bool wifioff = false) { (void) wifioff; m_status = WL_DISCONNECTED; return true; }
+    bool softAPdisconnect(bool wifioff = false) { (void) wifioff; return true; }
+    bool enableAP(bool enable) { (void) enable; return true; }
+    bool mode(int mode) { (void) mode; return true; }
+
+    // BN_HOST_LOCAL_IP in the environment, 127.0.0.1 otherwise
+    IPAddress localIP();
+    IPAddress gatewayIP() { return localIP(); }
+    String SSID() { return m_ssid; }
+    long RSSI() { return -40; }
+
+    int scanNetworks() { return 0; }
+    String SSID(int index) { (void) index; return String(); }
+    long RSSI(int index) { (void) index; return 0; }
+    int channel(int index) { (void) index; return 0; }
+    int encryptionType(int index) { (void) index; return ENC_TYPE_NONE; }
+
+private:
+    int m_status = WL_IDLE_STATUS;
+    String m_ssid;
+};
+
+extern WiFiClass WiFi;
+
+#endif // __BN_HOST_WIFI_H
@@ -0,0 +1,82 @@
+/**
+* MIT License
+* 
+* Copyright (c) 2026 Manuel Bottini
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+// Host implementation of WiFiUDP on top of real UDP sockets, so that the node can talk
+// to a Bodynodes host running on the same PC (loopback) or on the local network.
+// Set BN_HOST_REMOTE_PORT in the environment to redirect every outgoing packet to another
+// port, needed when the host runs on the same PC and cannot share BN_WIFI_PORT with the node.
+// Set BN_HOST_MULTICAST_IF to the local address of the interface joining the multicast
+// group, 127.0.0.1 by default.
+
+#ifndef __BN_HOST_WIFIUDP_H
+#define __BN_HOST_WIFIUDP_H
+
+#include "Arduino.h"
+
+#define BN_HOST_UDP_MAX_PACKET_BYTES 1472
+
+class WiFiUDP : public Stream {
+public:
+    ~WiFiUDP();
+
+    uint8_t begin(uint16_t port);
+    uint8_t beginMulticast(IPAddress interfaceAddr, IPAddress multicast, uint16_t port);
+    void stop();
+
+    int beginPacket(IPAddress ip, uint16_t port);
+    int beginPacket(const char *host, uint16_t port);
+    int endPacket();
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *buffer, size_t size) override;
+    using Print::write;
+
+    int parsePacket();
+    int available() override { return m_in_len - m_in_pos; }
+    int read() override { return m_in_pos < m_in_len ? m_in_packet[m_in_pos++] : -1; }
+    int read(unsigned char *buffer, size_t len);
+    int read(char *buffer, size_t len) { return read(reinterpret_cast<unsigned char *>(buffer), len); }
+    int peek() override { return m_in_pos < m_in_len ? m_in_packet[m_in_pos] : -1; }
+    void flush() override { m_in_pos = m_in_len; }
+
+    IPAddress remoteIP() const { return m_remote_ip; }
+    uint16_t remotePort() const { return m_remote_port; }
+
+private:
+    bool openSocket();
+
+    int m_fd = -1;
+
+    uint8_t m_out_packet[BN_HOST_UDP_MAX_PACKET_BYTES];
+    size_t m_out_len = 0;
+    IPAddress m_out_ip;
+    uint16_t m_out_port = 0;
+
+    uint8_t m_in_packet[BN_HOST_UDP_MAX_PACKET_BYTES];
+    int m_in_len = 0;
+    int m_in_pos = 0;
+    IPAddress m_remote_ip;
+    uint16_t m_remote_port = 0;
+};
+
+#endif // __BN_HOST_WIFIUDP_H
@@ -27,12 +27,45 @@
 #ifndef __BN_ISENSOR_H__
 #define __BN_ISENSOR_H__
 
+// Acquisition layer: the isensors that have an on-chip FIFO (MPU6050, LSM9DS1) keep it running
+// at their own sample rate and move its samples into a ring, each with the time it was taken.
+// The fusion drains the ring with getSample() and integrates every sample, getData() keeps
+// returning the newest values for the other esensors. Set it to 0 to go back to polling.
+#ifndef BN_ISENSOR_ACQUISITION
+#define BN_ISENSOR_ACQUISITION 1
+#endif
+
+// Samples kept between two drains, at 200 Hz 32 samples cover 155 ms of blocked loop
+#ifndef BN_ISENSOR_RING_SIZE
+#define BN_ISENSOR_RING_SIZE 32
+#endif
+
+// Accelerometer, gyroscope and, when has_magn, magnetometer read at the same instant
+struct BnISensorSample {
+    uint32_t timestamp_us;
+    float accel[3];
+    float gyro[3];
+    float magn[3];
+    bool has_magn;
+};
+
 class BnISensor {
 public:
 
     bool init();
     bool isCalibrated();
     bool getData(float values[], const int type);
+    // Changes every time getData() has a new reading of the chip, the esensors that read in the
+    // same tick get the same reading and the same sequence number
+    uint32_t getSequence();
+    // Tells if the sensor is able to provide the BN_ISENSOR_DATATYPE_* type
+    bool hasDataType(const int type);
+    // Tells if the isensor fills the samples ring, see BN_ISENSOR_ACQUISITION
+    bool hasAcquisition();
+    // Oldest sample not taken yet, false if there are none
+    bool getSample(BnISensorSample &sample);
+    // Samples lost because the ring or the chip FIFO were full
+    uint32_t getDroppedSamples();
     void setStatus(int sensor_status);    
 };
 
@@ -23,6 +23,7 @@
 */
 
 #include "BnISensor.h"
+#include "BnISensorArduinoLSM9DS1.h"
 
 #ifdef __BN_ISENSOR_H__
 
@@ -31,6 +32,55 @@
 
 static bool sIsInit = false;
 static BnStatusLED sStatusSensorLED;
+static uint32_t sSequence = 0;
+
+#if BN_ISENSOR_ACQUISITION
+
+#include "BnRingBuffer.h"
+
+// Output data rate of the accelerometer and gyroscope set by the Arduino_LSM9DS1 library
+#define BN_LSM9DS1_SAMPLE_PERIOD_US 8403
+
+static BnRingBuffer<BnISensorSample, BN_ISENSOR_RING_SIZE> sRing;
+static uint32_t sDroppedSamples = 0;
+static BnISensorSample sLatest;
+static bool sHasLatest = false;
+
+// In continuous mode the library reads the accelerometer and gyroscope from the FIFO, so every
+// sample has to go through the ring. The magnetometer is not in the FIFO, the samples carry
+// the newest one
+static void pumpFifo(){
+    // The newest sample is the one just taken, the others come one period before each other
+    int frames = IMU.accelerationAvailable();
+    const int gyro_frames = IMU.gyroscopeAvailable();
+    if(gyro_frames < frames){
+        frames = gyro_frames;
+    }
+    if(frames <= 0){
+        return;
+    }
+    const uint32_t newest_us = micros();
+    if(IMU.magneticFieldAvailable()){
+        IMU.readMagneticField(sLatest.magn[0], sLatest.magn[1], sLatest.magn[2]);
+        BnISensorLSM9DS1_alignMagn(sLatest.magn);
+        sLatest.has_magn = true;
+    }
+    for(int frame = 0; frame < frames; ++frame){
+        sLatest.timestamp_us = newest_us - (frames - 1 - frame) * BN_LSM9DS1_SAMPLE_PERIOD_US;
+        IMU.readAcceleration(sLatest.accel[0], sLatest.accel[1], sLatest.accel[2]);
+        IMU.readGyroscope(sLatest.gyro[0], sLatest.gyro[1], sLatest.gyro[2]);
+        if(!sRing.push(sLatest)){
+            ++sDroppedSamples;
+        }
+    }
+    sHasLatest = true;
+    ++sSequence;
+}
+
+#endif // BN_ISENSOR_ACQUISITION
+
+// Indexed by BN_ISENSOR_DATATYPE_*: accelerometer, gyroscope, magnetometer, absolute orientation
+static const bool sDataTypes[BN_ISENSOR_NUM_DATATYPES] = { true, true, true, false };
 
 bool BnISensor::init(){
 
@@ -40,6 +90,12 @@ bool BnISensor::init(){
 
     /* Initialise the sensor */
     if( IMU.begin() ){
+#if BN_ISENSOR_ACQUISITION
+         IMU.setContinuousMode();
+         sRing.clear();
+         sHasLatest = false;
+         sLatest.has_magn = false;
+#endif // BN_ISENSOR_ACQUISITION
          setStatus(BN_SENSOR_STATUS_WORKING);
     } else {
          setStatus(BN_SENSOR_STATUS_NOT_ACCESSIBLE);
@@ -48,7 +104,12 @@ bool BnISensor::init(){
 }
 
 bool BnISensor::isCalibrated(){
+#if BN_ISENSOR_ACQUISITION
+    pumpFifo();
+    if( sHasLatest && sLatest.has_magn ){
+#else
     if( IMU.gyroscopeAvailable() && IMU.accelerationAvailable() && IMU.magneticFieldAvailable() ){
+#endif // BN_ISENSOR_ACQUISITION
         setStatus(BN_SENSOR_STATUS_WORKING);
         return true;
     } else {
@@ -68,6 +129,27 @@ bool BnISensor::getData(float values[], const int type){
     DEBUG_PRINT(", ");
     DEBUG_PRINTLN(s_values[3]);
     */
+#if BN_ISENSOR_ACQUISITION
+    pumpFifo();
+    if( !sHasLatest ){
+        return false;
+    }
+    const float *latest;
+    if( type == BN_ISENSOR_DATATYPE_ACCELEROMETER ){
+        latest = sLatest.accel;
+    } else if( type == BN_ISENSOR_DATATYPE_GYROSCOPE ){
+        latest = sLatest.gyro;
+    } else if( type == BN_ISENSOR_DATATYPE_MAGNETOMETER && sLatest.has_magn ){
+        latest = sLatest.magn;
+    } else {
+        return false;
+    }
+    values[0] = latest[0];
+    values[1] = latest[1];
+    values[2] = latest[2];
+    return true;
+#else
+    ++sSequence;
     if( type == BN_ISENSOR_DATATYPE_ACCELEROMETER ){
         float accx;
         float accy;
@@ -87,20 +169,52 @@ bool BnISensor::getData(float values[], const int type){
         values[2] = gyroz;
         return true;        
     } else if( type == BN_ISENSOR_DATATYPE_MAGNETOMETER ){
-        float magnx;
-        float magny;
-        float magnz;
-        IMU.readMagneticField(magnx, magny, magnz);  // outputs in uT
-        values[0] = magnx;
-        values[1] = magny;
-        values[2] = magnz;
+        IMU.readMagneticField(values[0], values[1], values[2]);  // outputs in uT
+        BnISensorLSM9DS1_alignMagn(values);
         return true;
     } else if( type == BN_ISENSOR_DATATYPE_ABSOLUTEORIENTATION ){
         return false;        
     } else {
         return false;
     }
+#endif // BN_ISENSOR_ACQUISITION
+}
+
+uint32_t BnISensor::getSequence(){
+    return sSequence;
+}
+
+bool BnISensor::hasDataType(const int type){
+    if(type < 0 || type >= BN_ISENSOR_NUM_DATATYPES){
+        return false;
+    }
+    return sDataTypes[type];
+}
+
+bool BnISensor::hasAcquisition(){
+    return BN_ISENSOR_ACQUISITION;
+}
+
+bool BnISensor::getSample(BnISensorSample &sample){
+#if BN_ISENSOR_ACQUISITION
+    if(!sIsInit){
+        return false;
+    }
+    if(sRing.isEmpty()){
+        pumpFifo();
+    }
+    return sRing.pop(sample);
+#else
+    return false;
+#endif // BN_ISENSOR_ACQUISITION
+}
 
+uint32_t BnISensor::getDroppedSamples(){
+#if BN_ISENSOR_ACQUISITION
+    return sDroppedSamples;
+#else
+    return 0;
+#endif // BN_ISENSOR_ACQUISITION
 }
 
 void BnISensor::setStatus(int sensor_status){
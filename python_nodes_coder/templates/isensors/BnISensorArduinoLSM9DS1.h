@@ -0,0 +1,35 @@
+/**
+* MIT License
+* 
+* Copyright (c) 2026 Manuel Bottini
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#ifndef __BN_ISENSOR_ARDUINO_LSM9DS1_H__
+#define __BN_ISENSOR_ARDUINO_LSM9DS1_H__
+
+// The magnetometer of the LSM9DS1 has its X axis reversed from the one of the accelerometer and
+// gyroscope (datasheet, pin connections figure). Brings a reading of IMU.readMagneticField into
+// the accelerometer and gyroscope frame, so the fusion sees all the vectors in the same frame
+inline void BnISensorLSM9DS1_alignMagn(float magn[3]) {
+    magn[0] = -magn[0];
+}
+
+#endif // __BN_ISENSOR_ARDUINO_LSM9DS1_H__
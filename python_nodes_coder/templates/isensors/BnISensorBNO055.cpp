@@ -36,6 +36,10 @@ TwoWire sWire(0);
 static Adafruit_BNO055 s_BNO;
 static bool sIsInit = false;
 static BnStatusLED sStatusSensorLED;
+static uint32_t sSequence = 0;
+
+// Indexed by BN_ISENSOR_DATATYPE_*: accelerometer, gyroscope, magnetometer, absolute orientation
+static const bool sDataTypes[BN_ISENSOR_NUM_DATATYPES] = { true, true, true, true };
 
 bool BnISensor::init(){
     if(sIsInit){
@@ -87,7 +91,8 @@ bool BnISensor::isCalibrated(){
 }
 
 bool BnISensor::getData(float values[], const int type){
-
+    // Every call is a new read of the chip
+    ++sSequence;
 
     if( type == BN_ISENSOR_DATATYPE_ACCELEROMETER ){
         imu::Vector<3> vector_acc = s_BNO.getVector(Adafruit_BNO055::VECTOR_ACCELEROMETER);
@@ -132,6 +137,31 @@ bool BnISensor::getData(float values[], const int type){
 
 }
 
+uint32_t BnISensor::getSequence(){
+    return sSequence;
+}
+
+bool BnISensor::hasDataType(const int type){
+    if(type < 0 || type >= BN_ISENSOR_NUM_DATATYPES){
+        return false;
+    }
+    return sDataTypes[type];
+}
+
+bool BnISensor::hasAcquisition(){
+    // The BNO055 fuses on chip, there is nothing to integrate sample by sample
+    return false;
+}
+
+bool BnISensor::getSample(BnISensorSample &sample){
+    (void) sample;
+    return false;
+}
+
+uint32_t BnISensor::getDroppedSamples(){
+    return 0;
+}
+
 void BnISensor::setStatus(int BN_SENSOR_status){
     if(BN_SENSOR_status == BN_SENSOR_STATUS_NOT_ACCESSIBLE){
         sIsInit=false;
@@ -0,0 +1,292 @@
+/**
+* MIT License
+* 
+* Copyright (c) 2026 Manuel Bottini
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "BnISensor.h"
+
+#ifdef __BN_ISENSOR_H__
+
+// Internal sensor of the host board, see templates/host.
+// By default it is synthetic: the node lies flat and turns around the z axis at
+// BN_HOST_ISENSOR_YAW_RATE rad/s, the accelerometer, gyroscope, magnetometer and absolute
+// orientation all agree with that motion.
+// If BN_HOST_ISENSOR_FILE is set in the environment, it replays that CSV file instead, one
+// sample per line, looping at the end:
+//   time_us, ax, ay, az, gx, gy, gz [, mx, my, mz [, qw, qx, qy, qz]]
+// with the accelerometer in m/s^2, the gyroscope in rad/s and the magnetometer in uT.
+// The magnetometer and the absolute orientation are available only if all lines have them.
+// With BN_ISENSOR_ACQUISITION it behaves like a chip with a FIFO, producing a sample every
+// 1/BN_HOST_ISENSOR_RATE_HZ seconds whether the loop reads them or not.
+
+#include <vector>
+
+#ifndef BN_HOST_ISENSOR_YAW_RATE
+#define BN_HOST_ISENSOR_YAW_RATE 0.5f
+#endif
+
+#ifndef BN_HOST_ISENSOR_RATE_HZ
+#define BN_HOST_ISENSOR_RATE_HZ 200
+#endif
+
+#define BN_HOST_ISENSOR_GRAVITY        9.80665f
+#define BN_HOST_ISENSOR_MAGN_NORTH_UT  20.0f
+#define BN_HOST_ISENSOR_MAGN_DOWN_UT  -40.0f
+#define BN_HOST_ISENSOR_MAX_COLUMNS    14
+
+struct BnHostISensorSample {
+    uint32_t time_us;
+    float values[BN_HOST_ISENSOR_MAX_COLUMNS - 1];
+};
+
+static std::vector<BnHostISensorSample> sSamples;
+static size_t sSampleIndex = 0;
+static uint32_t sStartTime_us = 0;
+static bool sIsInit = false;
+static uint32_t sSequence = 0;
+
+// Indexed by BN_ISENSOR_DATATYPE_*: accelerometer, gyroscope, magnetometer, absolute orientation
+static bool sDataTypes[BN_ISENSOR_NUM_DATATYPES] = { true, true, true, true };
+
+#if BN_ISENSOR_ACQUISITION
+
+#include "BnRingBuffer.h"
+
+#define BN_HOST_ISENSOR_PERIOD_US (1000000UL / BN_HOST_ISENSOR_RATE_HZ)
+
+static BnRingBuffer<BnISensorSample, BN_ISENSOR_RING_SIZE> sRing;
+static uint32_t sDroppedSamples = 0;
+static uint32_t sNextSample_us = 0;
+
+#endif // BN_ISENSOR_ACQUISITION
+
+static bool loadSamples(const char *path) {
+    FILE *file = fopen(path, "r");
+    if(file == nullptr) {
+        DEBUG_PRINT("Cannot open ");
+        DEBUG_PRINTLN(path);
+        return false;
+    }
+
+    int min_columns = BN_HOST_ISENSOR_MAX_COLUMNS;
+    char line[512];
+    while(fgets(line, sizeof(line), file) != nullptr) {
+        BnHostISensorSample sample = {};
+        char *cursor = line;
+        int columns = 0;
+        while(columns < BN_HOST_ISENSOR_MAX_COLUMNS) {
+            char *end;
+            float value = strtof(cursor, &end);
+            if(end == cursor) {
+                break;
+            }
+            if(columns == 0) {
+                sample.time_us = static_cast<uint32_t>(value);
+            } else {
+                sample.values[columns - 1] = value;
+            }
+            ++columns;
+            cursor = end;
+            while(*cursor == ',' || *cursor == ' ' || *cursor == '\t') {
+                ++cursor;
+            }
+        }
+        // Skips headers and empty lines
+        if(columns < 7) {
+            continue;
+        }
+        min_columns = min(min_columns, columns);
+        sSamples.push_back(sample);
+    }
+    fclose(file);
+
+    if(sSamples.empty()) {
+        DEBUG_PRINT("No samples in ");
+        DEBUG_PRINTLN(path);
+        return false;
+    }
+    sDataTypes[BN_ISENSOR_DATATYPE_MAGNETOMETER] = min_columns >= 10;
+    sDataTypes[BN_ISENSOR_DATATYPE_ABSOLUTEORIENTATION] = min_columns >= 14;
+    return true;
+}
+
+// The recorded sample at elapsed_us from the start, the recording starts over at the end
+static const BnHostISensorSample &sampleAt(uint32_t elapsed_us) {
+    uint32_t first_time_us = sSamples.front().time_us;
+    uint32_t duration_us = sSamples.back().time_us - first_time_us;
+    uint32_t time_us = elapsed_us;
+    if(duration_us > 0) {
+        time_us %= duration_us;
+    }
+    // Time only moves forward, so the search continues from the last sample
+    if(sSamples[sSampleIndex].time_us - first_time_us > time_us) {
+        sSampleIndex = 0;
+    }
+    while(sSampleIndex + 1 < sSamples.size() && sSamples[sSampleIndex + 1].time_us - first_time_us <= time_us) {
+        ++sSampleIndex;
+    }
+    return sSamples[sSampleIndex];
+}
+
+static void valuesAt(uint32_t elapsed_us, float values[], const int type) {
+    if(!sSamples.empty()) {
+        const BnHostISensorSample &sample = sampleAt(elapsed_us);
+        int offset = type * 3;
+        int num_values = type == BN_ISENSOR_DATATYPE_ABSOLUTEORIENTATION ? 4 : 3;
+        for(int index = 0; index < num_values; ++index) {
+            values[index] = sample.values[offset + index];
+        }
+        return;
+    }
+
+    float yaw = BN_HOST_ISENSOR_YAW_RATE * (elapsed_us / 1000000.0f);
+    if( type == BN_ISENSOR_DATATYPE_ACCELEROMETER ){
+        values[0] = 0.0f;
+        values[1] = 0.0f;
+        values[2] = BN_HOST_ISENSOR_GRAVITY;
+    } else if( type == BN_ISENSOR_DATATYPE_GYROSCOPE ){
+        values[0] = 0.0f;
+        values[1] = 0.0f;
+        values[2] = BN_HOST_ISENSOR_YAW_RATE;
+    } else if( type == BN_ISENSOR_DATATYPE_MAGNETOMETER ){
+        // The earth field seen from the rotated node
+        values[0] = BN_HOST_ISENSOR_MAGN_NORTH_UT * cosf(yaw);
+        values[1] = -BN_HOST_ISENSOR_MAGN_NORTH_UT * sinf(yaw);
+        values[2] = BN_HOST_ISENSOR_MAGN_DOWN_UT;
+    } else {
+        values[0] = cosf(yaw * 0.5f);
+        values[1] = 0.0f;
+        values[2] = 0.0f;
+        values[3] = sinf(yaw * 0.5f);
+    }
+}
+
+#if BN_ISENSOR_ACQUISITION
+// Produces the samples that the emulated chip took since the last call
+static void pumpSamples() {
+    const uint32_t now_us = micros();
+    // Negative when the next sample is not taken yet
+    const int32_t late_us = static_cast<int32_t>(now_us - sNextSample_us);
+    if(late_us >= static_cast<int32_t>(BN_ISENSOR_RING_SIZE * BN_HOST_ISENSOR_PERIOD_US)) {
+        // Like a chip FIFO that overflowed, only the newest samples are left
+        const uint32_t skipped = late_us / BN_HOST_ISENSOR_PERIOD_US - (BN_ISENSOR_RING_SIZE - 2);
+        sDroppedSamples += skipped;
+        sNextSample_us += skipped * BN_HOST_ISENSOR_PERIOD_US;
+    }
+    while(static_cast<int32_t>(now_us - sNextSample_us) >= 0) {
+        BnISensorSample sample;
+        sample.timestamp_us = sNextSample_us;
+        const uint32_t elapsed_us = sNextSample_us - sStartTime_us;
+        valuesAt(elapsed_us, sample.accel, BN_ISENSOR_DATATYPE_ACCELEROMETER);
+        valuesAt(elapsed_us, sample.gyro, BN_ISENSOR_DATATYPE_GYROSCOPE);
+        sample.has_magn = sDataTypes[BN_ISENSOR_DATATYPE_MAGNETOMETER];
+        if(sample.has_magn) {
+            valuesAt(elapsed_us, sample.magn, BN_ISENSOR_DATATYPE_MAGNETOMETER);
+        }
+        if(!sRing.push(sample)) {
+            ++sDroppedSamples;
+        }
+        sNextSample_us += BN_HOST_ISENSOR_PERIOD_US;
+    }
+}
+#endif // BN_ISENSOR_ACQUISITION
+
+bool BnISensor::init(){
+    if(sIsInit){
+        return true;
+    }
+
+    const char *path = getenv("BN_HOST_ISENSOR_FILE");
+    if(path != nullptr && !loadSamples(path)) {
+        setStatus(BN_SENSOR_STATUS_NOT_ACCESSIBLE);
+        return sIsInit;
+    }
+    sStartTime_us = micros();
+#if BN_ISENSOR_ACQUISITION
+    sNextSample_us = sStartTime_us;
+    sRing.clear();
+#endif // BN_ISENSOR_ACQUISITION
+    setStatus(BN_SENSOR_STATUS_WORKING);
+    return sIsInit;
+}
+
+bool BnISensor::isCalibrated(){
+    setStatus(BN_SENSOR_STATUS_WORKING);
+    return true;
+}
+
+bool BnISensor::getData(float values[], const int type){
+    if(!sIsInit || !hasDataType(type)){
+        return false;
+    }
+    ++sSequence;
+    valuesAt(micros() - sStartTime_us, values, type);
+    return true;
+}
+
+uint32_t BnISensor::getSequence(){
+    return sSequence;
+}
+
+bool BnISensor::hasDataType(const int type){
+    if(type < 0 || type >= BN_ISENSOR_NUM_DATATYPES){
+        return false;
+    }
+    return sDataTypes[type];
+}
+
+bool BnISensor::hasAcquisition(){
+    return BN_ISENSOR_ACQUISITION;
+}
+
+bool BnISensor::getSample(BnISensorSample &sample){
+#if BN_ISENSOR_ACQUISITION
+    if(!sIsInit){
+        return false;
+    }
+    if(sRing.isEmpty()){
+        pumpSamples();
+    }
+    return sRing.pop(sample);
+#else
+    return false;
+#endif // BN_ISENSOR_ACQUISITION
+}
+
+uint32_t BnISensor::getDroppedSamples(){
+#if BN_ISENSOR_ACQUISITION
+    return sDroppedSamples;
+#else
+    return 0;
+#endif // BN_ISENSOR_ACQUISITION
+}
+
+void BnISensor::setStatus(int sensor_status){
+    if(sensor_status == BN_SENSOR_STATUS_NOT_ACCESSIBLE){
+        sIsInit = false;
+        DEBUG_PRINTLN("Ooops, the host sensor data is not available ... Check BN_HOST_ISENSOR_FILE!");
+    } else if(sensor_status == BN_SENSOR_STATUS_WORKING) {
+        sIsInit = true;
+    }
+}
+
+#endif /*__BN_ISENSOR_H__*/
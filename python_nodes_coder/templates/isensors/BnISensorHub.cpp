@@ -0,0 +1,193 @@
+/**
+* MIT License
+* 
+* Copyright (c) 2026 Manuel Bottini
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "BnISensorHub.h"
+
+#ifdef __BN_ISENSOR_HUB_H__
+
+#include "BnProfiler.h"
+
+static BnISensor sISensor;
+// Bit (1 << BN_ISENSOR_DATATYPE_*) for each type that was subscribed
+static uint8_t sSubscribedTypes = 0;
+static uint32_t sInterval_us = 0;
+static uint32_t sLastReadTime_us = 0;
+static bool sHasReadTime = false;
+
+// Bit (1 << BN_ISENSOR_DATATYPE_*) for each type in sValues
+static uint8_t sSnapshotTypes = 0;
+static float sValues[BN_ISENSOR_NUM_DATATYPES][4];
+static uint32_t sSnapshotTime_us = 0;
+static uint32_t sSequence = 0;
+
+static BnISensorSample sTickSamples[BN_ISENSOR_RING_SIZE];
+static uint16_t sTickSamplesCount = 0;
+
+// The types that come with the samples of the acquisition
+#define BN_ISENSOR_HUB_SAMPLE_TYPES ((1 << BN_ISENSOR_DATATYPE_ACCELEROMETER) | \
+                                     (1 << BN_ISENSOR_DATATYPE_GYROSCOPE) | \
+                                     (1 << BN_ISENSOR_DATATYPE_MAGNETOMETER))
+
+static void publish(const BnISensorSample &sample){
+    for(uint8_t axis = 0; axis < 3; ++axis){
+        sValues[BN_ISENSOR_DATATYPE_ACCELEROMETER][axis] = sample.accel[axis];
+        sValues[BN_ISENSOR_DATATYPE_GYROSCOPE][axis] = sample.gyro[axis];
+        sValues[BN_ISENSOR_DATATYPE_MAGNETOMETER][axis] = sample.magn[axis];
+    }
+    sSnapshotTypes &= ~BN_ISENSOR_HUB_SAMPLE_TYPES;
+    sSnapshotTypes |= (1 << BN_ISENSOR_DATATYPE_ACCELEROMETER) | (1 << BN_ISENSOR_DATATYPE_GYROSCOPE);
+    if(sample.has_magn){
+        sSnapshotTypes |= (1 << BN_ISENSOR_DATATYPE_MAGNETOMETER);
+    }
+    sSnapshotTime_us = sample.timestamp_us;
+    ++sSequence;
+}
+
+// Moves the samples taken since the last tick out of the isensor ring
+static void drainSamples(){
+    while(sTickSamplesCount < BN_ISENSOR_RING_SIZE && sISensor.getSample(sTickSamples[sTickSamplesCount])){
+        ++sTickSamplesCount;
+    }
+    if(sTickSamplesCount > 0){
+        publish(sTickSamples[sTickSamplesCount - 1]);
+    }
+}
+
+// Reads each of the polled types once, when the interval has passed
+static void pollSensor(const uint8_t polled_types){
+    const uint32_t now_us = micros();
+    if(sHasReadTime){
+        if(now_us - sLastReadTime_us < sInterval_us){
+            return;
+        }
+        // Keeping the phase makes the average rate match the interval
+        sLastReadTime_us += sInterval_us;
+        if(now_us - sLastReadTime_us >= sInterval_us){
+            // Too late (i.e. the loop was blocked), no point in catching up
+            sLastReadTime_us = now_us;
+        }
+    } else {
+        sLastReadTime_us = now_us;
+        sHasReadTime = true;
+    }
+
+    uint8_t types = 0;
+    for(int type = 0; type < BN_ISENSOR_NUM_DATATYPES; ++type){
+        if((polled_types & (1 << type)) && sISensor.getData(sValues[type], type)){
+            types |= (1 << type);
+        }
+    }
+    if(types == 0){
+        return;
+    }
+    sSnapshotTypes = (sSnapshotTypes & ~polled_types) | types;
+    sSnapshotTime_us = now_us;
+    ++sSequence;
+
+    const uint8_t motion = (1 << BN_ISENSOR_DATATYPE_ACCELEROMETER) | (1 << BN_ISENSOR_DATATYPE_GYROSCOPE);
+    if((types & motion) == motion){
+        BnISensorSample &sample = sTickSamples[0];
+        sample.timestamp_us = now_us;
+        sample.has_magn = types & (1 << BN_ISENSOR_DATATYPE_MAGNETOMETER);
+        for(uint8_t axis = 0; axis < 3; ++axis){
+            sample.accel[axis] = sValues[BN_ISENSOR_DATATYPE_ACCELEROMETER][axis];
+            sample.gyro[axis] = sValues[BN_ISENSOR_DATATYPE_GYROSCOPE][axis];
+            sample.magn[axis] = sValues[BN_ISENSOR_DATATYPE_MAGNETOMETER][axis];
+        }
+        sTickSamplesCount = 1;
+    }
+}
+
+bool BnISensorHub::init(){
+    return sISensor.init();
+}
+
+bool BnISensorHub::isCalibrated(){
+    return sISensor.isCalibrated();
+}
+
+bool BnISensorHub::hasDataType(const int type){
+    return sISensor.hasDataType(type);
+}
+
+void BnISensorHub::setStatus(int sensor_status){
+    sISensor.setStatus(sensor_status);
+}
+
+void BnISensorHub::subscribe(const int type, uint32_t interval_us){
+    if(type < 0 || type >= BN_ISENSOR_NUM_DATATYPES){
+        return;
+    }
+    sSubscribedTypes |= (1 << type);
+    if(interval_us < BN_ISENSOR_HUB_INTERVAL_US){
+        interval_us = BN_ISENSOR_HUB_INTERVAL_US;
+    }
+    if(sInterval_us == 0 || interval_us < sInterval_us){
+        sInterval_us = interval_us;
+    }
+}
+
+void BnISensorHub::tick(){
+    sTickSamplesCount = 0;
+    if(sSubscribedTypes == 0){
+        return;
+    }
+    BN_PROFILE_BEGIN(ISENSOR_READ);
+    uint8_t polled_types = sSubscribedTypes;
+    if(sISensor.hasAcquisition()){
+        drainSamples();
+        // i.e. the absolute orientation is not in the samples
+        polled_types &= ~BN_ISENSOR_HUB_SAMPLE_TYPES;
+    }
+    if(polled_types != 0){
+        pollSensor(polled_types);
+    }
+    BN_PROFILE_END(ISENSOR_READ);
+}
+
+bool BnISensorHub::getData(float values[], const int type){
+    if(type < 0 || type >= BN_ISENSOR_NUM_DATATYPES || !(sSnapshotTypes & (1 << type))){
+        return false;
+    }
+    const uint8_t count = type == BN_ISENSOR_DATATYPE_ABSOLUTEORIENTATION ? 4 : 3;
+    for(uint8_t index = 0; index < count; ++index){
+        values[index] = sValues[type][index];
+    }
+    return true;
+}
+
+uint32_t BnISensorHub::getSequence(){
+    return sSequence;
+}
+
+uint32_t BnISensorHub::getTimestamp(){
+    return sSnapshotTime_us;
+}
+
+uint16_t BnISensorHub::getTickSamples(const BnISensorSample *&samples){
+    samples = sTickSamples;
+    return sTickSamplesCount;
+}
+
+#endif // __BN_ISENSOR_HUB_H__
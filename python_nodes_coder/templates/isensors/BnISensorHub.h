@@ -0,0 +1,73 @@
+/**
+* MIT License
+* 
+* Copyright (c) 2026 Manuel Bottini
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "BnNodeSpecific.h"
+#include "BnDatatypes.h"
+#include "BnISensor.h"
+
+#if defined(ORIENTATION_ABS_SENSOR) || defined(ACCELERATION_REL_SENSOR) || defined(ANGULARVELOCITY_REL_SENSOR)
+
+#ifndef __BN_ISENSOR_HUB_H__
+#define __BN_ISENSOR_HUB_H__
+
+// The esensors that read the isensor (orientation, acceleration and angular velocity) share it
+// through the hub instead of each one reading the chip on its own timer.
+// Once per loop tick() reads the isensor and publishes a snapshot of the data types the esensors
+// subscribed to, all taken at the same instant, so the outputs of the same tick are consistent.
+// Without the acquisition the hub polls the isensor at the shortest interval that was subscribed,
+// with the acquisition it drains the samples ring and the snapshot is the newest sample (the types
+// that are not in the samples are still polled).
+// All the hubs share the same state, like the isensors do.
+
+// Shortest polling interval, it is also the period of the samples integrated by the fusion
+#ifndef BN_ISENSOR_HUB_INTERVAL_US
+#define BN_ISENSOR_HUB_INTERVAL_US 5000
+#endif
+
+class BnISensorHub {
+public:
+    bool init();
+    bool isCalibrated();
+    bool hasDataType(const int type);
+    void setStatus(int sensor_status);
+
+    // Asks the hub to read the BN_ISENSOR_DATATYPE_* type at least every interval_us
+    void subscribe(const int type, uint32_t interval_us);
+    // Reads the isensor if needed, to be called once per loop before the esensors
+    void tick();
+
+    // Values of the type in the snapshot, false if it was not read
+    bool getData(float values[], const int type);
+    // Changes every time a new snapshot is published
+    uint32_t getSequence();
+    // Time the snapshot values were taken
+    uint32_t getTimestamp();
+    // Samples of accelerometer and gyroscope (and magnetometer if read) published in the last
+    // tick, oldest first. They are all the samples taken by the isensor, for the fusion
+    uint16_t getTickSamples(const BnISensorSample *&samples);
+};
+
+#endif // __BN_ISENSOR_HUB_H__
+
+#endif // ORIENTATION_ABS_SENSOR || ACCELERATION_REL_SENSOR || ANGULARVELOCITY_REL_SENSOR
@@ -47,6 +47,221 @@ static Adafruit_MPU6050 sMPU;
 static bool sIsInit = false;
 static BnStatusLED sStatusSensorLED;
 
+// Rate at which the chip updates its data registers and, with the acquisition, its FIFO.
+// The gyroscope outputs at 1 kHz when the DLPF is on
+#ifndef BN_MPU6050_SAMPLE_RATE_HZ
+#define BN_MPU6050_SAMPLE_RATE_HZ 200
+#endif
+#define BN_MPU6050_SAMPLE_PERIOD_US (1000000UL / BN_MPU6050_SAMPLE_RATE_HZ)
+
+#define BN_MPU6050_REG_FIFO_EN           0x23
+#define BN_MPU6050_REG_INT_ENABLE        0x38
+#define BN_MPU6050_REG_ACCEL_XOUT_H      0x3B
+#define BN_MPU6050_REG_USER_CTRL         0x6A
+#define BN_MPU6050_REG_FIFO_COUNTH       0x72
+#define BN_MPU6050_REG_FIFO_R_W          0x74
+#define BN_MPU6050_FIFO_EN_ACCEL_GYRO    0x78
+#define BN_MPU6050_USER_CTRL_FIFO_EN     0x40
+#define BN_MPU6050_USER_CTRL_FIFO_RESET  0x04
+#define BN_MPU6050_INT_DATA_RDY_EN       0x01
+#define BN_MPU6050_FIFO_BYTES            1024
+// Accelerometer then gyroscope, 3 x int16 big endian each
+#define BN_MPU6050_FIFO_FRAME_BYTES      12
+// Frames per I2C read, the Wire buffer is only 32 bytes on some cores
+#define BN_MPU6050_FIFO_FRAMES_PER_READ  2
+// Accelerometer, temperature and gyroscope registers, all in one burst read
+#define BN_MPU6050_DATA_BYTES            14
+#define BN_MPU6050_DATA_GYRO_OFFSET      8
+
+struct BnMPU6050RawSample {
+    uint32_t timestamp_us;
+    int16_t accel[3];
+    int16_t gyro[3];
+};
+
+// From the raw values to m/s^2 and rad/s, they depend on the ranges set at init
+static float sAccelScale = 0;
+static float sGyroScale = 0;
+// Newest reading, shared by all the esensors until the chip has a new one
+static BnMPU6050RawSample sLatest;
+static bool sHasLatest = false;
+// Time of the last read of the chip, valid if sHasReadTime
+static uint32_t sLatestReadTime_us = 0;
+static bool sHasReadTime = false;
+static uint32_t sSequence = 0;
+
+static bool writeRegister(uint8_t reg, uint8_t value){
+    sMPU6050Wire.beginTransmission(MPU6050_I2CADDR_DEFAULT);
+    sMPU6050Wire.write(reg);
+    sMPU6050Wire.write(value);
+    return sMPU6050Wire.endTransmission() == 0;
+}
+
+static bool readRegisters(uint8_t reg, uint8_t buffer[], uint8_t len){
+    sMPU6050Wire.beginTransmission(MPU6050_I2CADDR_DEFAULT);
+    sMPU6050Wire.write(reg);
+    if(sMPU6050Wire.endTransmission(false) != 0){
+        return false;
+    }
+    if(sMPU6050Wire.requestFrom(static_cast<uint8_t>(MPU6050_I2CADDR_DEFAULT), len) != len){
+        return false;
+    }
+    for(uint8_t index = 0; index < len; ++index){
+        buffer[index] = sMPU6050Wire.read();
+    }
+    return true;
+}
+
+static void readVector(const uint8_t bytes[], int16_t vector[]){
+    for(uint8_t axis = 0; axis < 3; ++axis){
+        vector[axis] = static_cast<int16_t>((bytes[2 * axis] << 8) | bytes[2 * axis + 1]);
+    }
+}
+
+static void setLatest(const BnMPU6050RawSample &sample){
+    sLatest = sample;
+    sHasLatest = true;
+    ++sSequence;
+}
+
+static void configure(){
+    sMPU.setFilterBandwidth(MPU6050_BAND_184_HZ);
+    sMPU.setSampleRateDivisor(1000 / BN_MPU6050_SAMPLE_RATE_HZ - 1);
+
+    // Same conversions as the Adafruit sensor events
+    static const float accel_lsb_per_g[4] = { 16384, 8192, 4096, 2048 };
+    static const float gyro_lsb_per_dps[4] = { 131, 65.5, 32.8, 16.4 };
+    sAccelScale = SENSORS_GRAVITY_STANDARD / accel_lsb_per_g[sMPU.getAccelerometerRange() & 0x03];
+    sGyroScale = SENSORS_DPS_TO_RADS / gyro_lsb_per_dps[sMPU.getGyroRange() & 0x03];
+    sHasLatest = false;
+    sHasReadTime = false;
+}
+
+#if BN_ISENSOR_ACQUISITION
+
+#include "BnRingBuffer.h"
+
+static BnRingBuffer<BnMPU6050RawSample, BN_ISENSOR_RING_SIZE> sRing;
+static uint32_t sDroppedSamples = 0;
+
+#ifdef BN_MPU6050_PIN_INT
+#ifndef IRAM_ATTR
+#define IRAM_ATTR
+#endif
+
+// Time of the newest sample in the FIFO, taken by the data-ready interrupt
+static volatile uint32_t sDataReadyTime_us = 0;
+
+static void IRAM_ATTR onDataReady(){
+    sDataReadyTime_us = micros();
+}
+#endif // BN_MPU6050_PIN_INT
+
+static void resetFifo(){
+    writeRegister(BN_MPU6050_REG_USER_CTRL, BN_MPU6050_USER_CTRL_FIFO_RESET);
+    writeRegister(BN_MPU6050_REG_USER_CTRL, BN_MPU6050_USER_CTRL_FIFO_EN);
+}
+
+static void startAcquisition(){
+    writeRegister(BN_MPU6050_REG_FIFO_EN, BN_MPU6050_FIFO_EN_ACCEL_GYRO);
+    resetFifo();
+    sRing.clear();
+
+#ifdef BN_MPU6050_PIN_INT
+    writeRegister(BN_MPU6050_REG_INT_ENABLE, BN_MPU6050_INT_DATA_RDY_EN);
+    pinMode(BN_MPU6050_PIN_INT, INPUT);
+    attachInterrupt(digitalPinToInterrupt(BN_MPU6050_PIN_INT), onDataReady, RISING);
+#endif // BN_MPU6050_PIN_INT
+}
+
+// Moves the samples from the chip FIFO to the ring, with a couple of burst reads
+static void pumpFifo(){
+#ifdef BN_MPU6050_PIN_INT
+    // Taken before the count, a sample that arrives in between is dated one period early
+    const uint32_t newest_us = sDataReadyTime_us;
+#else
+    const uint32_t newest_us = micros();
+#endif // BN_MPU6050_PIN_INT
+    uint8_t buffer[BN_MPU6050_FIFO_FRAMES_PER_READ * BN_MPU6050_FIFO_FRAME_BYTES];
+    if(!readRegisters(BN_MPU6050_REG_FIFO_COUNTH, buffer, 2)){
+        return;
+    }
+    const uint16_t count = (buffer[0] << 8) | buffer[1];
+    if(count > BN_MPU6050_FIFO_BYTES - BN_MPU6050_FIFO_FRAME_BYTES){
+        // The FIFO overflowed, the frames are not aligned anymore
+        sDroppedSamples += count / BN_MPU6050_FIFO_FRAME_BYTES;
+        resetFifo();
+        return;
+    }
+    const uint16_t frames = count / BN_MPU6050_FIFO_FRAME_BYTES;
+    uint16_t frame = 0;
+    while(frame < frames){
+        uint8_t chunk = frames - frame;
+        if(chunk > BN_MPU6050_FIFO_FRAMES_PER_READ){
+            chunk = BN_MPU6050_FIFO_FRAMES_PER_READ;
+        }
+        if(!readRegisters(BN_MPU6050_REG_FIFO_R_W, buffer, chunk * BN_MPU6050_FIFO_FRAME_BYTES)){
+            resetFifo();
+            return;
+        }
+        for(uint8_t index = 0; index < chunk; ++index, ++frame){
+            const uint8_t *bytes = &buffer[index * BN_MPU6050_FIFO_FRAME_BYTES];
+            BnMPU6050RawSample sample;
+            sample.timestamp_us = newest_us - (frames - 1 - frame) * BN_MPU6050_SAMPLE_PERIOD_US;
+            readVector(bytes, sample.accel);
+            readVector(bytes + 6, sample.gyro);
+            if(!sRing.push(sample)){
+                ++sDroppedSamples;
+            }
+            setLatest(sample);
+        }
+    }
+}
+
+static void toSample(const BnMPU6050RawSample &raw, BnISensorSample &sample){
+    sample.timestamp_us = raw.timestamp_us;
+    for(uint8_t axis = 0; axis < 3; ++axis){
+        sample.accel[axis] = raw.accel[axis] * sAccelScale;
+        sample.gyro[axis] = raw.gyro[axis] * sGyroScale;
+    }
+    sample.has_magn = false;
+}
+
+#else
+
+// One burst read of the data registers instead of a read per Adafruit sensor event
+static void readData(){
+    uint8_t buffer[BN_MPU6050_DATA_BYTES];
+    if(!readRegisters(BN_MPU6050_REG_ACCEL_XOUT_H, buffer, BN_MPU6050_DATA_BYTES)){
+        return;
+    }
+    BnMPU6050RawSample sample;
+    sample.timestamp_us = micros();
+    readVector(buffer, sample.accel);
+    readVector(buffer + BN_MPU6050_DATA_GYRO_OFFSET, sample.gyro);
+    setLatest(sample);
+}
+
+#endif // BN_ISENSOR_ACQUISITION
+
+// Reads the chip only if it can have a new reading, so the esensors of the same tick
+// share a single bus transaction
+static void refreshLatest(){
+    if(sHasReadTime && micros() - sLatestReadTime_us < BN_MPU6050_SAMPLE_PERIOD_US){
+        return;
+    }
+    sLatestReadTime_us = micros();
+    sHasReadTime = true;
+#if BN_ISENSOR_ACQUISITION
+    pumpFifo();
+#else
+    readData();
+#endif // BN_ISENSOR_ACQUISITION
+}
+
+// Indexed by BN_ISENSOR_DATATYPE_*: accelerometer, gyroscope, magnetometer, absolute orientation
+static const bool sDataTypes[BN_ISENSOR_NUM_DATATYPES] = { true, true, false, false };
+
 bool BnISensor::init(){
     if(sIsInit){
         return true;
@@ -62,6 +277,10 @@ bool BnISensor::init(){
         sMPU6050Wire.begin(BN_MPU6050_PIN_SDA, BN_MPU6050_PIN_SCL);
 #endif
     if(sMPU.begin(MPU6050_I2CADDR_DEFAULT, &sMPU6050Wire) ){
+        configure();
+#if BN_ISENSOR_ACQUISITION
+        startAcquisition();
+#endif // BN_ISENSOR_ACQUISITION
         setStatus(BN_SENSOR_STATUS_WORKING);
     } else {
         setStatus(BN_SENSOR_STATUS_NOT_ACCESSIBLE);
@@ -76,31 +295,62 @@ bool BnISensor::isCalibrated(){
 }
 
 bool BnISensor::getData(float values[], const int type){
+    if( type != BN_ISENSOR_DATATYPE_ACCELEROMETER && type != BN_ISENSOR_DATATYPE_GYROSCOPE ){
+        return false;
+    }
+    refreshLatest();
+    if(!sHasLatest){
+        return false;
+    }
+    const int16_t *raw = type == BN_ISENSOR_DATATYPE_ACCELEROMETER ? sLatest.accel : sLatest.gyro;
+    const float scale = type == BN_ISENSOR_DATATYPE_ACCELEROMETER ? sAccelScale : sGyroScale;
+    values[0] = raw[0] * scale;
+    values[1] = raw[1] * scale;
+    values[2] = raw[2] * scale;
+    return true;
+}
 
-    sensors_event_t a, g;
-    sMPU.getAccelerometerSensor()->getEvent(&a);    // outputs m/s^2
-    sMPU.getGyroSensor()->getEvent(&g);             // outputs in rad/s
+uint32_t BnISensor::getSequence(){
+    return sSequence;
+}
 
-    if( type == BN_ISENSOR_DATATYPE_ACCELEROMETER ){
-        values[0] =  a.acceleration.x;
-        values[1] =  a.acceleration.y;
-        values[2] =  a.acceleration.z;
-        return true;
-    } else if( type == BN_ISENSOR_DATATYPE_GYROSCOPE ){
-        values[0] =  g.gyro.x;
-        values[1] =  g.gyro.y;
-        values[2] =  g.gyro.z;
-        return true;        
-    } else if( type == BN_ISENSOR_DATATYPE_MAGNETOMETER ){
-        return false;
-    } else if( type == BN_ISENSOR_DATATYPE_ABSOLUTEORIENTATION ){
-        return false;        
-    } else {
+bool BnISensor::hasDataType(const int type){
+    if(type < 0 || type >= BN_ISENSOR_NUM_DATATYPES){
         return false;
     }
+    return sDataTypes[type];
+}
+
+bool BnISensor::hasAcquisition(){
+    return BN_ISENSOR_ACQUISITION;
+}
 
+bool BnISensor::getSample(BnISensorSample &sample){
+#if BN_ISENSOR_ACQUISITION
+    if(!sIsInit){
+        return false;
+    }
+    if(sRing.isEmpty()){
+        refreshLatest();
+    }
+    BnMPU6050RawSample raw;
+    if(!sRing.pop(raw)){
+        return false;
+    }
+    toSample(raw, sample);
+    return true;
+#else
+    return false;
+#endif // BN_ISENSOR_ACQUISITION
 }
 
+uint32_t BnISensor::getDroppedSamples(){
+#if BN_ISENSOR_ACQUISITION
+    return sDroppedSamples;
+#else
+    return 0;
+#endif // BN_ISENSOR_ACQUISITION
+}
 
 void BnISensor::setStatus(int sensor_status){
     if(sensor_status == BN_SENSOR_STATUS_NOT_ACCESSIBLE){
@@ -24,130 +24,298 @@
 
 #include "BnArduinoUtils.h"
 
+#include <string.h>
+
+constexpr uint8_t BnPersMemory::pm_legacy_checkkey[5];
+constexpr uint8_t BnPersMemory::pm_legacy_marker[2];
+constexpr uint16_t BnPersMemory::pm_legacy_addr_nbytes[BN_MEMORY_NUM_KEYS];
+String BnPersMemory::pm_values[BN_MEMORY_NUM_KEYS];
+uint16_t BnPersMemory::pm_changed = 0;
+uint8_t BnPersMemory::pm_transactions = 0;
+uint8_t BnPersMemory::pm_generation = 0;
+uint16_t BnPersMemory::pm_bank = 0;
+uint16_t BnPersMemory::pm_log_end = 0;
+
 void BnPersMemory::init(){
   persMemoryInit();
 
-  uint8_t checkkey[5];
-  persMemoryRead(0, &checkkey[0]);
-  persMemoryRead(1, &checkkey[1]);
-  persMemoryRead(2, &checkkey[2]);
-  persMemoryRead(3, &checkkey[3]);
-  persMemoryRead(4, &checkkey[4]);
-
-  if(!(checkkey[0] == pm_checkkey[0] &&
-    checkkey[1] == pm_checkkey[1] &&
-    checkkey[2] == pm_checkkey[2] &&
-    checkkey[3] == pm_checkkey[3] &&
-    checkkey[4] == pm_checkkey[4])){
+  pm_changed = 0;
+  pm_transactions = 0;
+  if(loadLog()){
+    DEBUG_PRINTLN("Already setup memory!");
+    return;
+  }
 
+  uint8_t checkkey[5];
+  for(uint8_t index = 0; index < 5; ++index){
+    persMemoryRead(index, &checkkey[index]);
+  }
+  pm_bank = 0;
+  if(memcmp(checkkey, pm_legacy_checkkey, 5) == 0){
+    uint8_t marker[2];
+    persMemoryRead(pm_legacy_marker_addr, &marker[0]);
+    persMemoryRead(pm_legacy_marker_addr+1, &marker[1]);
+    if(memcmp(marker, pm_legacy_marker, 2) == 0){
+      DEBUG_PRINTLN("Moving the memory to the log again, after a reset");
+      loadLegacy(pm_bank_size);
+    } else {
+      DEBUG_PRINTLN("Moving the memory to the log");
+      loadLegacy(pm_size);
+      persMemoryWrite(pm_legacy_marker_addr, pm_legacy_marker[0]);
+      persMemoryWrite(pm_legacy_marker_addr+1, pm_legacy_marker[1]);
+    }
+  } else {
     DEBUG_PRINTLN("New memory!");
+    loadDefaults();
+  }
+  // Into the second bank, the first one keeps the check key until the log is valid
+  compact();
+  persMemoryCommit();
+}
+
+void BnPersMemory::clean(){
+  for(uint8_t key = 0; key < BN_MEMORY_NUM_KEYS; ++key){
+    pm_values[key] = "";
+  }
+  pm_changed = 0;
+  compact();
+  persMemoryCommit();
+}
+
+bool BnPersMemory::setValue(BnMemoryKey key, const String &value){
+  if(key >= BN_MEMORY_NUM_KEYS){
+    DEBUG_PRINT("Cannot find in memory key = ");
+    DEBUG_PRINTLN(key);
+    return false;
+  }
+  if(value == pm_values[key]){
+    // Already in memory
+    return true;
+  }
+  if(value.length() > 255 || compactLength() - pm_values[key].length() + value.length() > pm_bank_size){
+    DEBUG_PRINT("Too long for the memory key = ");
+    DEBUG_PRINTLN(key);
+    return false;
+  }
+  pm_values[key] = value;
+  pm_changed |= 1 << key;
+  if(pm_transactions == 0){
+    writeChanges();
+  }
+  return true;
+}
 
-    // Clear all the data
-    clean();
+const String &BnPersMemory::getValue(BnMemoryKey key){
+  if(key >= BN_MEMORY_NUM_KEYS){
+    DEBUG_PRINT("Cannot find in memory key = ");
+    DEBUG_PRINTLN(key);
+    static const String empty;
+    return empty;
+  }
+  return pm_values[key];
+}
 
-    persMemoryWrite(0, pm_checkkey[0]);
-    persMemoryWrite(1, pm_checkkey[1]);
-    persMemoryWrite(2, pm_checkkey[2]);
-    persMemoryWrite(3, pm_checkkey[3]);
-    persMemoryWrite(4, pm_checkkey[4]);
-    persMemoryCommit();
+void BnPersMemory::beginTransaction(){
+  ++pm_transactions;
+}
 
-    // Sets default values
-    setValue(BN_MEMORY_PLAYER_TAG, BODYNODE_PLAYER_TAG_DEFAULT );
-    setValue(BN_MEMORY_BODYPART_TAG, BODYNODE_BODYPART_TAG_DEFAULT );
-#if defined(GLOVE_SENSOR_ON_SERIAL) || defined(GLOVE_SENSOR_ON_BOARD)
-    setValue(BN_MEMORY_BODYPART_GLOVE_TAG, BN_SENSORTYPE_GLOVE_TAG);
-#endif /*defined(GLOVE_SENSOR_ON_SERIAL) || defined(GLOVE_SENSOR_ON_BOARD)*/
-#ifdef SHOE_SENSOR_ON_BOARD
-    setValue(BN_MEMORY_BODYPART_SHOE_TAG, BN_SENSORTYPE_SHOE_TAG);
-#endif /*SHOE_SENSOR_ON_BOARD*/
-    setValue(BN_MEMORY_WIFI_SSID_TAG, BN_WIFI_SSID_DEFAULT);
-    setValue(BN_MEMORY_WIFI_PASSWORD_TAG, BN_WIFI_PASSWORD_DEFAULT);
-    setValue(BN_MEMORY_WIFI_MULTICASTMESSAGE_TAG, BN_WIFI_MULTICASTMESSAGE_DEFAULT);
+void BnPersMemory::endTransaction(){
+  if(pm_transactions == 0){
+    return;
+  }
+  --pm_transactions;
+  if(pm_transactions == 0){
+    writeChanges();
+  }
+}
 
+bool BnPersMemory::loadLog(){
+  uint8_t generation0, generation1;
+  const bool valid0 = readHeader(0, &generation0);
+  const bool valid1 = readHeader(pm_bank_size, &generation1);
+  if(valid0 && (!valid1 || static_cast<int8_t>(generation0 - generation1) > 0)){
+    pm_bank = 0;
+    pm_generation = generation0;
+  } else if(valid1) {
+    pm_bank = pm_bank_size;
+    pm_generation = generation1;
   } else {
-    DEBUG_PRINTLN("Already setup memory!");
+    return false;
+  }
+  for(uint8_t key = 0; key < BN_MEMORY_NUM_KEYS; ++key){
+    pm_values[key] = "";
   }
 
+  const uint16_t bank_end = pm_bank + pm_bank_size;
+  uint16_t address = pm_bank + pm_header_bytes;
+  while(address + pm_record_overhead <= bank_end){
+    uint8_t generation, key, len;
+    persMemoryRead(address, &generation);
+    persMemoryRead(address+1, &key);
+    persMemoryRead(address+2, &len);
+    if(generation != pm_generation || key >= BN_MEMORY_NUM_KEYS || address + pm_record_overhead + len > bank_end){
+      break;
+    }
+    uint16_t crc = updateCrc(updateCrc(updateCrc(0xFFFF, generation), key), len);
+    String value;
+    value.reserve(len);
+    for(uint16_t index = 0; index < len; ++index){
+      uint8_t tmp;
+      persMemoryRead(address+3+index, &tmp);
+      crc = updateCrc(crc, tmp);
+      value += static_cast<char>(tmp);
+    }
+    uint8_t crc_low, crc_high;
+    persMemoryRead(address+3+len, &crc_low);
+    persMemoryRead(address+4+len, &crc_high);
+    if(crc != (static_cast<uint16_t>(crc_low) | (static_cast<uint16_t>(crc_high) << 8))){
+      DEBUG_PRINTLN("Broken record in memory");
+      break;
+    }
+    pm_values[key] = value;
+    address += pm_record_overhead + len;
+  }
+  // The next record goes over the first one not read
+  pm_log_end = address;
+  return true;
 }
 
-void BnPersMemory::clean(){
-  for(uint16_t index=0; index<512; ++index){
-    persMemoryWrite(index, 0);
+bool BnPersMemory::readHeader(uint16_t bank, uint8_t *generation){
+  uint8_t header[pm_header_bytes];
+  for(uint8_t index = 0; index < pm_header_bytes; ++index){
+    persMemoryRead(bank+index, &header[index]);
   }
-  persMemoryCommit();
+  if(header[0] != 'B' || header[1] != 'N' || header[2] != pm_format){
+    return false;
+  }
+  *generation = header[3];
+  return true;
 }
 
-void BnPersMemory::setValue(String key, String value){
-  uint16_t addr_nbytes = 0;
-  uint16_t addr_chars = 0;
-  if(key == BN_MEMORY_PLAYER_TAG) {
-    addr_nbytes = pm_player_addr_nbytes;
-    addr_chars = pm_player_addr_chars;
-  } else if(key == BN_MEMORY_BODYPART_TAG) {
-    addr_nbytes = pm_bodypart_addr_nbytes;
-    addr_chars = pm_bodypart_addr_chars;
-  } else if(key == BN_MEMORY_BODYPART_GLOVE_TAG) {
-    addr_nbytes = pm_bodypart_glove_addr_nbytes;
-    addr_chars = pm_bodypart_glove_addr_chars;
-  } else if(key == BN_MEMORY_WIFI_SSID_TAG) {
-    addr_nbytes = pm_ssid_addr_nbytes;
-    addr_chars = pm_ssid_addr_chars;
-  } else if(key == BN_MEMORY_WIFI_PASSWORD_TAG) {
-    addr_nbytes = pm_password_addr_nbytes;
-    addr_chars = pm_password_addr_chars;
-  } else if(key == BN_MEMORY_WIFI_MULTICASTMESSAGE_TAG) {
-    addr_nbytes = pm_multicast_message_addr_nbytes;
-    addr_chars = pm_multicast_message_addr_chars;
-  } else {
-    DEBUG_PRINT("Cannot find in memory key = ");
-    DEBUG_PRINTLN(key);
+void BnPersMemory::loadDefaults(){
+  for(uint8_t key = 0; key < BN_MEMORY_NUM_KEYS; ++key){
+    pm_values[key] = "";
+  }
+  pm_values[BN_MEMORY_KEY_PLAYER] = BODYNODE_PLAYER_TAG_DEFAULT;
+  pm_values[BN_MEMORY_KEY_BODYPART] = BODYNODE_BODYPART_TAG_DEFAULT;
+#if defined(GLOVE_SENSOR_ON_SERIAL) || defined(GLOVE_SENSOR_ON_BOARD)
+  pm_values[BN_MEMORY_KEY_BODYPART_GLOVE] = BN_SENSORTYPE_GLOVE_TAG;
+#endif /*defined(GLOVE_SENSOR_ON_SERIAL) || defined(GLOVE_SENSOR_ON_BOARD)*/
+#ifdef SHOE_SENSOR_ON_BOARD
+  pm_values[BN_MEMORY_KEY_BODYPART_SHOE] = BN_SENSORTYPE_SHOE_TAG;
+#endif /*SHOE_SENSOR_ON_BOARD*/
+  pm_values[BN_MEMORY_KEY_WIFI_SSID] = BN_WIFI_SSID_DEFAULT;
+  pm_values[BN_MEMORY_KEY_WIFI_PASSWORD] = BN_WIFI_PASSWORD_DEFAULT;
+  pm_values[BN_MEMORY_KEY_WIFI_MULTICASTMESSAGE] = BN_WIFI_MULTICASTMESSAGE_DEFAULT;
+}
+
+void BnPersMemory::loadLegacy(uint16_t readable_end){
+  loadDefaults();
+  for(uint8_t key = 0; key < BN_MEMORY_NUM_KEYS; ++key){
+    const uint16_t addr_nbytes = pm_legacy_addr_nbytes[key];
+    const uint16_t end = key+1 < BN_MEMORY_NUM_KEYS ? pm_legacy_addr_nbytes[key+1] : pm_size;
+    if(end > readable_end){
+      DEBUG_PRINT("Lost in memory key = ");
+      DEBUG_PRINTLN(key);
+      continue;
+    }
+    pm_values[key] = "";
+    uint8_t len = 0;
+    persMemoryRead(addr_nbytes, &len);
+    if(len == 0 || addr_nbytes + 1 + len > end){
+      // Never written
+      continue;
+    }
+    for(uint8_t index = 0; index+1 < len; ++index){
+      uint8_t tmp;
+      persMemoryRead(addr_nbytes+1+index, &tmp);
+      if(tmp == 0){
+        break;
+      }
+      pm_values[key] += static_cast<char>(tmp);
+    }
+  }
+}
+
+void BnPersMemory::writeChanges(){
+  if(pm_changed == 0){
     return;
   }
-  uint8_t len = value.length()+1;
-  char tmp_buf[len];
-  value.toCharArray(tmp_buf, len);
-  persMemoryWrite(addr_nbytes, len);
-  for(uint8_t index = 0; index < len; ++index){
-    persMemoryWrite(addr_chars+index, tmp_buf[index]);
+  uint16_t len = 0;
+  for(uint8_t key = 0; key < BN_MEMORY_NUM_KEYS; ++key){
+    if(pm_changed & (1 << key)){
+      len += recordLength(static_cast<BnMemoryKey>(key));
+    }
   }
+  if(pm_log_end + len > pm_bank + pm_bank_size){
+    compact();
+  } else {
+    for(uint8_t key = 0; key < BN_MEMORY_NUM_KEYS; ++key){
+      if(pm_changed & (1 << key)){
+        pm_log_end = writeRecord(pm_log_end, static_cast<BnMemoryKey>(key));
+      }
+    }
+  }
+  pm_changed = 0;
   persMemoryCommit();
 }
 
-String BnPersMemory::getValue(String key){
-  uint16_t addr_nbytes = 0;
-  uint16_t addr_chars = 0;
-  if(key == BN_MEMORY_PLAYER_TAG) {
-    addr_nbytes = pm_player_addr_nbytes;
-    addr_chars = pm_player_addr_chars;
-  } else if(key == BN_MEMORY_BODYPART_TAG) {
-    addr_nbytes = pm_bodypart_addr_nbytes;
-    addr_chars = pm_bodypart_addr_chars;
-  } else if(key == BN_MEMORY_BODYPART_GLOVE_TAG) {
-    addr_nbytes = pm_bodypart_glove_addr_nbytes;
-    addr_chars = pm_bodypart_glove_addr_chars;
-  } else if(key == BN_MEMORY_WIFI_SSID_TAG) {
-    addr_nbytes = pm_ssid_addr_nbytes;
-    addr_chars = pm_ssid_addr_chars;
-  } else if(key == BN_MEMORY_WIFI_PASSWORD_TAG) {
-    addr_nbytes = pm_password_addr_nbytes;
-    addr_chars = pm_password_addr_chars;
-  } else if(key == BN_MEMORY_WIFI_MULTICASTMESSAGE_TAG) {
-    addr_nbytes = pm_multicast_message_addr_nbytes;
-    addr_chars = pm_multicast_message_addr_chars;
-  } else {
-    DEBUG_PRINT("Cannot find in memory key = ");
-    DEBUG_PRINTLN(key);
-    return "";
+void BnPersMemory::compact(){
+  // Into the bank not in use. It stops being valid before its records are written, and becomes
+  // valid again with the first byte of the header. The records of the previous generation left
+  // after the new log end are not read
+  const uint16_t bank = pm_bank == 0 ? pm_bank_size : 0;
+  persMemoryWrite(bank, 0);
+  ++pm_generation;
+  uint16_t address = bank + pm_header_bytes;
+  for(uint8_t key = 0; key < BN_MEMORY_NUM_KEYS; ++key){
+    if(pm_values[key].length() > 0){
+      address = writeRecord(address, static_cast<BnMemoryKey>(key));
+    }
   }
-  uint8_t len = 0;
-  persMemoryRead(addr_nbytes, &len);
-  char tmp_buf[len];
-  for(uint8_t index = 0; index < len; ++index){
-    uint8_t tmp;
-    persMemoryRead(addr_chars+index, &tmp);
-    tmp_buf[index] = static_cast<char>(tmp);
+  persMemoryWrite(bank+1, 'N');
+  persMemoryWrite(bank+2, pm_format);
+  persMemoryWrite(bank+3, pm_generation);
+  persMemoryWrite(bank, 'B');
+  pm_bank = bank;
+  pm_log_end = address;
+  pm_changed = 0;
+}
+
+uint16_t BnPersMemory::writeRecord(uint16_t address, BnMemoryKey key){
+  const String &value = pm_values[key];
+  const uint8_t len = value.length();
+  persMemoryWrite(address, pm_generation);
+  persMemoryWrite(address+1, key);
+  persMemoryWrite(address+2, len);
+  uint16_t crc = updateCrc(updateCrc(updateCrc(0xFFFF, pm_generation), key), len);
+  for(uint16_t index = 0; index < len; ++index){
+    const uint8_t tmp = static_cast<uint8_t>(value[index]);
+    persMemoryWrite(address+3+index, tmp);
+    crc = updateCrc(crc, tmp);
   }
+  persMemoryWrite(address+3+len, crc & 0xFF);
+  persMemoryWrite(address+4+len, crc >> 8);
+  return address + pm_record_overhead + len;
+}
+
+uint16_t BnPersMemory::recordLength(BnMemoryKey key){
+  return pm_record_overhead + pm_values[key].length();
+}
 
-  return tmp_buf;
+uint16_t BnPersMemory::compactLength(){
+  uint16_t len = pm_header_bytes;
+  for(uint8_t key = 0; key < BN_MEMORY_NUM_KEYS; ++key){
+    len += recordLength(static_cast<BnMemoryKey>(key));
+  }
+  return len;
+}
+
+uint16_t BnPersMemory::updateCrc(uint16_t crc, uint8_t value){
+  // CRC-16/CCITT-FALSE
+  crc ^= static_cast<uint16_t>(value) << 8;
+  for(uint8_t bit = 0; bit < 8; ++bit){
+    crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+  }
+  return crc;
 }
@@ -29,38 +29,93 @@
 #ifndef __BN_ARDUINO_UTILS_H
 #define __BN_ARDUINO_UTILS_H
 
+// Values in the persistent memory
+enum BnMemoryKey : uint8_t {
+  BN_MEMORY_KEY_PLAYER = 0,
+  BN_MEMORY_KEY_BODYPART,
+  BN_MEMORY_KEY_BODYPART_GLOVE,
+  BN_MEMORY_KEY_BODYPART_SHOE,
+  BN_MEMORY_KEY_WIFI_SSID,
+  BN_MEMORY_KEY_WIFI_PASSWORD,
+  BN_MEMORY_KEY_WIFI_MULTICASTMESSAGE,
+  // "ox,oy,oz,sx,sy,sz"
+  BN_MEMORY_KEY_MAGN_CALIBRATION,
+  BN_MEMORY_NUM_KEYS
+};
+
+/*
+The values are read once in init() and kept in RAM, getValue() does not touch the memory.
+In the memory they are a log of records, a changed value is appended instead of rewritten in place:
+  header      'B' 'N' | format u8 | generation u8
+  record      generation u8 | key u8 | length u8 | characters | CRC-16 u16 (of all the bytes before)
+The memory is split in two banks, each one with its own header and log, and the values are in the
+valid bank with the newer generation. The last record of a key holds its value. The log is read up
+to the first record with a wrong generation or CRC, so a record cut by a reset is ignored.
+When the log is full it is compacted into the other bank: one record for each value, then the header
+with the next generation, its first byte last. A reset while compacting leaves the previous bank.
+setValue() only marks the value as changed. The changed values are written with a single commit
+at the end of the transaction, every setValue() outside of one is a transaction on its own.
+*/
 class BnPersMemory {
 public:
   static void init();
+  // Forgets all the values
   static void clean();
-  static void setValue(BnKey key, String value);
-  static String getValue(BnKey key);
+  // False if the value does not fit in the memory
+  static bool setValue(BnMemoryKey key, const String &value);
+  static const String &getValue(BnMemoryKey key);
+  // Transactions can be nested, the outermost one writes the changes
+  static void beginTransaction();
+  static void endTransaction();
 private:
   BnPersMemory(){};
 
-  static constexpr uint8_t pm_checkkey[5] = {0x00, 0x00, 0x00, 0x00, 0x01};
-
-  static constexpr uint16_t pm_player_addr_nbytes = 50;
-  static constexpr uint16_t pm_player_addr_chars = 51;
-  
-  static constexpr uint16_t pm_bodypart_addr_nbytes = 100;
-  static constexpr uint16_t pm_bodypart_addr_chars = 101;
-
-  static constexpr uint16_t pm_bodypart_glove_addr_nbytes = 150;
-  static constexpr uint16_t pm_bodypart_glove_addr_chars = 151;
-
-  static constexpr uint16_t pm_bodypart_shoe_addr_nbytes = 200;
-  static constexpr uint16_t pm_bodypart_shoe_addr_chars = 201;
-
-  static constexpr uint16_t pm_ssid_addr_nbytes = 250;
-  static constexpr uint16_t pm_ssid_addr_chars = 251;
+  static bool loadLog();
+  // True if the bank has a valid header, its generation goes in generation
+  static bool readHeader(uint16_t bank, uint8_t *generation);
+  static void loadDefaults();
+  // Keys stored past readable_end keep the default value
+  static void loadLegacy(uint16_t readable_end);
+  static void writeChanges();
+  static void compact();
+  static uint16_t writeRecord(uint16_t address, BnMemoryKey key);
+  static uint16_t recordLength(BnMemoryKey key);
+  static uint16_t compactLength();
+  static uint16_t updateCrc(uint16_t crc, uint8_t value);
 
-  static constexpr uint16_t pm_password_addr_nbytes = 300;
-  static constexpr uint16_t pm_password_addr_chars = 301;
+  static constexpr uint16_t pm_size = 512;
+  static constexpr uint16_t pm_bank_size = pm_size / 2;
+  static constexpr uint8_t pm_format = 2;
+  static constexpr uint16_t pm_header_bytes = 4;
+  // generation, key, length and CRC
+  static constexpr uint16_t pm_record_overhead = 5;
 
-  static constexpr uint16_t pm_multicast_message_addr_nbytes = 350;
-  static constexpr uint16_t pm_multicast_message_addr_chars = 351;
+  // Layout before the log: a check key, then each value at a fixed address as its length
+  // with the terminator in one byte followed by the characters. Read once to move to the log.
+  // The log is moved into the second bank, over the values from the SSID on. The bytes between
+  // the check key and the first value are unused, the marker there tells that a move was cut by
+  // a reset: the values already overwritten go back to their default.
+  static constexpr uint8_t pm_legacy_checkkey[5] = {0x00, 0x00, 0x00, 0x00, 0x01};
+  static constexpr uint16_t pm_legacy_marker_addr = 5;
+  static constexpr uint8_t pm_legacy_marker[2] = {'B', 'M'};
+  static constexpr uint16_t pm_legacy_addr_nbytes[BN_MEMORY_NUM_KEYS] = {
+    50,   // player
+    100,  // bodypart
+    150,  // bodypart_glove
+    200,  // bodypart_shoe
+    250,  // wifi_ssid
+    300,  // wifi_password
+    350,  // multicast_message
+    400   // magn_calibration, up to the end of the memory
+  };
 
+  static String pm_values[BN_MEMORY_NUM_KEYS];
+  static uint16_t pm_changed;
+  static uint8_t pm_transactions;
+  static uint8_t pm_generation;
+  // Address of the bank in use
+  static uint16_t pm_bank;
+  static uint16_t pm_log_end;
 };
 
 #endif //__BN_ARDUINO_UTILS_H
@@ -0,0 +1,216 @@
+/**
+* MIT License
+* 
+* Copyright (c) 2026 Manuel Bottini
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "BnBinaryMessages.h"
+
+#include <string.h>
+
+uint16_t BnBinaryMessages::nodeId(const String &player, const String &bodypart){
+  // FNV-1a, folded to 16 bits
+  uint32_t hash = 2166136261u;
+  for(uint16_t index = 0; index < player.length(); ++index){
+    hash = (hash ^ static_cast<uint8_t>(player[index])) * 16777619u;
+  }
+  hash = (hash ^ '/') * 16777619u;
+  for(uint16_t index = 0; index < bodypart.length(); ++index){
+    hash = (hash ^ static_cast<uint8_t>(bodypart[index])) * 16777619u;
+  }
+  return static_cast<uint16_t>((hash >> 16) ^ (hash & 0xFFFF));
+}
+
+uint16_t BnBinaryMessages::writeHeader(uint8_t buffer[], uint16_t node_id, uint16_t seq, uint32_t timestamp_us, uint8_t flags){
+  buffer[0] = 'B';
+  buffer[1] = 'N';
+  buffer[2] = BN_BINARY_VERSION;
+  buffer[3] = flags;
+  writeUInt16(&buffer[4], node_id);
+  writeUInt16(&buffer[6], seq);
+  writeUInt32(&buffer[8], timestamp_us);
+  return BN_BINARY_HEADER_BYTES;
+}
+
+uint8_t BnBinaryMessages::recordType(BnType sensortype){
+  switch(sensortype){
+    case BN_SENSORTYPE_ORIENTATION_ABS:
+      return BN_BINARY_RECORD_ORIENTATION_ABS;
+    case BN_SENSORTYPE_ACCELERATION_REL:
+      return BN_BINARY_RECORD_ACCELERATION_REL;
+    case BN_SENSORTYPE_ANGULARVELOCITY_REL:
+      return BN_BINARY_RECORD_ANGULARVELOCITY_REL;
+    case BN_SENSORTYPE_GLOVE:
+      return BN_BINARY_RECORD_GLOVE;
+    case BN_SENSORTYPE_SHOE:
+      return BN_BINARY_RECORD_SHOE;
+    default:
+      return BN_BINARY_RECORD_NONE;
+  }
+}
+
+BnType BnBinaryMessages::recordSensortype(uint8_t record_type){
+  switch(record_type){
+    case BN_BINARY_RECORD_ORIENTATION_ABS:
+      return BN_SENSORTYPE_ORIENTATION_ABS;
+    case BN_BINARY_RECORD_ACCELERATION_REL:
+      return BN_SENSORTYPE_ACCELERATION_REL;
+    case BN_BINARY_RECORD_ANGULARVELOCITY_REL:
+      return BN_SENSORTYPE_ANGULARVELOCITY_REL;
+    case BN_BINARY_RECORD_GLOVE:
+      return BN_SENSORTYPE_GLOVE;
+    case BN_BINARY_RECORD_SHOE:
+      return BN_SENSORTYPE_SHOE;
+  }
+  return BN_SENSORTYPE_NONE;
+}
+
+uint8_t BnBinaryMessages::recordLength(uint8_t record_type){
+  switch(record_type){
+    case BN_BINARY_RECORD_ORIENTATION_ABS:
+      return 1 + 4 * 4;
+    case BN_BINARY_RECORD_ACCELERATION_REL:
+    case BN_BINARY_RECORD_ANGULARVELOCITY_REL:
+      return 1 + 3 * 4;
+    case BN_BINARY_RECORD_GLOVE:
+      return 1 + 9;
+    case BN_BINARY_RECORD_SHOE:
+      return 1 + 1;
+  }
+  return 0;
+}
+
+uint16_t BnBinaryMessages::writeRecord(uint8_t buffer[], uint16_t capacity, BnSensorData &sensorData){
+  const uint8_t type = recordType(sensorData.getType());
+  const uint8_t num_values = sensorData.getNumValues();
+  if(type == BN_BINARY_RECORD_GLOVE || type == BN_BINARY_RECORD_SHOE) {
+    if(capacity < 1 + num_values){
+      return 0;
+    }
+    int values[9];
+    sensorData.getValues(values);
+    buffer[0] = type;
+    for(uint8_t index = 0; index < num_values; ++index){
+      // Angles go from 0 to 90, touch and step values are 0 or 1
+      buffer[1 + index] = static_cast<uint8_t>(constrain(values[index], 0, 255));
+    }
+    return 1 + num_values;
+  } else if(type != BN_BINARY_RECORD_NONE) {
+    if(capacity < 1 + 4 * num_values){
+      return 0;
+    }
+    float values[4];
+    sensorData.getValues(values);
+    buffer[0] = type;
+    for(uint8_t index = 0; index < num_values; ++index){
+      writeFloat(&buffer[1 + 4 * index], values[index]);
+    }
+    return 1 + 4 * num_values;
+  }
+  DEBUG_PRINT("No binary record for sensortype = ");
+  DEBUG_PRINTLN(BnSensorType_toTag(sensorData.getType()));
+  return 0;
+}
+
+bool BnBinaryMessages::readRecord(const uint8_t buffer[], uint16_t length, BnSensorData &sensorData){
+  if(length == 0 || recordLength(buffer[0]) == 0 || length < recordLength(buffer[0])){
+    return false;
+  }
+  const uint8_t type = buffer[0];
+  if(type == BN_BINARY_RECORD_GLOVE || type == BN_BINARY_RECORD_SHOE) {
+    const uint8_t num_values = recordLength(type) - 1;
+    int values[9];
+    for(uint8_t index = 0; index < num_values; ++index){
+      values[index] = buffer[1 + index];
+    }
+    sensorData.setValues(values, recordSensortype(type));
+    return true;
+  }
+  const uint8_t num_values = (recordLength(type) - 1) / 4;
+  float values[4];
+  for(uint8_t index = 0; index < num_values; ++index){
+    values[index] = readFloat(&buffer[1 + 4 * index]);
+  }
+  sensorData.setValues(values, recordSensortype(type));
+  return true;
+}
+
+uint32_t BnBinaryMessages::readTimestamp(const uint8_t buffer[]){
+  return readUInt32(buffer);
+}
+
+uint16_t BnBinaryMessages::writeTimestamp(uint8_t buffer[], uint16_t capacity, uint32_t timestamp_us){
+  if(capacity < BN_BINARY_TIMESTAMP_BYTES){
+    return 0;
+  }
+  writeUInt32(buffer, timestamp_us);
+  return BN_BINARY_TIMESTAMP_BYTES;
+}
+
+uint16_t BnBinaryMessages::writeNodeAnnouncement(uint8_t buffer[], uint16_t capacity, uint16_t node_id, const String *const names[], uint8_t num_names){
+  if(capacity < 4){
+    return 0;
+  }
+  buffer[0] = 'B';
+  buffer[1] = BN_BINARY_VERSION;
+  writeUInt16(&buffer[2], node_id);
+  uint16_t written = 4;
+  for(uint8_t index = 0; index < num_names; ++index){
+    const uint16_t len = names[index]->length();
+    if(written + len + 1 > capacity){
+      return 0;
+    }
+    memcpy(&buffer[written], names[index]->c_str(), len);
+    written += len;
+    buffer[written++] = '\0';
+  }
+  return written;
+}
+
+void BnBinaryMessages::writeUInt16(uint8_t buffer[], uint16_t value){
+  buffer[0] = value & 0xFF;
+  buffer[1] = (value >> 8) & 0xFF;
+}
+
+void BnBinaryMessages::writeUInt32(uint8_t buffer[], uint32_t value){
+  buffer[0] = value & 0xFF;
+  buffer[1] = (value >> 8) & 0xFF;
+  buffer[2] = (value >> 16) & 0xFF;
+  buffer[3] = (value >> 24) & 0xFF;
+}
+
+void BnBinaryMessages::writeFloat(uint8_t buffer[], float value){
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  writeUInt32(buffer, bits);
+}
+
+uint32_t BnBinaryMessages::readUInt32(const uint8_t buffer[]){
+  return static_cast<uint32_t>(buffer[0]) | (static_cast<uint32_t>(buffer[1]) << 8)
+    | (static_cast<uint32_t>(buffer[2]) << 16) | (static_cast<uint32_t>(buffer[3]) << 24);
+}
+
+float BnBinaryMessages::readFloat(const uint8_t buffer[]){
+  const uint32_t bits = readUInt32(buffer);
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
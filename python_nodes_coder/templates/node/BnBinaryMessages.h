@@ -0,0 +1,106 @@
+/**
+* MIT License
+* 
+* Copyright (c) 2026 Manuel Bottini
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "BnConstants.h"
+#include "BnDatatypes.h"
+#include "BnNodeSpecific.h"
+
+#ifndef __BN_BINARY_MESSAGES_H
+#define __BN_BINARY_MESSAGES_H
+
+/*
+Compact binary format for the sensor messages, alternative to the JSON array.
+All the numbers are little endian.
+
+Packet header, 12 bytes:
+  'B' 'N' | version u8 | flags u8 | node id u16 | sequence number u16 | timestamp us u32
+Followed by records, each one made of a type u8 and a fixed size payload:
+  orientation_abs      0x01  4 x float32 (w, x, y, z)   16 bytes
+  acceleration_rel     0x02  3 x float32 (x, y, z)      12 bytes
+  angularvelocity_rel  0x03  3 x float32 (x, y, z)      12 bytes
+  glove                0x04  9 x uint8                   9 bytes
+  shoe                 0x05  1 x uint8                   1 byte
+
+The node id stands for the player and bodypart names. The node announces it after
+the "ACKN\0" bytes of its handshake:
+  'B' | version u8 | node id u16 | player\0 | bodypart\0 | glove bodypart\0 | shoe bodypart\0
+The orientation, acceleration and angular velocity records belong to the bodypart,
+the glove and shoe records to their own bodypart names.
+A host that wants the binary format replies "ACKH" 'B' version, a plain "ACKH" keeps JSON.
+
+With the BN_BINARY_FLAG_TIMESTAMPED flag every record is preceded by the device time in
+microseconds u32 of its reading, the header timestamp is then the time of the flush.
+The batching mode of the WiFi nodes uses it to send many readings per packet.
+BN_BINARY_FLAG_HISTORICAL marks readings taken while the node was not connected to the host
+and sent after it connected again, always together with BN_BINARY_FLAG_TIMESTAMPED.
+With BN_BINARY_FLAG_HOST_TIME the node clock is in sync with the host one: the header timestamp
+and the record timestamps are in host time, otherwise in device time. Both are in microseconds.
+Version 1 had the header timestamp in milliseconds of device time.
+*/
+
+#define BN_BINARY_VERSION 2
+#define BN_BINARY_HEADER_BYTES 12
+#define BN_BINARY_MAX_PACKET_BYTES 512
+#define BN_BINARY_MAX_RECORD_BYTES 17
+#define BN_BINARY_TIMESTAMP_BYTES 4
+
+#define BN_BINARY_FLAG_TIMESTAMPED 0x01
+#define BN_BINARY_FLAG_HISTORICAL  0x02
+#define BN_BINARY_FLAG_HOST_TIME   0x04
+
+#define BN_BINARY_RECORD_NONE                 0x00
+#define BN_BINARY_RECORD_ORIENTATION_ABS      0x01
+#define BN_BINARY_RECORD_ACCELERATION_REL     0x02
+#define BN_BINARY_RECORD_ANGULARVELOCITY_REL  0x03
+#define BN_BINARY_RECORD_GLOVE                0x04
+#define BN_BINARY_RECORD_SHOE                 0x05
+
+class BnBinaryMessages {
+public:
+  static uint16_t nodeId(const String &player, const String &bodypart);
+  static uint16_t writeHeader(uint8_t buffer[], uint16_t node_id, uint16_t seq, uint32_t timestamp_us, uint8_t flags);
+  // Returns the number of bytes written, 0 if the sensor type is unknown or the record does not fit
+  static uint16_t writeRecord(uint8_t buffer[], uint16_t capacity, BnSensorData &sensorData);
+  // Returns the number of bytes written, 0 if the timestamp does not fit
+  static uint16_t writeTimestamp(uint8_t buffer[], uint16_t capacity, uint32_t timestamp_us);
+  static uint16_t writeNodeAnnouncement(uint8_t buffer[], uint16_t capacity, uint16_t node_id, const String *const names[], uint8_t num_names);
+  static uint8_t recordType(BnType sensortype);
+  // Sensortype of a record type, BN_SENSORTYPE_NONE if the type is unknown
+  static BnType recordSensortype(uint8_t record_type);
+  // Size of a record with its type byte, 0 if the type is unknown
+  static uint8_t recordLength(uint8_t record_type);
+  // Reads back a record written by writeRecord, false if it is not valid
+  static bool readRecord(const uint8_t buffer[], uint16_t length, BnSensorData &sensorData);
+  static uint32_t readTimestamp(const uint8_t buffer[]);
+private:
+  BnBinaryMessages(){};
+
+  static void writeUInt16(uint8_t buffer[], uint16_t value);
+  static void writeUInt32(uint8_t buffer[], uint32_t value);
+  static void writeFloat(uint8_t buffer[], float value);
+  static uint32_t readUInt32(const uint8_t buffer[]);
+  static float readFloat(const uint8_t buffer[]);
+};
+
+#endif //__BN_BINARY_MESSAGES_H
@@ -0,0 +1,204 @@
+/**
+* MIT License
+* 
+* Copyright (c) 2026 Manuel Bottini
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "BnChangeDetector.h"
+
+#include <math.h>
+
+BnChangeDetector::BnChangeDetector(){
+    setPolicy(BN_CHANGE_POLICY_ALWAYS, 0);
+    cd_max_silence_ms = BN_CHANGE_MAX_SILENCE_MS;
+    reset();
+}
+
+void BnChangeDetector::setPolicy(uint8_t policy, float threshold){
+    cd_policy = policy;
+    for(uint8_t index = 0; index < BN_CHANGE_MAX_VALUES; ++index){
+        cd_thresholds[index] = threshold;
+    }
+    cd_low_scale = 1;
+    cd_moving = false;
+}
+
+void BnChangeDetector::setComponentThreshold(uint8_t index, float threshold){
+    if(index >= BN_CHANGE_MAX_VALUES){
+        return;
+    }
+    cd_thresholds[index] = threshold;
+}
+
+void BnChangeDetector::setHysteresis(float threshold_low){
+    if(cd_thresholds[0] <= 0 || threshold_low >= cd_thresholds[0]){
+        cd_low_scale = 1;
+    } else if(threshold_low <= 0) {
+        cd_low_scale = 0;
+    } else {
+        cd_low_scale = threshold_low / cd_thresholds[0];
+    }
+}
+
+void BnChangeDetector::setMaxSilence(uint32_t max_silence_ms){
+    cd_max_silence_ms = max_silence_ms;
+}
+
+void BnChangeDetector::setAction(BnAction &action){
+    uint8_t policy = cd_policy;
+    if(action.containsKey(BN_ACTION_SETCHANGEPOLICY_POLICY_TAG)) {
+        const char *policyName = action[BN_ACTION_SETCHANGEPOLICY_POLICY_TAG].as<const char*>();
+        if(policyName == nullptr) {
+            DEBUG_PRINTLN("Change policy is not a string");
+            return;
+        } else if(strcmp(policyName, BN_CHANGE_POLICY_ALWAYS_TAG) == 0) {
+            policy = BN_CHANGE_POLICY_ALWAYS;
+        } else if(strcmp(policyName, BN_CHANGE_POLICY_QUATERNION_ANGLE_TAG) == 0) {
+            policy = BN_CHANGE_POLICY_QUATERNION_ANGLE;
+        } else if(strcmp(policyName, BN_CHANGE_POLICY_VECTOR_NORM_TAG) == 0) {
+            policy = BN_CHANGE_POLICY_VECTOR_NORM;
+        } else if(strcmp(policyName, BN_CHANGE_POLICY_COMPONENT_TAG) == 0) {
+            policy = BN_CHANGE_POLICY_COMPONENT;
+        } else {
+            DEBUG_PRINT("Unknown change policy = ");
+            DEBUG_PRINTLN(policyName);
+            return;
+        }
+    }
+    if(action.containsKey(BN_ACTION_SETCHANGEPOLICY_THRESHOLD_TAG)) {
+        setPolicy(policy, action[BN_ACTION_SETCHANGEPOLICY_THRESHOLD_TAG].as<float>());
+    } else if(policy != cd_policy) {
+        setPolicy(policy, cd_thresholds[0]);
+    }
+    if(action.containsKey(BN_ACTION_SETCHANGEPOLICY_THRESHOLD_LOW_TAG)) {
+        setHysteresis(action[BN_ACTION_SETCHANGEPOLICY_THRESHOLD_LOW_TAG].as<float>());
+    }
+    if(action.containsKey(BN_ACTION_SETCHANGEPOLICY_MAX_SILENCE_MS_TAG)) {
+        setMaxSilence(action[BN_ACTION_SETCHANGEPOLICY_MAX_SILENCE_MS_TAG].as<uint32_t>());
+    }
+    // The new policy starts from a fresh reading
+    reset();
+}
+
+const char *BnChangeDetector::policyName(uint8_t policy){
+    switch(policy){
+        case BN_CHANGE_POLICY_ALWAYS:
+            return BN_CHANGE_POLICY_ALWAYS_TAG;
+        case BN_CHANGE_POLICY_QUATERNION_ANGLE:
+            return BN_CHANGE_POLICY_QUATERNION_ANGLE_TAG;
+        case BN_CHANGE_POLICY_VECTOR_NORM:
+            return BN_CHANGE_POLICY_VECTOR_NORM_TAG;
+        case BN_CHANGE_POLICY_COMPONENT:
+            return BN_CHANGE_POLICY_COMPONENT_TAG;
+    }
+    return nullptr;
+}
+
+void BnChangeDetector::reset(){
+    cd_num_values = 0;
+    cd_has_last = false;
+    cd_moving = false;
+    cd_last_sent_ms = 0;
+}
+
+bool BnChangeDetector::hasChanged(const float values[], uint8_t num_values, uint32_t now_ms){
+    if(num_values > BN_CHANGE_MAX_VALUES){
+        num_values = BN_CHANGE_MAX_VALUES;
+    }
+    bool send;
+    if(!cd_has_last || num_values != cd_num_values) {
+        send = true;
+    } else if(exceeds(values, cd_moving ? cd_low_scale : 1)) {
+        send = true;
+        cd_moving = true;
+    } else {
+        cd_moving = false;
+        send = cd_max_silence_ms > 0 && now_ms - cd_last_sent_ms >= cd_max_silence_ms;
+    }
+    if(send) {
+        for(uint8_t index = 0; index < num_values; ++index){
+            cd_last_values[index] = values[index];
+        }
+        cd_num_values = num_values;
+        cd_has_last = true;
+        cd_last_sent_ms = now_ms;
+    }
+    return send;
+}
+
+bool BnChangeDetector::hasChanged(const int values[], uint8_t num_values, uint32_t now_ms){
+    float float_values[BN_CHANGE_MAX_VALUES];
+    if(num_values > BN_CHANGE_MAX_VALUES){
+        num_values = BN_CHANGE_MAX_VALUES;
+    }
+    for(uint8_t index = 0; index < num_values; ++index){
+        float_values[index] = values[index];
+    }
+    return hasChanged(float_values, num_values, now_ms);
+}
+
+bool BnChangeDetector::exceeds(const float values[], float scale){
+    switch(cd_policy) {
+    case BN_CHANGE_POLICY_QUATERNION_ANGLE:
+        return quaternionAngle(values) > cd_thresholds[0] * scale;
+    case BN_CHANGE_POLICY_VECTOR_NORM:
+        return vectorNorm(values) > cd_thresholds[0] * scale;
+    case BN_CHANGE_POLICY_COMPONENT:
+        for(uint8_t index = 0; index < cd_num_values; ++index){
+            if(fabsf(values[index] - cd_last_values[index]) > cd_thresholds[index] * scale){
+                return true;
+            }
+        }
+        return false;
+    default:
+        return true;
+    }
+}
+
+float BnChangeDetector::quaternionAngle(const float values[]){
+    if(cd_num_values != 4){
+        return vectorNorm(values);
+    }
+    // The chord between two unit quaternions is 2*sin(angle/4), precise also for tiny angles
+    // where acos of the dot product is not. The shorter of |q-p| and |q+p| takes care of q = -p
+    float diff2 = 0;
+    float sum2 = 0;
+    for(uint8_t index = 0; index < 4; ++index){
+        float diff = values[index] - cd_last_values[index];
+        float sum = values[index] + cd_last_values[index];
+        diff2 += diff * diff;
+        sum2 += sum * sum;
+    }
+    float chord = sqrtf(diff2 < sum2 ? diff2 : sum2);
+    if(chord > 2){
+        chord = 2;
+    }
+    return 4 * asinf(chord / 2);
+}
+
+float BnChangeDetector::vectorNorm(const float values[]){
+    float norm2 = 0;
+    for(uint8_t index = 0; index < cd_num_values; ++index){
+        float diff = values[index] - cd_last_values[index];
+        norm2 += diff * diff;
+    }
+    return sqrtf(norm2);
+}
@@ -0,0 +1,114 @@
+/**
+* MIT License
+* 
+* Copyright (c) 2026 Manuel Bottini
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "BnNodeSpecific.h"
+#include "BnDatatypes.h"
+
+#ifndef __BN_CHANGE_DETECTOR_H
+#define __BN_CHANGE_DETECTOR_H
+
+// Decides which sensor readings are worth sending, one detector per sensor.
+// A reading is sent when it moved more than the threshold from the last sent one:
+//   quaternion_angle  rotation angle in radians between the two quaternions, q and -q are the same
+//   vector_norm       norm of the difference of the two vectors
+//   component         any component moved more than its own threshold
+//   always            every reading
+// With hysteresis (threshold_low < threshold) a sensor that started moving keeps sending while it
+// moves more than threshold_low, so slow motions are not cut in steps, and goes quiet below it.
+// With a max silence the last value is sent again when nothing was sent for max_silence_ms.
+// The first reading is always sent.
+// The "set_change_policy" action changes the policy of a sensor at runtime.
+
+#define BN_CHANGE_POLICY_ALWAYS             0
+#define BN_CHANGE_POLICY_QUATERNION_ANGLE   1
+#define BN_CHANGE_POLICY_VECTOR_NORM        2
+#define BN_CHANGE_POLICY_COMPONENT          3
+
+#define BN_CHANGE_MAX_VALUES 9
+
+#ifndef BN_CHANGE_POLICY_ALWAYS_TAG
+#define BN_CHANGE_POLICY_ALWAYS_TAG "always"
+#endif
+#ifndef BN_CHANGE_POLICY_QUATERNION_ANGLE_TAG
+#define BN_CHANGE_POLICY_QUATERNION_ANGLE_TAG "quaternion_angle"
+#endif
+#ifndef BN_CHANGE_POLICY_VECTOR_NORM_TAG
+#define BN_CHANGE_POLICY_VECTOR_NORM_TAG "vector_norm"
+#endif
+#ifndef BN_CHANGE_POLICY_COMPONENT_TAG
+#define BN_CHANGE_POLICY_COMPONENT_TAG "component"
+#endif
+
+// Default thresholds, the board can define its own
+#ifndef BIG_QUAT_ANGLE
+// Radians, 0.5 degrees. It sends fewer orientations than the previous BIG_QUAT_DIFF on each
+// component, see templates/host/BnHostTestChangeDetector.cpp
+#define BIG_QUAT_ANGLE 0.0087f
+#endif
+
+// Default keepalive of every sensor, 0 to never send a reading again
+#ifndef BN_CHANGE_MAX_SILENCE_MS
+#define BN_CHANGE_MAX_SILENCE_MS 1000
+#endif
+
+class BnChangeDetector {
+public:
+    BnChangeDetector();
+
+    // Also clears the hysteresis, threshold_low goes back to threshold
+    void setPolicy(uint8_t policy, float threshold);
+    // Only for the component policy, after setPolicy
+    void setComponentThreshold(uint8_t index, float threshold);
+    void setHysteresis(float threshold_low);
+    void setMaxSilence(uint32_t max_silence_ms);
+    // From the "set_change_policy" action, the keys missing in the action keep their value
+    void setAction(BnAction &action);
+    // Name of a BN_CHANGE_POLICY_* in the actions, nullptr if it is not a policy
+    static const char *policyName(uint8_t policy);
+
+    // True when the values have to be sent, they become the new reference
+    bool hasChanged(const float values[], uint8_t num_values, uint32_t now_ms);
+    bool hasChanged(const int values[], uint8_t num_values, uint32_t now_ms);
+    // The next reading will be sent
+    void reset();
+
+private:
+    bool exceeds(const float values[], float scale);
+    float quaternionAngle(const float values[]);
+    float vectorNorm(const float values[]);
+
+    uint8_t cd_policy;
+    float cd_thresholds[BN_CHANGE_MAX_VALUES];
+    // threshold_low / threshold, applied while moving
+    float cd_low_scale;
+    uint32_t cd_max_silence_ms;
+
+    float cd_last_values[BN_CHANGE_MAX_VALUES];
+    uint8_t cd_num_values;
+    bool cd_has_last;
+    bool cd_moving;
+    uint32_t cd_last_sent_ms;
+};
+
+#endif // __BN_CHANGE_DETECTOR_H
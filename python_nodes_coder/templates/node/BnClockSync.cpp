@@ -0,0 +1,114 @@
+/**
+* MIT License
+* 
+* Copyright (c) 2026 Manuel Bottini
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "BnClockSync.h"
+
+BnClockSync::BnClockSync(){
+    reset();
+}
+
+void BnClockSync::reset(){
+    cs_synced = false;
+    cs_offset = 0;
+    cs_ref_us = 0;
+    cs_drift = 0;
+    cs_delay = 0;
+    cs_num_delays = 0;
+    cs_next_delay = 0;
+}
+
+bool BnClockSync::addSample(uint32_t t0_us, uint32_t t1_us, uint32_t t2_us, uint32_t t3_us){
+    const int32_t round_trip = static_cast<int32_t>(t3_us - t0_us);
+    const int32_t host_time = static_cast<int32_t>(t2_us - t1_us);
+    if(round_trip < 0 || host_time < 0 || host_time > round_trip){
+        return false;
+    }
+    const uint32_t delay = round_trip - host_time;
+    cs_delays[cs_next_delay] = delay;
+    cs_next_delay = (cs_next_delay + 1) % BN_CLOCK_SYNC_DELAYS;
+    if(cs_num_delays < BN_CLOCK_SYNC_DELAYS){
+        ++cs_num_delays;
+    }
+    if(delay > 2 * minDelay() + BN_CLOCK_SYNC_DELAY_MARGIN_US){
+        return false;
+    }
+
+    // Same as ((t1 - t0) + (t2 - t3)) / 2, in unsigned arithmetic so that it wraps around like the clocks
+    const uint32_t offset = t1_us - t0_us - delay / 2;
+    const uint32_t sample_us = t0_us + round_trip / 2;
+    if(cs_synced){
+        const int32_t elapsed = static_cast<int32_t>(sample_us - cs_ref_us);
+        const uint32_t predicted = static_cast<uint32_t>(getOffset(sample_us));
+        const int32_t error = static_cast<int32_t>(offset - predicted);
+        if(error > BN_CLOCK_SYNC_RESET_ERROR_US || error < -BN_CLOCK_SYNC_RESET_ERROR_US){
+            DEBUG_PRINTLN("Clock sync lost, starting again");
+            cs_synced = false;
+        } else if(elapsed > 0) {
+            // The offset moves halfway to the sample, the drift takes the rest of the error slowly
+            cs_offset = predicted + error / 2;
+            cs_drift += 0.25f * static_cast<float>(error) / static_cast<float>(elapsed);
+            cs_drift = constrain(cs_drift, -BN_CLOCK_SYNC_MAX_DRIFT, BN_CLOCK_SYNC_MAX_DRIFT);
+            cs_ref_us = sample_us;
+        }
+    }
+    if(!cs_synced){
+        cs_offset = offset;
+        cs_ref_us = sample_us;
+        cs_drift = 0;
+        cs_synced = true;
+    }
+    cs_delay = delay;
+    return true;
+}
+
+bool BnClockSync::isSynced() const {
+    return cs_synced;
+}
+
+uint32_t BnClockSync::toHostTime(uint32_t node_us) const {
+    return node_us + static_cast<uint32_t>(getOffset(node_us));
+}
+
+int32_t BnClockSync::getOffset(uint32_t now_us) const {
+    const int32_t elapsed = static_cast<int32_t>(now_us - cs_ref_us);
+    return static_cast<int32_t>(cs_offset + static_cast<int32_t>(cs_drift * static_cast<float>(elapsed)));
+}
+
+float BnClockSync::getDriftPpm() const {
+    return cs_drift * 1000000.0f;
+}
+
+uint32_t BnClockSync::getDelay() const {
+    return cs_delay;
+}
+
+uint32_t BnClockSync::minDelay() const {
+    uint32_t min_delay = cs_delays[0];
+    for(uint8_t index = 1; index < cs_num_delays; ++index){
+        if(cs_delays[index] < min_delay){
+            min_delay = cs_delays[index];
+        }
+    }
+    return min_delay;
+}
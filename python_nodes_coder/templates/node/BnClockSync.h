@@ -0,0 +1,81 @@
+/**
+* MIT License
+* 
+* Copyright (c) 2026 Manuel Bottini
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "BnNodeSpecific.h"
+
+#ifndef __BN_CLOCK_SYNC_H
+#define __BN_CLOCK_SYNC_H
+
+// Estimate of the host clock from the node clock, NTP style. The node sends its time t0, the host
+// replies with the time t1 it received the request and the time t2 it sent the reply, the node
+// notes the time t3 the reply arrived. All the times are in microseconds and wrap around.
+//   offset = ((t1 - t0) + (t2 - t3)) / 2     host time - node time
+//   delay  = (t3 - t0) - (t2 - t1)           round trip spent on the network and in the loops
+// The offset is off by at most half the delay, so only the samples with a delay close to the
+// smallest one seen lately are used. The drift between the two clocks is followed as well,
+// so the offset stays right between two samples.
+
+// Samples with a delay above twice the smallest one plus this margin are discarded
+#ifndef BN_CLOCK_SYNC_DELAY_MARGIN_US
+#define BN_CLOCK_SYNC_DELAY_MARGIN_US 1000
+#endif
+// A sample this far from the estimate means that one of the clocks restarted
+#ifndef BN_CLOCK_SYNC_RESET_ERROR_US
+#define BN_CLOCK_SYNC_RESET_ERROR_US 100000
+#endif
+// Number of recent delays the smallest one is taken from
+#define BN_CLOCK_SYNC_DELAYS 8
+// Crystals are within a few tens of ppm, anything beyond is noise
+#define BN_CLOCK_SYNC_MAX_DRIFT 0.0005f
+
+class BnClockSync {
+public:
+    BnClockSync();
+
+    void reset();
+    // True when the sample was used
+    bool addSample(uint32_t t0_us, uint32_t t1_us, uint32_t t2_us, uint32_t t3_us);
+    bool isSynced() const;
+    uint32_t toHostTime(uint32_t node_us) const;
+    // Host time - node time, at node time now_us
+    int32_t getOffset(uint32_t now_us) const;
+    // Host microseconds gained per node microsecond, in parts per million
+    float getDriftPpm() const;
+    // Delay of the last sample used
+    uint32_t getDelay() const;
+
+private:
+    uint32_t minDelay() const;
+
+    bool cs_synced;
+    uint32_t cs_offset;
+    uint32_t cs_ref_us;
+    float cs_drift;
+    uint32_t cs_delay;
+    uint32_t cs_delays[BN_CLOCK_SYNC_DELAYS];
+    uint8_t cs_num_delays;
+    uint8_t cs_next_delay;
+};
+
+#endif // __BN_CLOCK_SYNC_H
@@ -0,0 +1,42 @@
+/**
+* MIT License
+* 
+* Copyright (c) 2026 Manuel Bottini
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "BnControlFrames.h"
+
+bool BnControlFrames::isFrame(const uint8_t buffer[], uint16_t length){
+  return length > 0 && buffer[0] == BN_CONTROL_MAGIC;
+}
+
+bool BnControlFrames::readFrame(const uint8_t buffer[], uint16_t length, BnControlFrame &frame){
+  if(length < BN_CONTROL_HEADER_BYTES || buffer[0] != BN_CONTROL_MAGIC){
+    return false;
+  }
+  frame.type = buffer[1];
+  frame.length = static_cast<uint16_t>(buffer[2]) | (static_cast<uint16_t>(buffer[3]) << 8);
+  if(frame.length > length - BN_CONTROL_HEADER_BYTES){
+    return false;
+  }
+  frame.payload = &buffer[BN_CONTROL_HEADER_BYTES];
+  return true;
+}
@@ -0,0 +1,82 @@
+/**
+* MIT License
+* 
+* Copyright (c) 2026 Manuel Bottini
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "BnNodeSpecific.h"
+
+#ifndef __BN_CONTROL_FRAMES_H
+#define __BN_CONTROL_FRAMES_H
+
+/*
+Control frames that the host sends to a WiFi node, all the numbers little endian:
+  magic u8 0xBC | type u8 | payload length u16 | payload
+  ACKH       0x01  binary version u8 (0 for the JSON messages) [t0 u32 | t1 u32 | t2 u32]
+  MULTICAST  0x02  the multicast message of the node (e.g. "BN")
+The magic byte cannot start a JSON action nor a text message, so a frame is told apart from them
+by its first byte. The node reports that it reads the frames with 'C' and BN_CONTROL_VERSION at
+the end of its ACKN. The text "ACKH" and the bare multicast message are still accepted.
+
+A BLE node takes the same frames on its control characteristic, one or more per write, for the
+actions that a WiFi node takes as JSON. The sensors are given by their BN_BINARY_RECORD_* type.
+  HAPTIC             0x10  duration ms u16 | strength u8
+  ENABLE_SENSOR      0x11  record type u8 | enable u8 (0 or 1)
+  SET_PLAYER         0x12  the new player, without terminator
+  SET_BODYPART       0x13  the new bodypart, without terminator
+  SET_CHANGE_POLICY  0x14  record type u8 | policy u8 (BN_CHANGE_POLICY_*, 0xFF keeps it)
+                           [threshold f32 [threshold low f32 [max silence ms u32]]]
+  CALIBRATE_MAGN     0x15  duration ms u32
+The values left out of SET_CHANGE_POLICY keep their value, like the keys left out of the JSON action.
+*/
+
+#define BN_CONTROL_VERSION 1
+#define BN_CONTROL_MAGIC 0xBC
+#define BN_CONTROL_HEADER_BYTES 4
+
+#define BN_CONTROL_TYPE_ACKH       0x01
+#define BN_CONTROL_TYPE_MULTICAST  0x02
+
+#define BN_CONTROL_TYPE_HAPTIC             0x10
+#define BN_CONTROL_TYPE_ENABLE_SENSOR      0x11
+#define BN_CONTROL_TYPE_SET_PLAYER         0x12
+#define BN_CONTROL_TYPE_SET_BODYPART       0x13
+#define BN_CONTROL_TYPE_SET_CHANGE_POLICY  0x14
+#define BN_CONTROL_TYPE_CALIBRATE_MAGN     0x15
+
+#define BN_CONTROL_KEEP_POLICY 0xFF
+
+struct BnControlFrame {
+  uint8_t type;
+  uint16_t length;
+  const uint8_t *payload;
+};
+
+class BnControlFrames {
+public:
+  static bool isFrame(const uint8_t buffer[], uint16_t length);
+  // False if the buffer does not start with a whole frame
+  static bool readFrame(const uint8_t buffer[], uint16_t length, BnControlFrame &frame);
+private:
+  BnControlFrames(){};
+};
+
+#endif //__BN_CONTROL_FRAMES_H
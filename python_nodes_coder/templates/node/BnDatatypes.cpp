@@ -49,29 +49,70 @@ void BnIPConnectionData::cleanBytes(){ num_received_bytes = 0; }
 
 #endif
 
+BnSensorType BnSensorType_fromTag(const char *tag){
+    if(tag == nullptr){
+        return BN_SENSORTYPE_NONE;
+    }
+    for(uint8_t index = 1; index < BN_SENSORTYPE_NUM; ++index){
+        if(strcmp(tag, BN_SENSORTYPE_TAGS[index]) == 0){
+            return static_cast<BnSensorType>(index);
+        }
+    }
+    return BN_SENSORTYPE_NONE;
+}
+
+BnActionType BnActionType_fromTag(const char *tag){
+    if(tag == nullptr){
+        return BN_ACTION_TYPE_NONE;
+    }
+    for(uint8_t index = 1; index < BN_ACTION_TYPE_NUM; ++index){
+        if(strcmp(tag, BN_ACTION_TYPE_TAGS[index]) == 0){
+            return static_cast<BnActionType>(index);
+        }
+    }
+    return BN_ACTION_TYPE_NONE;
+}
+
 BnType BnSensorData::getType(){
     return sd_sensortype;
 }
 
+uint8_t BnSensorData::getNumValues(){
+    return sd_num_values;
+}
+
+void BnSensorData::setNumValues(){
+    switch(sd_sensortype){
+        case BN_SENSORTYPE_ORIENTATION_ABS:
+            sd_num_values = 4;
+            break;
+        case BN_SENSORTYPE_ACCELERATION_REL:
+        case BN_SENSORTYPE_ANGULARVELOCITY_REL:
+            sd_num_values = 3;
+            break;
+        case BN_SENSORTYPE_GLOVE:
+            sd_num_values = 9;
+            break;
+        case BN_SENSORTYPE_SHOE:
+            sd_num_values = 1;
+            break;
+        default:
+            sd_num_values = 0;
+            break;
+    }
+}
+
 void BnSensorData::setValues(float values[], BnType sensortype){
     sd_sensortype = sensortype;
-    if(sd_sensortype.equals(BN_SENSORTYPE_ORIENTATION_ABS_TAG)) {
-        sd_num_values = 4;
-    } else if(sd_sensortype.equals(BN_SENSORTYPE_ACCELERATION_REL_TAG)) {
-        sd_num_values = 3;
-    }
-    for(uint8_t index = 0; index<sd_num_values; ++index){
+    setNumValues();
+    for(uint8_t index = 0; index<sd_num_values && index<5; ++index){
         sd_values_float[index] = values[index];
     }
 }
 
 void BnSensorData::setValues(int values[], BnType sensortype){
     sd_sensortype = sensortype;
-    if(sd_sensortype.equals(BN_SENSORTYPE_ORIENTATION_ABS_TAG)) {
-        sd_num_values = 4;
-    } else if(sd_sensortype.equals(BN_SENSORTYPE_ACCELERATION_REL_TAG)) {
-        sd_num_values = 3;
-    }
+    setNumValues();
     for(uint8_t index = 0; index<sd_num_values; ++index){
         sd_values_int[index] = values[index];
     }
@@ -90,5 +131,23 @@ void BnSensorData::getValues(int values[]){
 }
 
 bool BnSensorData::isEmpty(){
-        return sd_sensortype == BN_SENSORTYPE_NONE_TAG;
+        return sd_sensortype == BN_SENSORTYPE_NONE;
+}
+
+void BnSensorData::toJsonMessage(JsonObject &message, const String &player, const String &bodypart){
+    message["player"] = player;
+    message["bodypart"] = bodypart;
+    message["sensortype"] = BnSensorType_toTag(sd_sensortype);
+    if(sd_sensortype == BN_SENSORTYPE_SHOE) {
+        // The shoe sends a single value, not an array
+        message["value"] = sd_values_int[0];
+    } else if(sd_sensortype == BN_SENSORTYPE_GLOVE) {
+        for(uint8_t index = 0; index<sd_num_values; ++index){
+            message["value"].add(sd_values_int[index]);
+        }
+    } else {
+        for(uint8_t index = 0; index<sd_num_values; ++index){
+            message["value"].add(sd_values_float[index]);
+        }
+    }
 }
\ No newline at end of file
@@ -35,14 +35,120 @@
 #define BN_ISENSOR_DATATYPE_GYROSCOPE              1
 #define BN_ISENSOR_DATATYPE_MAGNETOMETER           2
 #define BN_ISENSOR_DATATYPE_ABSOLUTEORIENTATION    3
+#define BN_ISENSOR_NUM_DATATYPES                   4
+
+// Magnetometer calibration, stored in the persistent memory as "ox,oy,oz,sx,sy,sz"
+#ifndef BN_MEMORY_MAGN_CALIBRATION_TAG
+#define BN_MEMORY_MAGN_CALIBRATION_TAG "magn_calibration"
+#endif
+#ifndef BN_ACTION_TYPE_CALIBRATEMAGN_TAG
+#define BN_ACTION_TYPE_CALIBRATEMAGN_TAG "calibrate_magn"
+#endif
+#ifndef BN_ACTION_CALIBRATEMAGN_DURATION_MS_TAG
+#define BN_ACTION_CALIBRATEMAGN_DURATION_MS_TAG "duration_ms"
+#endif
+
+// Batching of the WiFi messages, see BnWifiNodeCommunicator.h
+#ifndef BN_ACTION_TYPE_SETBATCHING_TAG
+#define BN_ACTION_TYPE_SETBATCHING_TAG "set_batching"
+#endif
+#ifndef BN_ACTION_SETBATCHING_BATCH_SIZE_TAG
+#define BN_ACTION_SETBATCHING_BATCH_SIZE_TAG "batch_size"
+#endif
+#ifndef BN_ACTION_SETBATCHING_FLUSH_MS_TAG
+#define BN_ACTION_SETBATCHING_FLUSH_MS_TAG "flush_ms"
+#endif
+
+// Change detection policy of a sensor, see BnChangeDetector.h
+#ifndef BN_ACTION_TYPE_SETCHANGEPOLICY_TAG
+#define BN_ACTION_TYPE_SETCHANGEPOLICY_TAG "set_change_policy"
+#endif
+#ifndef BN_ACTION_SETCHANGEPOLICY_SENSORTYPE_TAG
+#define BN_ACTION_SETCHANGEPOLICY_SENSORTYPE_TAG "sensortype"
+#endif
+#ifndef BN_ACTION_SETCHANGEPOLICY_POLICY_TAG
+#define BN_ACTION_SETCHANGEPOLICY_POLICY_TAG "policy"
+#endif
+#ifndef BN_ACTION_SETCHANGEPOLICY_THRESHOLD_TAG
+#define BN_ACTION_SETCHANGEPOLICY_THRESHOLD_TAG "threshold"
+#endif
+#ifndef BN_ACTION_SETCHANGEPOLICY_THRESHOLD_LOW_TAG
+#define BN_ACTION_SETCHANGEPOLICY_THRESHOLD_LOW_TAG "threshold_low"
+#endif
+#ifndef BN_ACTION_SETCHANGEPOLICY_MAX_SILENCE_MS_TAG
+#define BN_ACTION_SETCHANGEPOLICY_MAX_SILENCE_MS_TAG "max_silence_ms"
+#endif
+
+// Loop timing stats sent by the nodes built with BN_PROFILE, see BnProfiler.h
+#ifndef BN_SENSORTYPE_STATS_TAG
+#define BN_SENSORTYPE_STATS_TAG "stats"
+#endif
+// Link counters sent by the WiFi nodes, see BnWifiNodeCommunicator.h
+#ifndef BN_SENSORTYPE_LINK_STATS_TAG
+#define BN_SENSORTYPE_LINK_STATS_TAG "link_stats"
+#endif
 
 struct BnStatusLED {
   bool on;
   unsigned long lastToggle;
 };
 
-using BnKey = String;
-using BnType = String;
+// The sensor and action types are ids inside the node, the string tags are only used at the
+// JSON boundary, when writing the messages and reading the actions.
+enum BnSensorType : uint8_t {
+  BN_SENSORTYPE_NONE = 0,
+  BN_SENSORTYPE_ORIENTATION_ABS,
+  BN_SENSORTYPE_ACCELERATION_REL,
+  BN_SENSORTYPE_ANGULARVELOCITY_REL,
+  BN_SENSORTYPE_GLOVE,
+  BN_SENSORTYPE_SHOE,
+  BN_SENSORTYPE_NUM
+};
+
+enum BnActionType : uint8_t {
+  BN_ACTION_TYPE_NONE = 0,
+  BN_ACTION_TYPE_HAPTIC,
+  BN_ACTION_TYPE_ENABLESENSOR,
+  BN_ACTION_TYPE_SETPLAYER,
+  BN_ACTION_TYPE_SETBODYPART,
+  BN_ACTION_TYPE_SETWIFI,
+  BN_ACTION_TYPE_SETBATCHING,
+  BN_ACTION_TYPE_SETCHANGEPOLICY,
+  BN_ACTION_TYPE_CALIBRATEMAGN,
+  BN_ACTION_TYPE_NUM
+};
+
+// Indexed by the ids above
+constexpr const char *BN_SENSORTYPE_TAGS[BN_SENSORTYPE_NUM] = {
+  BN_SENSORTYPE_NONE_TAG,
+  BN_SENSORTYPE_ORIENTATION_ABS_TAG,
+  BN_SENSORTYPE_ACCELERATION_REL_TAG,
+  BN_SENSORTYPE_ANGULARVELOCITY_REL_TAG,
+  BN_SENSORTYPE_GLOVE_TAG,
+  BN_SENSORTYPE_SHOE_TAG
+};
+
+constexpr const char *BN_ACTION_TYPE_TAGS[BN_ACTION_TYPE_NUM] = {
+  "",
+  BN_ACTION_TYPE_HAPTIC_TAG,
+  BN_ACTION_TYPE_ENABLESENSOR_TAG,
+  BN_ACTION_TYPE_SETPLAYER_TAG,
+  BN_ACTION_TYPE_SETBODYPART_TAG,
+  BN_ACTION_TYPE_SETWIFI_TAG,
+  BN_ACTION_TYPE_SETBATCHING_TAG,
+  BN_ACTION_TYPE_SETCHANGEPOLICY_TAG,
+  BN_ACTION_TYPE_CALIBRATEMAGN_TAG
+};
+
+inline const char *BnSensorType_toTag(BnSensorType sensortype){
+  return sensortype < BN_SENSORTYPE_NUM ? BN_SENSORTYPE_TAGS[sensortype] : BN_SENSORTYPE_NONE_TAG;
+}
+// BN_SENSORTYPE_NONE for an unknown tag or nullptr
+BnSensorType BnSensorType_fromTag(const char *tag);
+// BN_ACTION_TYPE_NONE for an unknown tag or nullptr
+BnActionType BnActionType_fromTag(const char *tag);
+
+using BnType = BnSensorType;
 using BnAction = JsonObject;
 
 #ifdef BLE_COMMUNICATION
@@ -96,13 +202,18 @@ public:
     void getValues(float values[]);
     void getValues(int values[]);
     BnType getType();
+    uint8_t getNumValues();
     bool isEmpty();
+    // Fills a JSON message with the "player", "bodypart", "sensortype" and "value" keys
+    void toJsonMessage(JsonObject &message, const String &player, const String &bodypart);
 
 private:
-    BnType sd_sensortype = BN_SENSORTYPE_NONE_TAG;
+    void setNumValues();
+
+    BnType sd_sensortype = BN_SENSORTYPE_NONE;
     float sd_values_float[5];
-    int16_t sd_values_int[5];
-    uint8_t sd_num_values;
+    int16_t sd_values_int[9];
+    uint8_t sd_num_values = 0;
 };
 
 
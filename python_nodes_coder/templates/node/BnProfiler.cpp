@@ -0,0 +1,134 @@
+/**
+* MIT License
+* 
+* Copyright (c) 2026 Manuel Bottini
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "BnProfiler.h"
+
+#ifdef BN_PROFILE
+
+static const char *sStageNames[BN_PROFILE_NUM_STAGES] = {
+    "loop", "communicator", "sensors", "isensor_read", "fusion", "add_message", "send", "actions"
+};
+
+BnProfileStageStats BnProfiler::sStages[BN_PROFILE_NUM_STAGES];
+uint32_t BnProfiler::sWindowStart_ms = 0;
+
+void BnProfiler::record(uint8_t stage, uint32_t elapsed_us){
+    BnProfileStageStats &stats = sStages[stage];
+    if(stats.count == 0 || elapsed_us < stats.min_us){
+        stats.min_us = elapsed_us;
+    }
+    if(elapsed_us > stats.max_us){
+        stats.max_us = elapsed_us;
+    }
+    ++stats.count;
+    stats.total_us += elapsed_us;
+
+    stats.ring_us[stats.ring_next] = elapsed_us > UINT16_MAX ? UINT16_MAX : elapsed_us;
+    stats.ring_next = (stats.ring_next + 1) % BN_PROFILE_RING_SIZE;
+    if(stats.ring_len < BN_PROFILE_RING_SIZE){
+        ++stats.ring_len;
+    }
+}
+
+bool BnProfiler::isReportTime(){
+    return millis() - sWindowStart_ms >= BN_PROFILE_REPORT_INTERVAL_MS;
+}
+
+uint32_t BnProfiler::percentile99(uint8_t stage){
+    const BnProfileStageStats &stats = sStages[stage];
+    if(stats.ring_len == 0){
+        return 0;
+    }
+    // Insertion sort of a copy, it only happens when reporting
+    uint16_t sorted[BN_PROFILE_RING_SIZE];
+    for(uint16_t index = 0; index < stats.ring_len; ++index){
+        uint16_t value = stats.ring_us[index];
+        uint16_t pos = index;
+        while(pos > 0 && sorted[pos - 1] > value){
+            sorted[pos] = sorted[pos - 1];
+            --pos;
+        }
+        sorted[pos] = value;
+    }
+    // Nearest rank
+    uint16_t rank = (stats.ring_len * 99 + 99) / 100;
+    return sorted[rank - 1];
+}
+
+void BnProfiler::printReport(){
+    DEBUG_PRINT("Profile over ");
+    DEBUG_PRINT(millis() - sWindowStart_ms);
+    DEBUG_PRINTLN(" ms, stage: count avg min max p99 (us)");
+    for(uint8_t stage = 0; stage < BN_PROFILE_NUM_STAGES; ++stage){
+        const BnProfileStageStats &stats = sStages[stage];
+        if(stats.count == 0){
+            continue;
+        }
+        DEBUG_PRINT(sStageNames[stage]);
+        DEBUG_PRINT(": ");
+        DEBUG_PRINT(stats.count);
+        DEBUG_PRINT(" ");
+        DEBUG_PRINT(stats.total_us / stats.count);
+        DEBUG_PRINT(" ");
+        DEBUG_PRINT(stats.min_us);
+        DEBUG_PRINT(" ");
+        DEBUG_PRINT(stats.max_us);
+        DEBUG_PRINT(" ");
+        DEBUG_PRINTLN(percentile99(stage));
+    }
+}
+
+void BnProfiler::toJsonMessage(JsonObject &message, const String &player, const String &bodypart){
+    message["player"] = player;
+    message["bodypart"] = bodypart;
+    message["sensortype"] = BN_SENSORTYPE_STATS_TAG;
+    JsonObject value = message.createNestedObject("value");
+    value["window_ms"] = millis() - sWindowStart_ms;
+    for(uint8_t stage = 0; stage < BN_PROFILE_NUM_STAGES; ++stage){
+        const BnProfileStageStats &stats = sStages[stage];
+        if(stats.count == 0){
+            continue;
+        }
+        // [count, avg, min, max, p99] in microseconds
+        JsonArray stage_stats = value.createNestedArray(sStageNames[stage]);
+        stage_stats.add(stats.count);
+        stage_stats.add(stats.total_us / stats.count);
+        stage_stats.add(stats.min_us);
+        stage_stats.add(stats.max_us);
+        stage_stats.add(percentile99(stage));
+    }
+}
+
+void BnProfiler::reset(){
+    for(uint8_t stage = 0; stage < BN_PROFILE_NUM_STAGES; ++stage){
+        BnProfileStageStats &stats = sStages[stage];
+        stats.count = 0;
+        stats.total_us = 0;
+        stats.min_us = 0;
+        stats.max_us = 0;
+    }
+    sWindowStart_ms = millis();
+}
+
+#endif // BN_PROFILE
@@ -0,0 +1,102 @@
+/**
+* MIT License
+* 
+* Copyright (c) 2026 Manuel Bottini
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "BnNodeSpecific.h"
+#include "BnDatatypes.h"
+
+#ifndef __BN_PROFILER_H
+#define __BN_PROFILER_H
+
+// Loop timing instrumentation, enabled by defining BN_PROFILE in BnNodeSpecific.h.
+// Each stage of the loop is wrapped in BN_PROFILE_BEGIN(stage) and BN_PROFILE_END(stage), where
+// stage is the name after BN_PROFILE_STAGE_. The durations in microseconds are kept per stage,
+// count/avg/min/max over the report window and p99 over the last BN_PROFILE_RING_SIZE samples.
+// Every BN_PROFILE_REPORT_INTERVAL_MS the stats are printed with DEBUG_PRINT and sent to the
+// host as a "stats" message, on BLE on the stats characteristic of BnBLENodeCommunicator.h,
+// then the window starts over.
+// Stages can be nested, e.g. FUSION is part of SENSORS which is part of LOOP.
+// Without BN_PROFILE the macros are empty and nothing is compiled in.
+
+#define BN_PROFILE_STAGE_LOOP              0
+#define BN_PROFILE_STAGE_COMMUNICATOR      1
+#define BN_PROFILE_STAGE_SENSORS           2
+#define BN_PROFILE_STAGE_ISENSOR_READ      3
+#define BN_PROFILE_STAGE_FUSION            4
+#define BN_PROFILE_STAGE_ADD_MESSAGE       5
+#define BN_PROFILE_STAGE_SEND              6
+#define BN_PROFILE_STAGE_ACTIONS           7
+#define BN_PROFILE_NUM_STAGES              8
+
+#ifndef BN_PROFILE_RING_SIZE
+#define BN_PROFILE_RING_SIZE 100
+#endif
+
+#ifndef BN_PROFILE_REPORT_INTERVAL_MS
+#define BN_PROFILE_REPORT_INTERVAL_MS 5000
+#endif
+
+// Room for the "stats" message with all the stages
+#define BN_PROFILE_MESSAGE_BYTES 1024
+
+#ifdef BN_PROFILE
+
+#define BN_PROFILE_BEGIN(stage) uint32_t bn_profile_##stage##_start_us = micros()
+#define BN_PROFILE_END(stage) BnProfiler::record(BN_PROFILE_STAGE_##stage, micros() - bn_profile_##stage##_start_us)
+
+struct BnProfileStageStats {
+    uint32_t count;
+    uint32_t total_us;
+    uint32_t min_us;
+    uint32_t max_us;
+    // Durations saturate at 65535 us, enough to tell that a stage is too slow
+    uint16_t ring_us[BN_PROFILE_RING_SIZE];
+    uint16_t ring_next;
+    uint16_t ring_len;
+};
+
+class BnProfiler {
+public:
+    static void record(uint8_t stage, uint32_t elapsed_us);
+    // True once every BN_PROFILE_REPORT_INTERVAL_MS
+    static bool isReportTime();
+    static void printReport();
+    static void toJsonMessage(JsonObject &message, const String &player, const String &bodypart);
+    // Starts a new report window
+    static void reset();
+
+private:
+    static uint32_t percentile99(uint8_t stage);
+
+    static BnProfileStageStats sStages[BN_PROFILE_NUM_STAGES];
+    static uint32_t sWindowStart_ms;
+};
+
+#else
+
+#define BN_PROFILE_BEGIN(stage)
+#define BN_PROFILE_END(stage)
+
+#endif // BN_PROFILE
+
+#endif // __BN_PROFILER_H
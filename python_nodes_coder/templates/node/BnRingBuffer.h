@@ -0,0 +1,85 @@
+/**
+* MIT License
+* 
+* Copyright (c) 2026 Manuel Bottini
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include <stdint.h>
+
+#ifndef __BN_RING_BUFFER_H
+#define __BN_RING_BUFFER_H
+
+// Fixed size FIFO for a single producer and a single consumer, i.e. an interrupt that pushes
+// and the loop that pops. No locks are needed: only the producer moves the head and only the
+// consumer moves the tail, and each one publishes its index after the value is in place.
+// It holds SIZE - 1 values, pushing on a full buffer drops the new value.
+template<typename T, uint16_t SIZE>
+class BnRingBuffer {
+public:
+    BnRingBuffer() : m_head(0), m_tail(0) {}
+
+    // Producer side
+    bool push(const T &value) {
+        const uint16_t head = m_head;
+        const uint16_t next = (head + 1) % SIZE;
+        if(next == m_tail) {
+            return false;
+        }
+        m_values[head] = value;
+        __sync_synchronize();
+        m_head = next;
+        return true;
+    }
+
+    // Consumer side
+    bool pop(T &value) {
+        const uint16_t tail = m_tail;
+        if(tail == m_head) {
+            return false;
+        }
+        value = m_values[tail];
+        __sync_synchronize();
+        m_tail = (tail + 1) % SIZE;
+        return true;
+    }
+
+    // Consumer side, drops all the values
+    void clear() {
+        m_tail = m_head;
+    }
+
+    bool isEmpty() const {
+        return m_head == m_tail;
+    }
+
+    uint16_t size() const {
+        return (m_head + SIZE - m_tail) % SIZE;
+    }
+
+    static constexpr uint16_t capacity() { return SIZE - 1; }
+
+private:
+    T m_values[SIZE];
+    volatile uint16_t m_head;
+    volatile uint16_t m_tail;
+};
+
+#endif // __BN_RING_BUFFER_H
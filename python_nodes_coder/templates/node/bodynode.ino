@@ -25,6 +25,8 @@
 #include "BnNodeSpecific.h"
 #include "BnArduinoUtils.h"
 #include "BnDatatypes.h"
+#include "BnProfiler.h"
+#include "BnChangeDetector.h"
 
 #if defined(BN_NODE_SPECIFIC_MAIN_FILE_INIT)
 BN_NODE_SPECIFIC_MAIN_FILE_INIT
@@ -46,49 +48,48 @@ BnBLENodeCommunicator mCommunicator;
 BnBluetoothNodeCommunicator mCommunicator;
 #endif // BLUETOOTH_COMMUNICATION
 
+#include "BnISensorHub.h"
+#ifdef __BN_ISENSOR_HUB_H__
+BnISensorHub mISensorHub;
+#endif // __BN_ISENSOR_HUB_H__
+
 #ifdef ORIENTATION_ABS_SENSOR
 #include "BnOrientationAbsSensor.h"
 BnOrientationAbsSensor mOASensor;
-float mLastSensorData_OA[4] = {0 ,0 ,0 ,0};
-float mBigDiff_OA[4] = {BIG_QUAT_DIFF ,BIG_QUAT_DIFF ,BIG_QUAT_DIFF ,BIG_QUAT_DIFF};
+BnChangeDetector mChanges_OA;
 #endif // ORIENTATION_ABS_SENSOR
 
 #ifdef ACCELERATION_REL_SENSOR
 #include "BnAccelerationRelSensor.h"
 BnAccelerationRelSensor mARSensor;
-float mLastSensorData_AR[3] = {0 ,0 ,0};
-float mBigDiff_AR[3] = {BIG_QUAT_DIFF ,BIG_QUAT_DIFF ,BIG_QUAT_DIFF};
+BnChangeDetector mChanges_AR;
 #endif // ACCELERATION_REL_SENSOR
 
 #ifdef ANGULARVELOCITY_REL_SENSOR
 #include "BnAngularVelocityRelSensor.h"
 BnAngularVelocityRelSensor mAVRSensor;
-float mLastSensorData_AVR[3] = {0 ,0 ,0};
-float mBigDiff_AVR[3] = {BIG_QUAT_DIFF ,BIG_QUAT_DIFF ,BIG_QUAT_DIFF};
+BnChangeDetector mChanges_AVR;
 #endif // ANGULARVELOCITY_REL_SENSOR
 
 #ifdef GLOVE_SENSOR_ON_SERIAL
 #include "BnGloveSensorReaderSerial.h"
 String mBodypartGloveName;
 BnGloveSensorReaderSerial mGloveSensor;
-int mLastSensorData_G[9] = {0 ,0 ,0 ,0, 0, 0 ,0 ,0 ,0};
-int mBigDiff_G[9] = {BIG_ANGLE_DIFF ,BIG_ANGLE_DIFF ,BIG_ANGLE_DIFF ,BIG_ANGLE_DIFF, BIG_ANGLE_DIFF, 0, 0, 0, 0};
+BnChangeDetector mChanges_G;
 #endif // GLOVE_SENSOR_ON_SERIAL
 
 #ifdef GLOVE_SENSOR_ON_BOARD
 #include "BnGloveSensor.h"
 String mBodypartGloveName;
 BnGloveSensor mGloveSensor;
-int mLastSensorData_G[9] = {0 ,0 ,0 ,0, 0, 0 ,0 ,0 ,0};
-int mBigDiff_G[9] = {BIG_ANGLE_DIFF ,BIG_ANGLE_DIFF ,BIG_ANGLE_DIFF ,BIG_ANGLE_DIFF, BIG_ANGLE_DIFF, 0, 0, 0, 0};
+BnChangeDetector mChanges_G;
 #endif // GLOVE_SENSOR_ON_BOARD
 
 #ifdef SHOE_SENSOR_ON_BOARD
 #include "BnShoeSensor.h"
 String mBodypartShoeName;
 BnShoeSensor mShoeSensor;
-int mLastSensorData_S[1] = {0};
-int mBigDiff_S[1] = {0};
+BnChangeDetector mChanges_S;
 #endif // SHOE_SENSOR_ON_BOARD
 
 #ifdef HAPTIC_ACTUATOR_ON_BOARD
@@ -101,32 +102,6 @@ String mPlayerName;
 String mBodypartName;
 
 
-template<typename T>
-bool bigChanges(T values[], T prev_values[], uint8_t num_values, T big_difference[]) {
-    bool somethingChanged=false;
-
-    bool prev_allzeros = true;
-    for(uint8_t index = 0; index<num_values;++index){
-        if( prev_values[index] != 0 ){
-            prev_allzeros = false;
-            break;
-        }
-    }
-    if(prev_allzeros){
-        // There is not prev data yet
-        return true;
-    }
-    
-    for(uint8_t index = 0; index<num_values;++index){
-        if( values[index] < prev_values[index]-big_difference[index] || prev_values[index]+big_difference[index] < values[index] ){
-            somethingChanged=true;
-            break;
-        }
-    }
-
-    return somethingChanged;
-}
-
 void setup() {
     //Initialize the serial and wait for the port to open
     Serial.begin(921600);
@@ -139,200 +114,268 @@ void setup() {
 
 #ifdef ORIENTATION_ABS_SENSOR
     mOASensor.init();
+    mChanges_OA.setPolicy(BN_CHANGE_POLICY_QUATERNION_ANGLE, BIG_QUAT_ANGLE);
 #endif // ORIENTATION_ABS_SENSOR
 #ifdef ACCELERATION_REL_SENSOR
     mARSensor.init();
+    mChanges_AR.setPolicy(BN_CHANGE_POLICY_VECTOR_NORM, BIG_QUAT_DIFF);
 #endif // ACCELERATION_REL_SENSOR
 #ifdef ANGULARVELOCITY_REL_SENSOR
     mAVRSensor.init();
+    mChanges_AVR.setPolicy(BN_CHANGE_POLICY_VECTOR_NORM, BIG_QUAT_DIFF);
 #endif // ANGULARVELOCITY_REL_SENSOR
 
     mCommunicator.init();
 
 #if defined(GLOVE_SENSOR_ON_SERIAL) || defined(GLOVE_SENSOR_ON_BOARD)
     mGloveSensor.init();
-    mBodypartGloveName = BnPersMemory::getValue(BN_MEMORY_BODYPART_GLOVE_TAG);
+    // The 5 finger angles, then the touch values that are sent at every change
+    mChanges_G.setPolicy(BN_CHANGE_POLICY_COMPONENT, BIG_ANGLE_DIFF);
+    for(uint8_t index = 5; index < 9; ++index){
+        mChanges_G.setComponentThreshold(index, 0);
+    }
+    mBodypartGloveName = BnPersMemory::getValue(BN_MEMORY_KEY_BODYPART_GLOVE);
 #endif /*GLOVE_SENSOR_ON_SERIAL || GLOVE_SENSOR_ON_BOARD*/
 
 #ifdef SHOE_SENSOR_ON_BOARD
     mShoeSensor.init();
-    mBodypartShoeName = BnPersMemory::getValue(BN_MEMORY_BODYPART_SHOE_TAG);
+    mChanges_S.setPolicy(BN_CHANGE_POLICY_COMPONENT, 0);
+    mBodypartShoeName = BnPersMemory::getValue(BN_MEMORY_KEY_BODYPART_SHOE);
 #endif /*SHOE_SENSOR_ON_BOARD*/
 
-    mPlayerName = BnPersMemory::getValue(BN_MEMORY_PLAYER_TAG);
-    mBodypartName = BnPersMemory::getValue(BN_MEMORY_BODYPART_TAG);
+    mPlayerName = BnPersMemory::getValue(BN_MEMORY_KEY_PLAYER);
+    mBodypartName = BnPersMemory::getValue(BN_MEMORY_KEY_BODYPART);
 }
 
 void loop() {
-
-    if(mCommunicator.checkAllOk()){
+    BN_PROFILE_BEGIN(LOOP);
+
+    BN_PROFILE_BEGIN(COMMUNICATOR);
+    bool connected = mCommunicator.checkAllOk();
+    BN_PROFILE_END(COMMUNICATOR);
+
+    // The sensors keep running while the node is not connected, the WiFi communicator keeps their readings
+    BN_PROFILE_BEGIN(SENSORS);
+#ifdef __BN_ISENSOR_HUB_H__
+    // One read of the isensor shared by the esensors below
+    mISensorHub.tick();
+#endif // __BN_ISENSOR_HUB_H__
 #ifdef ORIENTATION_ABS_SENSOR
-        if(!mOASensor.isCalibrated()){
-            // You can decide to return
-        }
-
-        if(mOASensor.isEnabled() && mOASensor.checkAllOk()) {
-            float values[4] = {0, 0, 0, 0};
-            mOASensor.getData().getValues(values);
-            if(bigChanges(values, mLastSensorData_OA, 4, mBigDiff_OA)) {
-                StaticJsonDocument<MAX_MESSAGE_BYTES> message_doc;
-                JsonObject message = message_doc.to<JsonObject>();;
-                message["player"] = mPlayerName;
-                message["bodypart"] = mBodypartName;
-                message["sensortype"] = mOASensor.getType();
-                for(uint8_t count=0; count<4;++count){
-                    message["value"].add(values[count]);
-                    mLastSensorData_OA[count] = values[count];
-                }
+    if(!mOASensor.isCalibrated()){
+        // You can decide to return
+    }
 
-                //DEBUG_PRINT("message = ");
-                //String output;
-                //serializeJson(message, output);
-                //DEBUG_PRINTLN(output);
-                mCommunicator.addMessage(message);
-            }
+    if(mOASensor.isEnabled() && mOASensor.checkAllOk()) {
+        BnSensorData sensorData = mOASensor.getData();
+        float values[4] = {0, 0, 0, 0};
+        sensorData.getValues(values);
+        if(mChanges_OA.hasChanged(values, 4, millis())) {
+            BN_PROFILE_BEGIN(ADD_MESSAGE);
+            mCommunicator.addMessage(mPlayerName, mBodypartName, sensorData);
+            BN_PROFILE_END(ADD_MESSAGE);
         }
+    }
 #endif // ORIENTATION_ABS_SENSOR
 
 #ifdef ACCELERATION_REL_SENSOR
-        if(!mARSensor.isCalibrated()){
-            // You can decide to return
-        }
-
-        if(mARSensor.isEnabled() && mARSensor.checkAllOk()) {
-            float values[3] = {0, 0, 0};
-            mARSensor.getData().getValues(values);
-            if(bigChanges(values, mLastSensorData_AR, 3, mBigDiff_AR)) {
-                StaticJsonDocument<MAX_MESSAGE_BYTES> message_doc;
-                JsonObject message = message_doc.to<JsonObject>();;
-                message["player"] = mPlayerName;
-                message["bodypart"] = mBodypartName;
-                message["sensortype"] = mARSensor.getType();
-                for(uint8_t count=0; count<4;++count){
-                    message["value"].add(values[count]);
-                    mLastSensorData_AR[count] = values[count];
-                }
+    if(!mARSensor.isCalibrated()){
+        // You can decide to return
+    }
 
-                mCommunicator.addMessage(message);
-            }
+    if(mARSensor.isEnabled() && mARSensor.checkAllOk()) {
+        BnSensorData sensorData = mARSensor.getData();
+        float values[3] = {0, 0, 0};
+        sensorData.getValues(values);
+        if(mChanges_AR.hasChanged(values, 3, millis())) {
+            BN_PROFILE_BEGIN(ADD_MESSAGE);
+            mCommunicator.addMessage(mPlayerName, mBodypartName, sensorData);
+            BN_PROFILE_END(ADD_MESSAGE);
         }
+    }
 #endif // ACCELERATION_REL_SENSOR
 
 #ifdef ANGULARVELOCITY_REL_SENSOR
-        if(!mAVRSensor.isCalibrated()){
-            // You can decide to return
-        }
-
-        if(mAVRSensor.isEnabled() && mAVRSensor.checkAllOk()) {
-            float values[3] = {0, 0, 0};
-            mAVRSensor.getData().getValues(values);
-            if(bigChanges(values, mLastSensorData_AVR, 3, mBigDiff_AVR)) {
-                StaticJsonDocument<MAX_MESSAGE_BYTES> message_doc;
-                JsonObject message = message_doc.to<JsonObject>();;
-                message["player"] = mPlayerName;
-                message["bodypart"] = mBodypartName;
-                message["sensortype"] = mAVRSensor.getType();
-                for(uint8_t count=0; count<4;++count){
-                    message["value"].add(values[count]);
-                    mLastSensorData_AVR[count] = values[count];
-                }
+    if(!mAVRSensor.isCalibrated()){
+        // You can decide to return
+    }
 
-                mCommunicator.addMessage(message);
-            }
+    if(mAVRSensor.isEnabled() && mAVRSensor.checkAllOk()) {
+        BnSensorData sensorData = mAVRSensor.getData();
+        float values[3] = {0, 0, 0};
+        sensorData.getValues(values);
+        if(mChanges_AVR.hasChanged(values, 3, millis())) {
+            BN_PROFILE_BEGIN(ADD_MESSAGE);
+            mCommunicator.addMessage(mPlayerName, mBodypartName, sensorData);
+            BN_PROFILE_END(ADD_MESSAGE);
         }
+    }
 #endif // ANGULARVELOCITY_REL_SENSOR
 
 #if defined(GLOVE_SENSOR_ON_SERIAL) || defined(GLOVE_SENSOR_ON_BOARD)
-        if(mGloveSensor.isEnabled() && mGloveSensor.checkAllOk()) {
-            int values[9] = {0, 0, 0, 0, 0, 0, 0, 0, 0};
-            mGloveSensor.getData(values);
-            if(bigChanges(values, mLastSensorData_G, 9, mBigDiff_G)) {
-                StaticJsonDocument<MAX_MESSAGE_BYTES> message_doc;
-                JsonObject message = message_doc.to<JsonObject>();;
-                message["player"] = mPlayerName;
-                message["bodypart"] = mBodypartGloveName;
-                message["sensortype"] = mGloveSensor.getType();
-                for(uint8_t count=0; count<9;++count){
-                    message["value"].add(values[count]);
-                    mLastSensorData_G[count] = values[count];
-                }
-                mCommunicator.addMessage(message);
-            }
+    if(mGloveSensor.isEnabled() && mGloveSensor.checkAllOk()) {
+        int values[9] = {0, 0, 0, 0, 0, 0, 0, 0, 0};
+        mGloveSensor.getData(values);
+        if(mChanges_G.hasChanged(values, 9, millis())) {
+            BnSensorData sensorData;
+            sensorData.setValues(values, mGloveSensor.getType());
+            BN_PROFILE_BEGIN(ADD_MESSAGE);
+            mCommunicator.addMessage(mPlayerName, mBodypartGloveName, sensorData);
+            BN_PROFILE_END(ADD_MESSAGE);
         }
+    }
 #endif /*GLOVE_SENSOR_ON_SERIAL || GLOVE_SENSOR_ON_BOARD */
 
 #ifdef SHOE_SENSOR_ON_BOARD
-        if(mShoeSensor.isEnabled() && mShoeSensor.checkAllOk()) {
-            int values[1] = {0};
-            mShoeSensor.getData(values);
-            if(bigChanges(values, mLastSensorData_S, 1, mBigDiff_S)) {
-                StaticJsonDocument<MAX_MESSAGE_BYTES> message_doc;
-                JsonObject message = message_doc.to<JsonObject>();
-                message["player"] = mPlayerName;
-                message["bodypart"] = mBodypartShoeName;
-                message["sensortype"] = mShoeSensor.getType();
-                message["value"] = values[0];
-                mLastSensorData_S[0] = values[0];
-                mCommunicator.addMessage(message);
-            }
+    if(mShoeSensor.isEnabled() && mShoeSensor.checkAllOk()) {
+        int values[1] = {0};
+        mShoeSensor.getData(values);
+        if(mChanges_S.hasChanged(values, 1, millis())) {
+            BnSensorData sensorData;
+            sensorData.setValues(values, mShoeSensor.getType());
+            BN_PROFILE_BEGIN(ADD_MESSAGE);
+            mCommunicator.addMessage(mPlayerName, mBodypartShoeName, sensorData);
+            BN_PROFILE_END(ADD_MESSAGE);
         }
+    }
 #endif /*SHOE_SENSOR_ON_BOARD*/
+    BN_PROFILE_END(SENSORS);
+
+    if(connected){
+#ifdef BN_PROFILE
+        if(BnProfiler::isReportTime()) {
+            BnProfiler::printReport();
+            StaticJsonDocument<BN_PROFILE_MESSAGE_BYTES> stats_doc;
+            JsonObject stats = stats_doc.to<JsonObject>();
+            BnProfiler::toJsonMessage(stats, mPlayerName, mBodypartName);
+            mCommunicator.addMessage(stats);
+            BnProfiler::reset();
+        }
+#endif // BN_PROFILE
 
+        BN_PROFILE_BEGIN(SEND);
         mCommunicator.sendAllMessages();
+        BN_PROFILE_END(SEND);
 
+        BN_PROFILE_BEGIN(ACTIONS);
         StaticJsonDocument<MAX_ACTION_BYTES> actions_doc;
         JsonArray actions = actions_doc.to<JsonArray>();
         mCommunicator.getActions(actions);
 
         for (JsonObject action : actions) {
-            String actionPlayer = action[BN_ACTION_PLAYER_TAG].as<String>();
-            String actionBodypart = action[BN_ACTION_BODYPART_TAG].as<String>();
-            if(actionPlayer != mPlayerName) {
+            // The tags are compared in place and mapped to ids, no String is built for the dispatch
+            if(mPlayerName != action[BN_ACTION_PLAYER_TAG].as<const char*>()) {
                 DEBUG_PRINTLN("Wrong player in the action");
                 continue;
             }
-            if(actionBodypart != mBodypartName) {
+            if(mBodypartName != action[BN_ACTION_BODYPART_TAG].as<const char*>()) {
                 DEBUG_PRINTLN("Wrong bodypart in the action");
                 continue;
             }
-            String actionType = action[BN_ACTION_TYPE_TAG].as<String>();
-            if(actionType == BN_ACTION_TYPE_HAPTIC_TAG) {
+            switch(BnActionType_fromTag(action[BN_ACTION_TYPE_TAG].as<const char*>())) {
+            case BN_ACTION_TYPE_HAPTIC:
 #ifdef HAPTIC_ACTUATOR_ON_BOARD
                 mHapticActuator.setAction(action);
 #endif // HAPTIC_ACTUATOR_ON_BOARD
-            } else if(actionType == BN_ACTION_TYPE_ENABLESENSOR_TAG) {
-                String actionSensorType = action[BN_ACTION_ENABLESENSOR_SENSORTYPE_TAG].as<String>();
-                if(actionSensorType == BN_SENSORTYPE_ORIENTATION_ABS_TAG) {
+                break;
+            case BN_ACTION_TYPE_ENABLESENSOR:
+                switch(BnSensorType_fromTag(action[BN_ACTION_ENABLESENSOR_SENSORTYPE_TAG].as<const char*>())) {
+                case BN_SENSORTYPE_ORIENTATION_ABS:
                     //DEBUG_PRINT("Setting enabled = ");
                     //DEBUG_PRINTLN(action[BN_ACTION_ENABLESENSOR_ENABLE_TAG].as<bool>());
 #ifdef ORIENTATION_ABS_SENSOR
                     mOASensor.setEnable(action[BN_ACTION_ENABLESENSOR_ENABLE_TAG].as<bool>());
 #endif /*ORIENTATION_ABS_SENSOR*/
-                } else if(actionSensorType == BN_SENSORTYPE_GLOVE_TAG) {
+                    break;
+                case BN_SENSORTYPE_ACCELERATION_REL:
+#ifdef ACCELERATION_REL_SENSOR
+                    mARSensor.setEnable(action[BN_ACTION_ENABLESENSOR_ENABLE_TAG].as<bool>());
+#endif /*ACCELERATION_REL_SENSOR*/
+                    break;
+                case BN_SENSORTYPE_ANGULARVELOCITY_REL:
+#ifdef ANGULARVELOCITY_REL_SENSOR
+                    mAVRSensor.setEnable(action[BN_ACTION_ENABLESENSOR_ENABLE_TAG].as<bool>());
+#endif /*ANGULARVELOCITY_REL_SENSOR*/
+                    break;
+                case BN_SENSORTYPE_GLOVE:
 #if defined(GLOVE_SENSOR_ON_SERIAL) || defined(GLOVE_SENSOR_ON_BOARD) 
                     mGloveSensor.setEnable(action[BN_ACTION_ENABLESENSOR_ENABLE_TAG].as<bool>());
 #endif /*GLOVE_SENSOR_ON_SERIAL || GLOVE_SENSOR_ON_BOARD */
-                } else if(actionSensorType == BN_SENSORTYPE_SHOE_TAG) {
+                    break;
+                case BN_SENSORTYPE_SHOE:
 #ifdef SHOE_SENSOR_ON_BOARD
                     mShoeSensor.setEnable(action[BN_ACTION_ENABLESENSOR_ENABLE_TAG].as<bool>());
 #endif /*SHOE_SENSOR_ON_BOARD*/
+                    break;
+                default:
+                    break;
+                }
+                break;
+            case BN_ACTION_TYPE_SETCHANGEPOLICY:
+                switch(BnSensorType_fromTag(action[BN_ACTION_SETCHANGEPOLICY_SENSORTYPE_TAG].as<const char*>())) {
+                case BN_SENSORTYPE_ORIENTATION_ABS:
+#ifdef ORIENTATION_ABS_SENSOR
+                    mChanges_OA.setAction(action);
+#endif /*ORIENTATION_ABS_SENSOR*/
+                    break;
+                case BN_SENSORTYPE_ACCELERATION_REL:
+#ifdef ACCELERATION_REL_SENSOR
+                    mChanges_AR.setAction(action);
+#endif /*ACCELERATION_REL_SENSOR*/
+                    break;
+                case BN_SENSORTYPE_ANGULARVELOCITY_REL:
+#ifdef ANGULARVELOCITY_REL_SENSOR
+                    mChanges_AVR.setAction(action);
+#endif /*ANGULARVELOCITY_REL_SENSOR*/
+                    break;
+                case BN_SENSORTYPE_GLOVE:
+#if defined(GLOVE_SENSOR_ON_SERIAL) || defined(GLOVE_SENSOR_ON_BOARD)
+                    mChanges_G.setAction(action);
+#endif /*GLOVE_SENSOR_ON_SERIAL || GLOVE_SENSOR_ON_BOARD */
+                    break;
+                case BN_SENSORTYPE_SHOE:
+#ifdef SHOE_SENSOR_ON_BOARD
+                    mChanges_S.setAction(action);
+#endif /*SHOE_SENSOR_ON_BOARD*/
+                    break;
+                default:
+                    break;
                 }
-            } else if(actionType == BN_ACTION_TYPE_SETPLAYER_TAG) {
+                break;
+            case BN_ACTION_TYPE_SETPLAYER:
                 mPlayerName = action[BN_ACTION_SETPLAYER_NEWPLAYER_TAG].as<String>();
-                BnPersMemory::setValue(BN_MEMORY_PLAYER_TAG, mPlayerName);
-            } else if(actionType == BN_ACTION_TYPE_SETBODYPART_TAG) {
+                BnPersMemory::setValue(BN_MEMORY_KEY_PLAYER, mPlayerName);
+                break;
+            case BN_ACTION_TYPE_SETBODYPART:
                 mBodypartName = action[BN_ACTION_SETBODYPART_NEWBODYPART_TAG].as<String>();
-                BnPersMemory::setValue(BN_MEMORY_BODYPART_TAG, mBodypartName);
-            } else if(actionType == BN_ACTION_TYPE_SETWIFI_TAG) {
+                BnPersMemory::setValue(BN_MEMORY_KEY_BODYPART, mBodypartName);
+                break;
+            case BN_ACTION_TYPE_SETWIFI:
 #ifdef WIFI_COMMUNICATION
                 mCommunicator.setConnectionParams(action);
                 mCommunicator.init();
 #endif // WIFI_COMMUNICATION
+                break;
+            case BN_ACTION_TYPE_SETBATCHING:
+#ifdef WIFI_COMMUNICATION
+                mCommunicator.setBatching(action[BN_ACTION_SETBATCHING_BATCH_SIZE_TAG].as<uint16_t>(),
+                    action[BN_ACTION_SETBATCHING_FLUSH_MS_TAG].as<uint16_t>());
+#endif // WIFI_COMMUNICATION
+                break;
+            case BN_ACTION_TYPE_CALIBRATEMAGN:
+#ifdef ORIENTATION_ABS_SENSOR
+                mOASensor.calibrateMagn(action[BN_ACTION_CALIBRATEMAGN_DURATION_MS_TAG].as<uint32_t>());
+#endif /*ORIENTATION_ABS_SENSOR*/
+                break;
+            default:
+                break;
             }
         }
+        BN_PROFILE_END(ACTIONS);
     }
 
 #ifdef HAPTIC_ACTUATOR_ON_BOARD
     mHapticActuator.performAction();
 #endif // HAPTIC_ACTUATOR_ON_BOARD
+
+    BN_PROFILE_END(LOOP);
 }
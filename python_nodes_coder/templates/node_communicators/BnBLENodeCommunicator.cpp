@@ -23,9 +23,42 @@
 */
 
 #include "BnBLENodeCommunicator.h"
+#include "BnChangeDetector.h"
 
 #ifdef BLE_COMMUNICATION
 
+// Filled by the BLE stack, emptied by getActions()
+static BnRingBuffer<BnBLEControlWrite, BN_BLE_CONTROL_QUEUE_LENGTH + 1> sControlWrites;
+
+static uint16_t readUInt16(const uint8_t buffer[]){
+    return static_cast<uint16_t>(buffer[0]) | (static_cast<uint16_t>(buffer[1]) << 8);
+}
+
+static uint32_t readUInt32(const uint8_t buffer[]){
+    return static_cast<uint32_t>(buffer[0]) | (static_cast<uint32_t>(buffer[1]) << 8) |
+        (static_cast<uint32_t>(buffer[2]) << 16) | (static_cast<uint32_t>(buffer[3]) << 24);
+}
+
+static float readFloat(const uint8_t buffer[]){
+    const uint32_t bits = readUInt32(buffer);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+void BnBLENodeCommunicator_onControlWrite(const uint8_t bytes[], uint16_t length){
+    if(length == 0 || length > BN_BLE_CONTROL_MAX_BYTES){
+        DEBUG_PRINTLN("Control write dropped, wrong length");
+        return;
+    }
+    BnBLEControlWrite write;
+    write.length = length;
+    memcpy(write.bytes, bytes, length);
+    if(!sControlWrites.push(write)){
+        DEBUG_PRINTLN("Control write dropped, queue full");
+    }
+}
+
 void BnBLENodeCommunicator::init(){
     bnc_status_LED.on = false;
     bnc_status_LED.lastToggle = millis();
@@ -33,7 +66,10 @@ void BnBLENodeCommunicator::init(){
     bnc_connection_data.setDisconnected();
     bnc_connection_data.last_sent_time = 0;
 
-    bnc_messages_list = bnc_messages_doc.to<JsonArray>();
+    bnc_num_records = 0;
+    bnc_names_set = false;
+    bnc_stream_length = 0;
+    sControlWrites.clear();
 
     BN_NODE_SPECIFIC_BN_BLE_NODE_COMMUNICATOR_HMI_SETUP;
     BN_NODE_SPECIFIC_BN_BLE_NODE_COMMUNICATOR_HMI_LED_OFF;
@@ -43,6 +79,10 @@ void BnBLENodeCommunicator::init(){
 bool BnBLENodeCommunicator::checkAllOk(){
     checkStatus();
     bnc_connection_data.conn_status = BnBLENodeCommunicator_checkAllOk(bnc_connection_data.conn_status);
+    if(!bnc_connection_data.isConnected()){
+        // The readings waiting for the stream are not kept, like the other ones
+        bnc_stream_length = 0;
+    }
     if(bnc_connection_data.isWaitingACK()){
         return false;
     } else if(bnc_connection_data.isConnected()){
@@ -53,26 +93,240 @@ bool BnBLENodeCommunicator::checkAllOk(){
 }
 
 void BnBLENodeCommunicator::sendAllMessages(){
-    BnBLENodeCommunicator_sendAllMessages(bnc_messages_list);
+    for(uint8_t index = 0; index < bnc_num_records; ++index){
+        BnBLENodeCommunicator_sendRecord(bnc_records[index].type, bnc_records[index].bytes, bnc_records[index].length);
+    }
+    bnc_num_records = 0;
+    if(bnc_stream_length > 0 && millis() - bnc_stream_first_ms >= BN_BLE_STREAM_FLUSH_MS){
+        sendStream();
+    }
     bnc_connection_data.last_sent_time = millis();
-    bnc_messages_doc.garbageCollect();
 }
 
 void BnBLENodeCommunicator::addMessage(JsonObject &message){
-  if(bnc_messages_list.size() >= MAX_MESSAGES_LIST_LENGTH){
+  const uint16_t capacity = BnBLENodeCommunicator_statsCapacity();
+  if(!bnc_connection_data.isConnected() || capacity == 0){
+    // No central to read them
+    return;
+  }
+  char text[BN_BLE_STATS_MAX_BYTES];
+  if(measureJson(message) >= sizeof(text)){
+    DEBUG_PRINTLN("Message too long for the stats characteristic");
+    return;
+  }
+  uint16_t length = serializeJson(message, text, sizeof(text));
+  text[length++] = '\n';
+  for(uint16_t offset = 0; offset < length; offset += capacity){
+    const uint16_t chunk = length - offset < capacity ? length - offset : capacity;
+    BnBLENodeCommunicator_sendStats(reinterpret_cast<const uint8_t*>(&text[offset]), chunk);
+  }
+}
+
+void BnBLENodeCommunicator::addMessage(const String &player, const String &bodypart, BnSensorData &sensorData){
+  if(!bnc_connection_data.isConnected()){
+    // The readings taken while not connected are not kept
+    return;
+  }
+  if(!bnc_names_set && isNodeBodypart(sensorData)) {
+    // Afterwards they change only with the set_player and set_bodypart actions
+    setNames(player, bodypart);
+    bnc_names_set = true;
+  }
+  uint16_t stream_capacity = BnBLENodeCommunicator_streamCapacity();
+  if(stream_capacity > BN_BLE_STREAM_MAX_BYTES){
+    stream_capacity = BN_BLE_STREAM_MAX_BYTES;
+  }
+  if(stream_capacity >= BN_BLE_STREAM_MIN_BYTES){
+    addStreamRecord(sensorData, stream_capacity);
+    return;
+  }
+  if(bnc_num_records >= MAX_MESSAGES_LIST_LENGTH){
     DEBUG_PRINTLN("Too many messages in list");
     return;
   }
-  bnc_messages_list.add(message);
+  if(writeRecord(sensorData, bnc_records[bnc_num_records]) > 0){
+    ++bnc_num_records;
+  }
+}
 
-  if(bnc_messages_list.size() == 0) {
-      DEBUG_PRINTLN("No messages to added HERE");
-      return;
+uint8_t BnBLENodeCommunicator::writeRecord(BnSensorData &sensorData, BnBLERecord &record){
+  record.type = BnBinaryMessages::recordType(sensorData.getType());
+  record.length = 0;
+  const uint8_t num_values = sensorData.getNumValues();
+  if(record.type == BN_BINARY_RECORD_GLOVE || record.type == BN_BINARY_RECORD_SHOE) {
+    int values[9];
+    sensorData.getValues(values);
+    for(uint8_t index = 0; index < num_values; ++index){
+      record.bytes[index] = static_cast<uint8_t>(constrain(values[index], 0, 255));
+    }
+    record.length = num_values;
+  } else if(record.type != BN_BINARY_RECORD_NONE) {
+    float values[4];
+    sensorData.getValues(values);
+    for(uint8_t index = 0; index < num_values; ++index){
+      // BIG ENDIAN CONVERSION
+      uint32_t bits;
+      memcpy(&bits, &values[index], sizeof(bits));
+      record.bytes[4 * index + 0] = (bits >> 24) & 0xFF;
+      record.bytes[4 * index + 1] = (bits >> 16) & 0xFF;
+      record.bytes[4 * index + 2] = (bits >> 8) & 0xFF;
+      record.bytes[4 * index + 3] = bits & 0xFF;
+    }
+    record.length = 4 * num_values;
   }
+  return record.length;
+}
 
+void BnBLENodeCommunicator::addStreamRecord(BnSensorData &sensorData, uint16_t capacity){
+  uint8_t record[BN_BINARY_MAX_RECORD_BYTES];
+  const uint16_t record_length = BnBinaryMessages::writeRecord(record, sizeof(record), sensorData);
+  if(record_length == 0){
+    return;
+  }
+  if(bnc_stream_length > 0 && bnc_stream_length + BN_BINARY_TIMESTAMP_BYTES + record_length > capacity){
+    sendStream();
+  }
+  if(bnc_stream_length == 0){
+    // The header is written when the notification is sent
+    bnc_stream_length = BN_BINARY_HEADER_BYTES;
+    bnc_stream_first_ms = millis();
+  }
+  bnc_stream_length += BnBinaryMessages::writeTimestamp(&bnc_stream_packet[bnc_stream_length], capacity - bnc_stream_length, micros());
+  memcpy(&bnc_stream_packet[bnc_stream_length], record, record_length);
+  bnc_stream_length += record_length;
+}
+
+void BnBLENodeCommunicator::sendStream(){
+  BnBinaryMessages::writeHeader(bnc_stream_packet, bnc_node_id, bnc_stream_seq, micros(), BN_BINARY_FLAG_TIMESTAMPED);
+  BnBLENodeCommunicator_sendStream(bnc_stream_packet, bnc_stream_length);
+  ++bnc_stream_seq;
+  bnc_stream_length = 0;
+}
+
+bool BnBLENodeCommunicator::isNodeBodypart(BnSensorData &sensorData){
+#if defined(ORIENTATION_ABS_SENSOR) || defined(ACCELERATION_REL_SENSOR) || defined(ANGULARVELOCITY_REL_SENSOR)
+  // The glove and shoe readings come with their own bodypart
+  const uint8_t type = BnBinaryMessages::recordType(sensorData.getType());
+  return type != BN_BINARY_RECORD_GLOVE && type != BN_BINARY_RECORD_SHOE;
+#else
+  return true;
+#endif
+}
+
+void BnBLENodeCommunicator::setNames(const String &player, const String &bodypart){
+  bnc_player = player;
+  bnc_bodypart = bodypart;
+  BnBLENodeCommunicator_setNames(bnc_player, bnc_bodypart);
+  bnc_node_id = BnBinaryMessages::nodeId(bnc_player, bnc_bodypart);
 }
 
 void BnBLENodeCommunicator::getActions(JsonArray &actions){
+  if(!bnc_names_set){
+    // The actions need the player and bodypart, the writes wait in the queue
+    return;
+  }
+  // One write per loop, the actions document of loop() is small
+  BnBLEControlWrite write;
+  if(!sControlWrites.pop(write)){
+    return;
+  }
+  uint16_t offset = 0;
+  BnControlFrame frame;
+  while(BnControlFrames::readFrame(&write.bytes[offset], write.length - offset, frame)){
+    offset += BN_CONTROL_HEADER_BYTES + frame.length;
+    JsonObject action = actions.createNestedObject();
+    if(action.isNull()){
+      DEBUG_PRINTLN("Too many actions in the control write");
+      return;
+    }
+    if(!toJsonAction(frame, action)){
+      actions.remove(actions.size() - 1);
+    }
+  }
+  if(offset != write.length){
+    DEBUG_PRINTLN("Control write with a broken frame");
+  }
+}
+
+bool BnBLENodeCommunicator::toJsonAction(const BnControlFrame &frame, JsonObject &action){
+  action[BN_ACTION_PLAYER_TAG] = bnc_player;
+  action[BN_ACTION_BODYPART_TAG] = bnc_bodypart;
+  const uint8_t *payload = frame.payload;
+  switch(frame.type){
+    case BN_CONTROL_TYPE_HAPTIC:
+      if(frame.length < 3){
+        break;
+      }
+      action[BN_ACTION_TYPE_TAG] = BN_ACTION_TYPE_HAPTIC_TAG;
+      action["duration_ms"] = readUInt16(&payload[0]);
+      action["strength"] = payload[2];
+      return true;
+    case BN_CONTROL_TYPE_ENABLE_SENSOR: {
+      const BnType sensortype = frame.length >= 2 ? BnBinaryMessages::recordSensortype(payload[0]) : BN_SENSORTYPE_NONE;
+      if(sensortype == BN_SENSORTYPE_NONE){
+        break;
+      }
+      action[BN_ACTION_TYPE_TAG] = BN_ACTION_TYPE_ENABLESENSOR_TAG;
+      action[BN_ACTION_ENABLESENSOR_SENSORTYPE_TAG] = BnSensorType_toTag(sensortype);
+      action[BN_ACTION_ENABLESENSOR_ENABLE_TAG] = payload[1] != 0;
+      return true;
+    }
+    case BN_CONTROL_TYPE_SET_PLAYER:
+    case BN_CONTROL_TYPE_SET_BODYPART: {
+      if(frame.length == 0 || frame.length > BN_BLE_CONTROL_MAX_BYTES - BN_CONTROL_HEADER_BYTES){
+        break;
+      }
+      char name[BN_BLE_CONTROL_MAX_BYTES];
+      memcpy(name, payload, frame.length);
+      name[frame.length] = '\0';
+      // The action carries the current names, the new ones are used from the next reading
+      if(frame.type == BN_CONTROL_TYPE_SET_PLAYER){
+        action[BN_ACTION_TYPE_TAG] = BN_ACTION_TYPE_SETPLAYER_TAG;
+        action[BN_ACTION_SETPLAYER_NEWPLAYER_TAG] = name;
+        setNames(String(name), bnc_bodypart);
+      } else {
+        action[BN_ACTION_TYPE_TAG] = BN_ACTION_TYPE_SETBODYPART_TAG;
+        action[BN_ACTION_SETBODYPART_NEWBODYPART_TAG] = name;
+        setNames(bnc_player, String(name));
+      }
+      return true;
+    }
+    case BN_CONTROL_TYPE_SET_CHANGE_POLICY: {
+      const BnType sensortype = frame.length >= 2 ? BnBinaryMessages::recordSensortype(payload[0]) : BN_SENSORTYPE_NONE;
+      if(sensortype == BN_SENSORTYPE_NONE){
+        break;
+      }
+      action[BN_ACTION_TYPE_TAG] = BN_ACTION_TYPE_SETCHANGEPOLICY_TAG;
+      action[BN_ACTION_SETCHANGEPOLICY_SENSORTYPE_TAG] = BnSensorType_toTag(sensortype);
+      if(payload[1] != BN_CONTROL_KEEP_POLICY){
+        const char *policy = BnChangeDetector::policyName(payload[1]);
+        if(policy == nullptr){
+          break;
+        }
+        action[BN_ACTION_SETCHANGEPOLICY_POLICY_TAG] = policy;
+      }
+      if(frame.length >= 6){
+        action[BN_ACTION_SETCHANGEPOLICY_THRESHOLD_TAG] = readFloat(&payload[2]);
+      }
+      if(frame.length >= 10){
+        action[BN_ACTION_SETCHANGEPOLICY_THRESHOLD_LOW_TAG] = readFloat(&payload[6]);
+      }
+      if(frame.length >= 14){
+        action[BN_ACTION_SETCHANGEPOLICY_MAX_SILENCE_MS_TAG] = readUInt32(&payload[10]);
+      }
+      return true;
+    }
+    case BN_CONTROL_TYPE_CALIBRATE_MAGN:
+      if(frame.length < 4){
+        break;
+      }
+      action[BN_ACTION_TYPE_TAG] = BN_ACTION_TYPE_CALIBRATEMAGN_TAG;
+      action[BN_ACTION_CALIBRATEMAGN_DURATION_MS_TAG] = readUInt32(&payload[0]);
+      return true;
+  }
+  DEBUG_PRINT("Unknown or short control frame, type = ");
+  DEBUG_PRINTLN(frame.type);
+  return false;
 }
 
 void BnBLENodeCommunicator::checkStatus(){
@@ -24,6 +24,9 @@
 
 #include "BnNodeSpecific.h"
 #include "BnDatatypes.h"
+#include "BnBinaryMessages.h"
+#include "BnControlFrames.h"
+#include "BnRingBuffer.h"
 
 #ifndef __BN__BLE_NODE_COMMUNICATOR_H__
 #define __BN__BLE_NODE_COMMUNICATOR_H__
@@ -31,29 +34,126 @@
 #define MAX_MESSAGES_LIST_LENGTH 20
 #define MAX_ACTIONS_LIST_LENGTH  20
 
-#define MAX_MESSAGE_BYTES 250
 #define MAX_ACTION_BYTES  250
 
 #ifdef BLE_COMMUNICATION
 
+// The node asks the central for a connection interval between these two, in units of 1.25 ms,
+// and on the boards that can negotiate them for the 2M PHY, the data length extension and
+// an ATT MTU of BN_BLE_ATT_MTU. The central has the last word on all of them.
+#ifndef BN_BLE_CONN_INTERVAL_MIN
+#define BN_BLE_CONN_INTERVAL_MIN 6  // 7.5 ms
+#endif
+#ifndef BN_BLE_CONN_INTERVAL_MAX
+#define BN_BLE_CONN_INTERVAL_MAX 12 // 15 ms
+#endif
+#ifndef BN_BLE_ATT_MTU
+#define BN_BLE_ATT_MTU 247
+#endif
+
+/*
+Stream characteristic, for the centrals that want many readings per notification.
+Its notifications are packets of the binary messages format (BnBinaryMessages.h, little endian)
+with the BN_BINARY_FLAG_TIMESTAMPED flag: every record is preceded by the device time in
+microseconds of its reading. A notification is sent when the next reading does not fit in
+the negotiated MTU or when the oldest reading waited BN_BLE_STREAM_FLUSH_MS.
+While a central is subscribed to it the readings go only to the stream, not to the
+characteristics of each sensor. The node id of the header is the one of the player and
+bodypart characteristics.
+The boards without the stream, or an MTU too small for a record, keep the sensor characteristics.
+*/
+#ifndef BN_BLE_CHARA_STREAM_UUID
+#define BN_BLE_CHARA_STREAM_UUID "0000CCA8-0000-1000-8000-00805F9B34FB"
+#endif
+#define BN_BLE_STREAM_MAX_BYTES (BN_BLE_ATT_MTU - 3)
+#define BN_BLE_STREAM_MIN_BYTES (BN_BINARY_HEADER_BYTES + BN_BINARY_TIMESTAMP_BYTES + BN_BINARY_MAX_RECORD_BYTES)
+#ifndef BN_BLE_STREAM_FLUSH_MS
+#define BN_BLE_STREAM_FLUSH_MS 25
+#endif
+
+/*
+Stats characteristic, for the JSON messages that are not readings, i.e. the "stats" of BN_PROFILE.
+Each message is its compact JSON text followed by a '\n', split over as many notifications as
+the negotiated MTU needs: the central appends the notifications until the newline.
+The messages are dropped when no central is subscribed to it, or when longer than BN_BLE_STATS_MAX_BYTES.
+*/
+#ifndef BN_BLE_CHARA_STATS_UUID
+#define BN_BLE_CHARA_STATS_UUID "0000CCAA-0000-1000-8000-00805F9B34FB"
+#endif
+#ifndef BN_BLE_STATS_MAX_BYTES
+#define BN_BLE_STATS_MAX_BYTES 512
+#endif
+
+/*
+Control characteristic, written by the central with the control frames of BnControlFrames.h.
+The frames are queued by the BLE stack with BnBLENodeCommunicator_onControlWrite() and turned
+into the JSON actions of the WiFi nodes by getActions(), for the same dispatch in loop(). They
+wait there until the node knows its player and bodypart, i.e. until its first reading.
+A write longer than BN_BLE_CONTROL_MAX_BYTES, or one that finds the queue full, is dropped.
+*/
+#ifndef BN_BLE_CHARA_CONTROL_UUID
+#define BN_BLE_CHARA_CONTROL_UUID "0000CCA9-0000-1000-8000-00805F9B34FB"
+#endif
+#ifndef BN_BLE_CONTROL_MAX_BYTES
+#define BN_BLE_CONTROL_MAX_BYTES 64
+#endif
+#ifndef BN_BLE_CONTROL_QUEUE_LENGTH
+#define BN_BLE_CONTROL_QUEUE_LENGTH 8
+#endif
+
+struct BnBLEControlWrite {
+    uint8_t length;
+    uint8_t bytes[BN_BLE_CONTROL_MAX_BYTES];
+};
+
+// Called by the board when the central writes the control characteristic, also from the BLE stack task
+void BnBLENodeCommunicator_onControlWrite(const uint8_t bytes[], uint16_t length);
+
+// A reading ready for its characteristic: the values are already in the big endian
+// bytes the BLE characteristics carry, floats for orientation, acceleration and angular
+// velocity, uint8 for glove and shoe. The type is the BN_BINARY_RECORD_* of the reading.
+struct BnBLERecord {
+    uint8_t type;
+    uint8_t length;
+    uint8_t bytes[BN_BINARY_MAX_RECORD_BYTES - 1];
+};
+
 class BnBLENodeCommunicator {
 public:
     BnBLENodeCommunicator() :
-        bnc_messages_doc(MAX_MESSAGES_LIST_LENGTH * MAX_MESSAGE_BYTES) {
+        bnc_num_records(0), bnc_names_set(false),
+        bnc_node_id(0), bnc_stream_length(0), bnc_stream_first_ms(0), bnc_stream_seq(0) {
     }
     
     void setConnectionParams(JsonObject &params);
     void init();
     bool checkAllOk();
     void addMessage(JsonObject &message);
+    void addMessage(const String &player, const String &bodypart, BnSensorData &sensorData);
     void sendAllMessages();
     void getActions(JsonArray &actions);
 
 private:
     void checkStatus();
+    static uint8_t writeRecord(BnSensorData &sensorData, BnBLERecord &record);
+    void addStreamRecord(BnSensorData &sensorData, uint16_t capacity);
+    void sendStream();
+    bool toJsonAction(const BnControlFrame &frame, JsonObject &action);
+    void setNames(const String &player, const String &bodypart);
+    // True for the readings that carry the player and bodypart of the node
+    static bool isNodeBodypart(BnSensorData &sensorData);
     
-    DynamicJsonDocument bnc_messages_doc;
-    JsonArray bnc_messages_list;
+    BnBLERecord bnc_records[MAX_MESSAGES_LIST_LENGTH];
+    uint8_t bnc_num_records;
+    bool bnc_names_set;
+    String bnc_player;
+    String bnc_bodypart;
+
+    uint16_t bnc_node_id;
+    uint8_t bnc_stream_packet[BN_BLE_STREAM_MAX_BYTES];
+    uint16_t bnc_stream_length;
+    unsigned long bnc_stream_first_ms;
+    uint16_t bnc_stream_seq;
     
     BnBLEConnectionData bnc_connection_data;
     BnStatusLED bnc_status_LED;
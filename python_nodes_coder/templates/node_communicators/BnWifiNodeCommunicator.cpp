@@ -24,6 +24,8 @@
 
 #include "BnWifiNodeCommunicator.h"
 
+#include <string.h>
+
 #ifdef __BN__WIFI_NODE_COMMUNICATOR_H__
 
 void BnWifiNodeCommunicator::init(){
@@ -44,20 +46,49 @@ void BnWifiNodeCommunicator::init(){
   wnc_multicast_data.last_sent_time = 0;
   wnc_multicast_data.last_rec_time = 0;
 
+  wnc_wifi_link_state = BN_WIFI_LINK_IDLE;
+  wnc_wifi_link_time = millis();
+
   wnc_messages_list = wnc_messages_doc.to<JsonArray>();
+  wnc_messages_oldest_us = 0;
   wnc_actions_list = wnc_actions_doc.to<JsonArray>();
+
+  wnc_binary_packet_len = 0;
+  wnc_binary_packet_us = 0;
+  wnc_packet_seq = 0;
+  wnc_node_id = 0;
+  wnc_binary_messages = false;
+  wnc_free_heap_min = getFreeHeapBytes();
+  clearBatch();
+
+  wnc_history_first = 0;
+  wnc_history_len = 0;
+  wnc_history_dropped = 0;
+  wnc_history_last_replay = 0;
+
+  wnc_clock_sync.reset();
+  wnc_clock_sync_time = millis();
+  wnc_received_us = 0;
+
+  memset(&wnc_link_stats, 0, sizeof(wnc_link_stats));
+  wnc_link_stats.loop_last_us = micros();
+  wnc_link_stats.window_start = millis();
 }
 
 void BnWifiNodeCommunicator::setConnectionParams(JsonObject &params){
-  BnPersMemory::setValue(BN_MEMORY_WIFI_SSID_TAG, params[ BN_ACTION_SETWIFI_SSID_TAG].as<String>());
-  BnPersMemory::setValue(BN_MEMORY_WIFI_PASSWORD_TAG, params[ BN_ACTION_SETWIFI_PASSWORD_TAG].as<String>());
-  BnPersMemory::setValue(BN_MEMORY_WIFI_MULTICASTMESSAGE_TAG, params[ BN_ACTION_SETWIFI_MULTICASTMESSAGE_TAG].as<String>());
+  BnPersMemory::beginTransaction();
+  BnPersMemory::setValue(BN_MEMORY_KEY_WIFI_SSID, params[ BN_ACTION_SETWIFI_SSID_TAG].as<String>());
+  BnPersMemory::setValue(BN_MEMORY_KEY_WIFI_PASSWORD, params[ BN_ACTION_SETWIFI_PASSWORD_TAG].as<String>());
+  BnPersMemory::setValue(BN_MEMORY_KEY_WIFI_MULTICASTMESSAGE, params[ BN_ACTION_SETWIFI_MULTICASTMESSAGE_TAG].as<String>());
+  BnPersMemory::endTransaction();
 }
 
 void BnWifiNodeCommunicator::receiveBytes(){
   int size_c = wnc_connector.parsePacket();
   //DEBUG_PRINTLN(WiFi.gatewayIP());
   if(size_c>0){
+    // Arrival time of an ACKH with the host times
+    wnc_received_us = micros();
     //DEBUG_PRINT("I received some packets of size =  ");
     //DEBUG_PRINTLN(size_c);
     wnc_connection_data.num_received_bytes = wnc_connector.read(wnc_connection_data.received_bytes, MAX_RECEIVED_BYTES_LENGTH);
@@ -72,25 +103,55 @@ void BnWifiNodeCommunicator::receiveBytes(){
   }
 }
 
+bool BnWifiNodeCommunicator::connectWifi(){
+  if(wnc_wifi_link_state == BN_WIFI_LINK_BACKOFF){
+    if(millis() - wnc_wifi_link_time < BN_WIFI_RETRY_INTERVAL_MS){
+      return false;
+    }
+    wnc_wifi_link_state = BN_WIFI_LINK_IDLE;
+  }
+  if(wnc_wifi_link_state == BN_WIFI_LINK_IDLE){
+    String ssid = BnPersMemory::getValue(BN_MEMORY_KEY_WIFI_SSID);
+    String password = BnPersMemory::getValue(BN_MEMORY_KEY_WIFI_PASSWORD);
+    wnc_wifi_link_time = millis();
+    if(!beginConnectWifi(ssid, password)){
+      wnc_wifi_link_state = BN_WIFI_LINK_BACKOFF;
+      return false;
+    }
+    wnc_wifi_link_state = BN_WIFI_LINK_CONNECTING;
+  }
+
+  uint8_t wifi_status = pollConnectWifi();
+  if(wifi_status == BN_WIFI_CONNECTING && millis() - wnc_wifi_link_time < BN_WIFI_CONNECT_TIMEOUT_MS){
+    return false;
+  }
+  wnc_wifi_link_time = millis();
+  if(wifi_status != BN_WIFI_CONNECTED){
+    DEBUG_PRINTLN("Not connected to the Wifi");
+    wnc_wifi_link_state = BN_WIFI_LINK_BACKOFF;
+    // The next attempt is a retry
+    ++wnc_link_stats.retries;
+    return false;
+  }
+  wnc_wifi_link_state = BN_WIFI_LINK_IDLE;
+
+  DEBUG_PRINTLN("Connected to the Wifi");
+  //wnc_connection_data.ip_address = WiFi.gatewayIP();
+  wnc_connector.begin(BN_WIFI_PORT);
+  IPAddress multicastIP = getIPAdressFromStr(BN_WIFI_MULTICASTGROUP_DEFAULT);
+  BN_NODE_SPECIFIC_BN_WIFI_NODE_COMMUNICATOR_BEGIN_MULTICAST
+  wnc_multicast_data.setConnected();
+  printWifiStatus();
+  return true;
+}
+
 bool BnWifiNodeCommunicator::checkAllOk(){
   bool allok = false;
+  updateLoopTime();
   checkStatus();
   if (wnc_connection_data.isDisconnected()){
-    String ssid = BnPersMemory::getValue(BN_MEMORY_WIFI_SSID_TAG);
-    String password = BnPersMemory::getValue(BN_MEMORY_WIFI_PASSWORD_TAG);
-    if (!tryConnectWifi(ssid, password)){
-      DEBUG_PRINTLN("Not connected to the Wifi");
-      wnc_connection_data.setDisconnected();
-      delay(1000);
+    if (!connectWifi()){
       return false;
-    } else {
-      DEBUG_PRINTLN("Connected to the Wifi");
-      //wnc_connection_data.ip_address = WiFi.gatewayIP();
-      wnc_connector.begin(BN_WIFI_PORT);
-      IPAddress multicastIP = getIPAdressFromStr(BN_WIFI_MULTICASTGROUP_DEFAULT);
-      BN_NODE_SPECIFIC_BN_WIFI_NODE_COMMUNICATOR_BEGIN_MULTICAST
-      wnc_multicast_data.setConnected();
-      printWifiStatus();
     }
     wnc_connection_data.setWaitingACK();
   }
@@ -117,6 +178,9 @@ bool BnWifiNodeCommunicator::checkAllOk(){
     // Connected to wifi and server
     if(millis() - wnc_connection_data.last_sent_time > CONNECTION_KEEP_ALIVE_SEND_INTERVAL_MS){
       sendACKN();
+    } else if(millis() - wnc_clock_sync_time > BN_WIFI_CLOCK_SYNC_INTERVAL_MS){
+      // The data packets keep last_sent_time recent, the clock needs its own requests
+      writeACKN();
     }
     if(millis() - wnc_connection_data.last_rec_time > CONNECTION_KEEP_ALIVE_REC_INTERVAL_MS){
       wnc_connection_data.setDisconnected();
@@ -132,59 +196,406 @@ bool BnWifiNodeCommunicator::checkAllOk(){
 
 void BnWifiNodeCommunicator::addMessage(JsonObject &message){
   if(wnc_messages_list.size() >= MAX_MESSAGES_LIST_LENGTH){
-    DEBUG_PRINTLN("Too many messages in list");
-    return;
+    if(!wnc_connection_data.isConnected()){
+      DEBUG_PRINTLN("Too many messages in list");
+      ++wnc_link_stats.dropped;
+      return;
+    }
+    // The full list goes out before time rather than losing the new message
+    sendJsonMessages();
   }
 
+  if(wnc_messages_list.size() == 0){
+    // The link stats and the profiler stats start the batch time too, not only the readings
+    wnc_messages_oldest_us = micros();
+  }
   wnc_messages_list.add(message);
 }
 
-void BnWifiNodeCommunicator::sendAllMessages(){
-  if(wnc_messages_list.size() == 0) {
+void BnWifiNodeCommunicator::addMessage(const String &player, const String &bodypart, BnSensorData &sensorData){
+  if(!wnc_connection_data.isConnected()){
+    // Kept until the host is back
+    addHistorySample(sensorData);
+    return;
+  }
+  if(wnc_binary_messages && isBatching()){
+    addBatchSample(sensorData);
+    return;
+  }
+  if(wnc_binary_messages){
+    if(wnc_binary_packet_len == 0){
+      // The header is written when the packet is sent
+      wnc_binary_packet_len = BN_BINARY_HEADER_BYTES;
+      wnc_binary_packet_us = micros();
+    }
+    uint16_t written = BnBinaryMessages::writeRecord(&wnc_binary_packet[wnc_binary_packet_len],
+      BN_BINARY_MAX_PACKET_BYTES - wnc_binary_packet_len, sensorData);
+    if(written == 0){
+      DEBUG_PRINTLN("Cannot add the binary record");
+      ++wnc_link_stats.dropped;
+      return;
+    }
+    wnc_binary_packet_len += written;
     return;
   }
 
-  String messages_str;
-  serializeJson(wnc_messages_doc, messages_str);
+  StaticJsonDocument<MAX_MESSAGE_BYTES> message_doc;
+  JsonObject message = message_doc.to<JsonObject>();
+  sensorData.toJsonMessage(message, player, bodypart);
+  if(isBatching()){
+    if(wnc_messages_list.size() >= BN_WIFI_BATCH_MAX_JSON_MESSAGES){
+      sendJsonMessages();
+    }
+    addTimestamp(message, micros());
+  } else if(wnc_clock_sync.isSynced()){
+    addTimestamp(message, micros());
+  }
+  addMessage(message);
+}
 
-  uint16_t real_tot_bytes = messages_str.length();
-  DEBUG_PRINT("sendAllMessages wnc_messages_list ");
-  DEBUG_PRINT("real_tot_bytes = ");
+void BnWifiNodeCommunicator::sendAllMessages(){
+  if(wnc_binary_packet_len > BN_BINARY_HEADER_BYTES){
+    sendBinaryPacket(wnc_binary_packet_len, 0, wnc_binary_packet_us);
+  }
+  if(wnc_binary_packet_len > 0){
+    wnc_binary_packet_len = 0;
+    updateFreeHeapMin();
+  }
+
+  if(isBatching() && isBatchDue(wnc_batch_count, wnc_batch_oldest_us)){
+    flushBatch();
+  }
+
+  if(millis() - wnc_link_stats.window_start >= BN_WIFI_LINK_STATS_INTERVAL_MS){
+    addLinkStats();
+  }
+
+  if(wnc_messages_list.size() > 0
+    && (!isBatching() || wnc_binary_messages || isBatchDue(wnc_messages_list.size(), wnc_messages_oldest_us))) {
+    sendJsonMessages();
+  }
+
+  replayHistory();
+}
+
+void BnWifiNodeCommunicator::sendJsonMessages(){
+  // All the messages of a packet carry its sequence number
+  for(JsonObject message : wnc_messages_list){
+    message["seq"] = wnc_packet_seq;
+  }
+  ++wnc_packet_seq;
+  // The UDP object is a Print, the JSON goes straight into its packet buffer
+  wnc_connector.beginPacket(wnc_connection_data.ip_address, BN_WIFI_PORT);
+  size_t real_tot_bytes = serializeJson(wnc_messages_doc, wnc_connector);
+  countSent(wnc_connector.endPacket());
+  DEBUG_PRINT("sendAllMessages real_tot_bytes = ");
   DEBUG_PRINTLN(real_tot_bytes);
-  DEBUG_PRINT("messages_str = ");
-  DEBUG_PRINTLN(messages_str);
 
+  // Resetting the document just rewinds its memory pool, nothing is freed or allocated
+  wnc_messages_list = wnc_messages_doc.to<JsonArray>();
+  wnc_messages_oldest_us = 0;
+  updateFreeHeapMin();
+}
+
+void BnWifiNodeCommunicator::sendBinaryPacket(uint16_t packet_len, uint8_t flags, uint32_t packet_us){
+  if(wnc_clock_sync.isSynced()){
+    // The record timestamps went through recordTime() too
+    flags |= BN_BINARY_FLAG_HOST_TIME;
+  }
+  BnBinaryMessages::writeHeader(wnc_binary_packet, wnc_node_id, wnc_packet_seq, recordTime(packet_us), flags);
+  ++wnc_packet_seq;
   wnc_connector.beginPacket(wnc_connection_data.ip_address, BN_WIFI_PORT);
-  wnc_connector.write((uint8_t const *)messages_str.c_str(), real_tot_bytes);
-  wnc_connector.endPacket();
+  wnc_connector.write(wnc_binary_packet, packet_len);
+  countSent(wnc_connector.endPacket());
+}
+
+uint32_t BnWifiNodeCommunicator::recordTime(uint32_t node_us){
+  if(wnc_clock_sync.isSynced()){
+    return wnc_clock_sync.toHostTime(node_us);
+  }
+  return node_us;
+}
+
+void BnWifiNodeCommunicator::addTimestamp(JsonObject &message, uint32_t node_us){
+  if(wnc_clock_sync.isSynced()){
+    message["host_timestamp_us"] = wnc_clock_sync.toHostTime(node_us);
+  } else {
+    message["timestamp_us"] = node_us;
+  }
+}
+
+void BnWifiNodeCommunicator::countSent(int end_packet_result){
   wnc_connection_data.last_sent_time = millis();
-  //wnc_messages_doc.clear();
-  uint8_t num_messages = wnc_messages_doc.size();
-  for (uint8_t index = 0; index<num_messages; ++index) {
-    wnc_messages_list.remove(0);
+  if(end_packet_result == 0){
+    ++wnc_link_stats.send_failed;
+  } else {
+    ++wnc_link_stats.sent;
   }
-  wnc_messages_doc.garbageCollect();
+}
+
+void BnWifiNodeCommunicator::updateLoopTime(){
+  // checkAllOk() runs once per loop, the time between two calls is the loop time
+  const uint32_t now_us = micros();
+  const uint32_t loop_us = now_us - wnc_link_stats.loop_last_us;
+  wnc_link_stats.loop_last_us = now_us;
+  wnc_link_stats.loop_total_us += loop_us;
+  if(loop_us > wnc_link_stats.loop_max_us){
+    wnc_link_stats.loop_max_us = loop_us;
+  }
+  ++wnc_link_stats.loop_count;
+}
+
+void BnWifiNodeCommunicator::addLinkStats(){
+  const String *names[4];
+  loadNodeNames(names);
+  StaticJsonDocument<BN_WIFI_LINK_STATS_MESSAGE_BYTES> message_doc;
+  JsonObject message = message_doc.to<JsonObject>();
+  message["player"] = *names[0];
+  message["bodypart"] = *names[1];
+  message["sensortype"] = BN_SENSORTYPE_LINK_STATS_TAG;
+  JsonObject value = message.createNestedObject("value");
+  // The counters keep growing from the start, the loop times are for the last window
+  value["window_ms"] = millis() - wnc_link_stats.window_start;
+  value["sent"] = wnc_link_stats.sent;
+  value["send_failed"] = wnc_link_stats.send_failed;
+  value["dropped"] = wnc_link_stats.dropped;
+  value["retries"] = wnc_link_stats.retries;
+  value["rssi"] = BN_NODE_SPECIFIC_BN_WIFI_NODE_COMMUNICATOR_RSSI;
+  value["loop_avg_us"] = wnc_link_stats.loop_count > 0 ? wnc_link_stats.loop_total_us / wnc_link_stats.loop_count : 0;
+  value["loop_max_us"] = wnc_link_stats.loop_max_us;
+  if(wnc_clock_sync.isSynced()){
+    value["clock_delay_us"] = wnc_clock_sync.getDelay();
+    value["clock_drift_ppm"] = wnc_clock_sync.getDriftPpm();
+  }
+  addMessage(message);
+
+  wnc_link_stats.window_start = millis();
+  wnc_link_stats.loop_count = 0;
+  wnc_link_stats.loop_total_us = 0;
+  wnc_link_stats.loop_max_us = 0;
+}
+
+void BnWifiNodeCommunicator::setBatching(uint16_t batch_size, uint16_t flush_ms){
+  if(batch_size > BN_WIFI_BATCH_MAX_SAMPLES){
+    DEBUG_PRINT("Batch size limited to ");
+    DEBUG_PRINTLN(BN_WIFI_BATCH_MAX_SAMPLES);
+    batch_size = BN_WIFI_BATCH_MAX_SAMPLES;
+  }
+  if(wnc_batch_count > 0){
+    flushBatch();
+  }
+  wnc_batch_size = batch_size;
+  wnc_batch_flush_ms = flush_ms;
+  DEBUG_PRINT("Batching batch_size = ");
+  DEBUG_PRINT(wnc_batch_size);
+  DEBUG_PRINT(" flush_ms = ");
+  DEBUG_PRINTLN(wnc_batch_flush_ms);
+}
+
+bool BnWifiNodeCommunicator::isBatching(){
+  return wnc_batch_size > 1;
+}
+
+bool BnWifiNodeCommunicator::isBatchDue(uint16_t num_pending, uint32_t oldest_us){
+  if(num_pending == 0){
+    return false;
+  }
+  uint16_t batch_size = wnc_batch_size;
+  if(!wnc_binary_messages && batch_size > BN_WIFI_BATCH_MAX_JSON_MESSAGES){
+    batch_size = BN_WIFI_BATCH_MAX_JSON_MESSAGES;
+  }
+  if(num_pending >= batch_size){
+    return true;
+  }
+  return wnc_batch_flush_ms > 0 && micros() - oldest_us >= wnc_batch_flush_ms * 1000UL;
+}
+
+void BnWifiNodeCommunicator::addBatchSample(BnSensorData &sensorData){
+  if(wnc_batch_count == BN_WIFI_BATCH_MAX_SAMPLES){
+    // Nothing gets dropped, the readings in the ring go out before time
+    flushBatch();
+  }
+  BnWifiBatchSample &sample = wnc_batch_ring[(wnc_batch_first + wnc_batch_count) % BN_WIFI_BATCH_MAX_SAMPLES];
+  sample.record_len = BnBinaryMessages::writeRecord(sample.record, BN_BINARY_MAX_RECORD_BYTES, sensorData);
+  if(sample.record_len == 0){
+    DEBUG_PRINTLN("Cannot add the binary record");
+    return;
+  }
+  sample.timestamp_us = micros();
+  if(wnc_batch_count == 0){
+    wnc_batch_oldest_us = sample.timestamp_us;
+  }
+  ++wnc_batch_count;
+}
+
+void BnWifiNodeCommunicator::flushBatch(){
+  while(wnc_batch_count > 0){
+    uint16_t packet_len = BN_BINARY_HEADER_BYTES;
+    while(wnc_batch_count > 0){
+      BnWifiBatchSample &sample = wnc_batch_ring[wnc_batch_first];
+      if(packet_len + BN_BINARY_TIMESTAMP_BYTES + sample.record_len > BN_BINARY_MAX_PACKET_BYTES){
+        break;
+      }
+      packet_len += BnBinaryMessages::writeTimestamp(&wnc_binary_packet[packet_len],
+        BN_BINARY_MAX_PACKET_BYTES - packet_len, recordTime(sample.timestamp_us));
+      memcpy(&wnc_binary_packet[packet_len], sample.record, sample.record_len);
+      packet_len += sample.record_len;
+      wnc_batch_first = (wnc_batch_first + 1) % BN_WIFI_BATCH_MAX_SAMPLES;
+      --wnc_batch_count;
+    }
+    sendBinaryPacket(packet_len, BN_BINARY_FLAG_TIMESTAMPED, micros());
+  }
+  wnc_batch_first = 0;
+  updateFreeHeapMin();
+}
+
+void BnWifiNodeCommunicator::clearBatch(){
+  wnc_batch_first = 0;
+  wnc_batch_count = 0;
+  wnc_batch_oldest_us = 0;
+}
+
+void BnWifiNodeCommunicator::addHistorySample(BnSensorData &sensorData){
+  uint8_t entry[BN_BINARY_TIMESTAMP_BYTES + BN_BINARY_MAX_RECORD_BYTES];
+  uint16_t entry_len = BnBinaryMessages::writeTimestamp(entry, sizeof(entry), micros());
+  const uint16_t record_len = BnBinaryMessages::writeRecord(&entry[entry_len], sizeof(entry) - entry_len, sensorData);
+  if(record_len == 0){
+    DEBUG_PRINTLN("Cannot add the binary record");
+    return;
+  }
+  entry_len += record_len;
+  while(wnc_history_len + entry_len > BN_WIFI_HISTORY_BYTES){
+    // The oldest readings make room for the new ones
+    const uint16_t dropped_len = historySampleLength();
+    wnc_history_first = (wnc_history_first + dropped_len) % BN_WIFI_HISTORY_BYTES;
+    wnc_history_len -= dropped_len;
+    ++wnc_history_dropped;
+    ++wnc_link_stats.dropped;
+  }
+  for(uint16_t index = 0; index < entry_len; ++index){
+    wnc_history[(wnc_history_first + wnc_history_len + index) % BN_WIFI_HISTORY_BYTES] = entry[index];
+  }
+  wnc_history_len += entry_len;
+}
+
+uint16_t BnWifiNodeCommunicator::historySampleLength(){
+  if(wnc_history_len == 0){
+    return 0;
+  }
+  const uint8_t record_type = wnc_history[(wnc_history_first + BN_BINARY_TIMESTAMP_BYTES) % BN_WIFI_HISTORY_BYTES];
+  return BN_BINARY_TIMESTAMP_BYTES + BnBinaryMessages::recordLength(record_type);
+}
+
+uint16_t BnWifiNodeCommunicator::popHistorySample(uint8_t entry[]){
+  const uint16_t entry_len = historySampleLength();
+  for(uint16_t index = 0; index < entry_len; ++index){
+    entry[index] = wnc_history[(wnc_history_first + index) % BN_WIFI_HISTORY_BYTES];
+  }
+  wnc_history_first = (wnc_history_first + entry_len) % BN_WIFI_HISTORY_BYTES;
+  wnc_history_len -= entry_len;
+  return entry_len;
+}
+
+void BnWifiNodeCommunicator::replayHistory(){
+  if(wnc_history_len == 0 || millis() - wnc_history_last_replay < BN_WIFI_HISTORY_REPLAY_INTERVAL_MS){
+    return;
+  }
+  wnc_history_last_replay = millis();
+  if(wnc_history_dropped > 0){
+    DEBUG_PRINT("History readings dropped = ");
+    DEBUG_PRINTLN(wnc_history_dropped);
+    wnc_history_dropped = 0;
+  }
+
+  if(wnc_binary_messages){
+    // The entries are already in the format of the timestamped records
+    uint16_t packet_len = BN_BINARY_HEADER_BYTES;
+    while(wnc_history_len > 0 && packet_len + historySampleLength() <= BN_BINARY_MAX_PACKET_BYTES){
+      uint8_t *entry = &wnc_binary_packet[packet_len];
+      packet_len += popHistorySample(entry);
+      BnBinaryMessages::writeTimestamp(entry, BN_BINARY_TIMESTAMP_BYTES, recordTime(BnBinaryMessages::readTimestamp(entry)));
+    }
+    sendBinaryPacket(packet_len, BN_BINARY_FLAG_TIMESTAMPED | BN_BINARY_FLAG_HISTORICAL, micros());
+    return;
+  }
+
+  if(wnc_messages_list.size() > 0){
+    // The JSON messages waiting for their batch go first
+    return;
+  }
+  const String *names[4];
+  loadNodeNames(names);
+  for(uint8_t count = 0; count < BN_WIFI_HISTORY_MAX_JSON_MESSAGES && wnc_history_len > 0; ++count){
+    uint8_t entry[BN_BINARY_TIMESTAMP_BYTES + BN_BINARY_MAX_RECORD_BYTES];
+    const uint16_t entry_len = popHistorySample(entry);
+    BnSensorData sensorData;
+    if(!BnBinaryMessages::readRecord(&entry[BN_BINARY_TIMESTAMP_BYTES], entry_len - BN_BINARY_TIMESTAMP_BYTES, sensorData)){
+      continue;
+    }
+    const uint8_t record_type = entry[BN_BINARY_TIMESTAMP_BYTES];
+    const String &bodypart = record_type == BN_BINARY_RECORD_GLOVE ? *names[2]
+      : (record_type == BN_BINARY_RECORD_SHOE ? *names[3] : *names[1]);
+    StaticJsonDocument<MAX_MESSAGE_BYTES> message_doc;
+    JsonObject message = message_doc.to<JsonObject>();
+    sensorData.toJsonMessage(message, *names[0], bodypart);
+    addTimestamp(message, BnBinaryMessages::readTimestamp(entry));
+    message["historical"] = true;
+    addMessage(message);
+  }
+  if(wnc_messages_list.size() > 0){
+    sendJsonMessages();
+  }
+}
+
+void BnWifiNodeCommunicator::loadNodeNames(const String *names[]){
+  // Player, bodypart, glove bodypart and shoe bodypart. They point to the values kept by
+  // BnPersMemory, nothing is copied
+  static const String empty;
+  names[0] = &BnPersMemory::getValue(BN_MEMORY_KEY_PLAYER);
+  names[1] = &BnPersMemory::getValue(BN_MEMORY_KEY_BODYPART);
+  names[2] = &empty;
+  names[3] = &empty;
+#if defined(GLOVE_SENSOR_ON_SERIAL) || defined(GLOVE_SENSOR_ON_BOARD)
+  names[2] = &BnPersMemory::getValue(BN_MEMORY_KEY_BODYPART_GLOVE);
+#endif /*GLOVE_SENSOR_ON_SERIAL || GLOVE_SENSOR_ON_BOARD*/
+#ifdef SHOE_SENSOR_ON_BOARD
+  names[3] = &BnPersMemory::getValue(BN_MEMORY_KEY_BODYPART_SHOE);
+#endif /*SHOE_SENSOR_ON_BOARD*/
+}
+
+void BnWifiNodeCommunicator::updateFreeHeapMin(){
+  uint32_t free_heap = getFreeHeapBytes();
+  if(free_heap < wnc_free_heap_min){
+    wnc_free_heap_min = free_heap;
+  }
+}
+
+uint32_t BnWifiNodeCommunicator::getFreeHeapMin(){
+  return wnc_free_heap_min;
 }
 
 void BnWifiNodeCommunicator::getActions(JsonArray &actions){
+  if(wnc_actions_list.size() == 0) {
+    return;
+  }
   for (JsonObject action : wnc_actions_list) {
     actions.add(action);
   }
-  uint8_t num_actions = wnc_actions_list.size();
-  for (uint8_t index = 0; index<num_actions; ++index) {
-    wnc_actions_list.remove(0);
-  }
-  wnc_actions_doc.garbageCollect();
+  wnc_actions_list = wnc_actions_doc.to<JsonArray>();
 }
 
 void BnWifiNodeCommunicator::checkForActions(){
   //DEBUG_PRINT("wnc_connection_data.num_received_bytes = ");
   //DEBUG_PRINTLN(wnc_connection_data.num_received_bytes);
   if(wnc_connection_data.num_received_bytes > 0) {
+    if(BnControlFrames::isFrame(wnc_connection_data.received_bytes, wnc_connection_data.num_received_bytes)){
+      DEBUG_PRINTLN("Unexpected control frame");
+      return;
+    }
     //DEBUG_PRINTLN("Checking for actions");
-    // Deserialize the JSON document
+    // Deserialize the JSON document, the buffer is not terminated
     DynamicJsonDocument actionDoc(MAX_ACTION_BYTES);
-    DeserializationError error = deserializeJson(actionDoc, wnc_connection_data.received_bytes);
+    DeserializationError error = deserializeJson(actionDoc, wnc_connection_data.received_bytes, wnc_connection_data.num_received_bytes);
     if (error) {
       DEBUG_PRINTLN("No possible to parse the json, error =");
       DEBUG_PRINTLN(error.c_str());
@@ -221,65 +632,112 @@ void BnWifiNodeCommunicator::sendACKN(){
   if(millis() - wnc_connection_data.last_sent_time < CONNECTION_ACK_INTERVAL_MS){
     return;
   }
+  writeACKN();
+}
+
+void BnWifiNodeCommunicator::writeACKN(){
   DEBUG_PRINT("Sending ACKN to ");
   DEBUG_PRINTLN(wnc_connection_data.ip_address);
-  byte buf_udp [5] = {'A','C','K','N', '\0'};
+  byte buf_udp [MAX_ACKN_BYTES] = {'A','C','K','N', '\0'};
+  uint16_t len_udp = 5;
+#if BN_WIFI_BINARY_MESSAGES
+  // Names that the binary records refer to, the host learns them from here
+  const String *names[4];
+  loadNodeNames(names);
+  wnc_node_id = BnBinaryMessages::nodeId(*names[0], *names[1]);
+  len_udp += BnBinaryMessages::writeNodeAnnouncement(&buf_udp[len_udp], MAX_ACKN_BYTES - len_udp, wnc_node_id, names, 4);
+#endif // BN_WIFI_BINARY_MESSAGES
   wnc_connector.beginPacket(wnc_connection_data.ip_address, BN_WIFI_PORT);
-  wnc_connector.write(buf_udp, 5);
+  // 'T' and the node time t0 end the ACKN, the host can send them back with its own times
+  if(len_udp + 1 + BN_BINARY_TIMESTAMP_BYTES <= MAX_ACKN_BYTES){
+    buf_udp[len_udp++] = 'T';
+    len_udp += BnBinaryMessages::writeTimestamp(&buf_udp[len_udp], MAX_ACKN_BYTES - len_udp, micros());
+  }
+  // The host can answer with control frames
+  if(len_udp + 2 <= MAX_ACKN_BYTES){
+    buf_udp[len_udp++] = 'C';
+    buf_udp[len_udp++] = BN_CONTROL_VERSION;
+  }
+  wnc_connector.write(buf_udp, len_udp);
   wnc_connector.endPacket();
   wnc_connection_data.last_sent_time = millis();
+  wnc_clock_sync_time = millis();
 }
 
 bool BnWifiNodeCommunicator::checkForACKH(){
-  if(wnc_connection_data.num_received_bytes >= 4){
-    for(uint16_t index = 0; index<wnc_connection_data.num_received_bytes-3; ++index){
-      if( wnc_connection_data.received_bytes[index] == 'A' && wnc_connection_data.received_bytes[index+1] == 'C'
-        && wnc_connection_data.received_bytes[index+2] == 'K' && wnc_connection_data.received_bytes[index+3] == 'H') {
-        //DEBUG_PRINTLN("ACKH from Host");
-        wnc_connection_data.last_rec_time = millis();
-        return true;
-      }
+  const uint8_t *bytes = wnc_connection_data.received_bytes;
+  const uint16_t num_bytes = wnc_connection_data.num_received_bytes;
+  uint8_t binary_version = 0;
+  const uint8_t *times = nullptr;
+  BnControlFrame frame;
+  if(BnControlFrames::readFrame(bytes, num_bytes, frame)){
+    if(frame.type != BN_CONTROL_TYPE_ACKH || frame.length < 1){
+      return false;
+    }
+    binary_version = frame.payload[0];
+    if(frame.length >= 1 + 3 * BN_BINARY_TIMESTAMP_BYTES){
+      times = &frame.payload[1];
+    }
+  } else if(num_bytes >= 4 && memcmp(bytes, "ACKH", 4) == 0){
+    // Text ACKH of the hosts without control frames: "ACKH" ['B' version] ['T' t0 t1 t2]
+    uint16_t index = 4;
+    if(index + 2 <= num_bytes && bytes[index] == 'B'){
+      binary_version = bytes[index + 1];
+      index += 2;
+    }
+    if(index + 1 + 3 * BN_BINARY_TIMESTAMP_BYTES <= num_bytes && bytes[index] == 'T'){
+      times = &bytes[index + 1];
     }
-    DEBUG_PRINTLN("The message was not an ACKH");
   } else {
-    //DEBUG_PRINTLN("No ACKH received from Server");
+    if(num_bytes > 0){
+      DEBUG_PRINTLN("The message was not an ACKH");
+    }
+    return false;
   }
-  return false;
+
+  //DEBUG_PRINTLN("ACKH from Host");
+  wnc_connection_data.last_rec_time = millis();
+  if(times != nullptr){
+    // The host keeps the clocks in sync
+    wnc_clock_sync.addSample(BnBinaryMessages::readTimestamp(&times[0]), BnBinaryMessages::readTimestamp(&times[4]),
+      BnBinaryMessages::readTimestamp(&times[8]), wnc_received_us);
+  }
+  // A binary version means that the host wants the binary messages
+  bool binary_messages = BN_WIFI_BINARY_MESSAGES && binary_version == BN_BINARY_VERSION;
+  if(binary_messages != wnc_binary_messages){
+    DEBUG_PRINT("Binary messages = ");
+    DEBUG_PRINTLN(binary_messages);
+    wnc_binary_messages = binary_messages;
+    // The waiting readings were encoded for the other format
+    clearBatch();
+  }
+  return true;
 }
 
 bool BnWifiNodeCommunicator::checkForMulticastMessage() {
-  String multicastMessage = BnPersMemory::getValue(BN_MEMORY_WIFI_MULTICASTMESSAGE_TAG);
-  //DEBUG_PRINT("multicastMessage = ");
-  //DEBUG_PRINTLN(multicastMessage);
-  if(wnc_multicast_data.num_received_bytes >= multicastMessage.length()){
-    
-    //DEBUG_PRINT("wnc_multicast_data.num_received_bytes = ");
-    //DEBUG_PRINTLN(wnc_multicast_data.num_received_bytes);
-    //DEBUG_PRINTLN("wnc_multicast_data.received_bytes");
-    for(uint16_t index = 0; index<wnc_multicast_data.num_received_bytes-(multicastMessage.length()-1); ++index){
-      //DEBUG_PRINTLN(index);
-      bool checks = true;      
-      for(uint16_t index_mex = 0; checks && index_mex<multicastMessage.length(); ++index_mex){
-        //DEBUG_PRINTLN( static_cast<char>(wnc_multicast_data.received_bytes[index]) );
-        //DEBUG_PRINTLN( static_cast<char>(multicastMessage[index_mex]) );
-        if( wnc_multicast_data.received_bytes[index+index_mex] != multicastMessage[index_mex]) {
-          //DEBUG_PRINTLN( "They are different" );
-          checks = false;
-        }
-      }
-      if(checks) {
-        wnc_multicast_data.last_rec_time = millis();
-        wnc_multicast_data.cleanBytes();
-        return true;
-      }
-    }
-    //DEBUG_PRINTLN("");
+  const uint8_t *bytes = wnc_multicast_data.received_bytes;
+  const uint16_t num_bytes = wnc_multicast_data.num_received_bytes;
+  const String &multicast_message = BnPersMemory::getValue(BN_MEMORY_KEY_WIFI_MULTICASTMESSAGE);
+  const uint16_t message_len = multicast_message.length();
+  bool found = false;
+  BnControlFrame frame;
+  // An empty stored message would match any packet, memcmp over 0 bytes always succeeds
+  if(message_len == 0) {
+    found = false;
+  } else if(BnControlFrames::readFrame(bytes, num_bytes, frame)){
+    found = frame.type == BN_CONTROL_TYPE_MULTICAST && frame.length == message_len
+      && memcmp(frame.payload, multicast_message.c_str(), message_len) == 0;
+  } else if(num_bytes > 0) {
+    // The hosts without control frames send the bare message
+    found = num_bytes >= message_len && memcmp(bytes, multicast_message.c_str(), message_len) == 0;
+  }
+  if(found){
+    wnc_multicast_data.last_rec_time = millis();
+  } else if(num_bytes > 0) {
     DEBUG_PRINTLN("The message was not an BN mutlicast");
-  } else {
-    //DEBUG_PRINTLN("No BN received from Host");
   }
   wnc_multicast_data.cleanBytes();
-  return false;
+  return found;
 }
 
 void BnWifiNodeCommunicator::saveHostInfo(){
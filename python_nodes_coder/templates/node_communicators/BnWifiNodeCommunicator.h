@@ -28,6 +28,9 @@
 
 #include "BnArduinoUtils.h"
 #include "BnDatatypes.h"
+#include "BnBinaryMessages.h"
+#include "BnClockSync.h"
+#include "BnControlFrames.h"
 
 #ifndef __BN__WIFI_NODE_COMMUNICATOR_H__
 #define __BN__WIFI_NODE_COMMUNICATOR_H__
@@ -37,38 +40,199 @@
 
 #define MAX_MESSAGE_BYTES 250
 #define MAX_ACTION_BYTES  250
+#define MAX_ACKN_BYTES    220
+
+// When 1 the node offers the binary messages format in its ACKN, the host decides whether to use it
+#ifndef BN_WIFI_BINARY_MESSAGES
+#define BN_WIFI_BINARY_MESSAGES 1
+#endif
+
+/*
+Batching mode, off by default and set with the "set_batching" action.
+The readings are kept with the device time in microseconds of when they were added, and sent
+together when batch_size readings are waiting or the oldest one waited flush_ms, whichever
+comes first. A flush_ms of 0 means no time limit, a batch_size of 0 or 1 turns batching off.
+In the binary format the readings go in a ring of timestamped records, sent with the
+BN_BINARY_FLAG_TIMESTAMPED flag and split over more packets if they do not fit in one.
+In the JSON format the messages get a "timestamp_us" value and wait in the messages list,
+at most BN_WIFI_BATCH_MAX_JSON_MESSAGES of them.
+*/
+#ifndef BN_WIFI_BATCH_MAX_SAMPLES
+#define BN_WIFI_BATCH_MAX_SAMPLES 32
+#endif
+// A batched JSON message with its timestamp and sequence number takes up to about 175 bytes,
+// this many still fit in one UDP packet
+#ifndef BN_WIFI_BATCH_MAX_JSON_MESSAGES
+#define BN_WIFI_BATCH_MAX_JSON_MESSAGES 8
+#endif
+#ifndef BN_WIFI_BATCH_SIZE
+#define BN_WIFI_BATCH_SIZE 1
+#endif
+#ifndef BN_WIFI_BATCH_FLUSH_MS
+#define BN_WIFI_BATCH_FLUSH_MS 50
+#endif
+
+// Joining the network never blocks the loop, checkAllOk() starts an attempt and then polls it.
+// An attempt that does not succeed within BN_WIFI_CONNECT_TIMEOUT_MS is given up, and the next
+// one starts BN_WIFI_RETRY_INTERVAL_MS later. The sensors keep running in the meantime.
+#ifndef BN_WIFI_CONNECT_TIMEOUT_MS
+#define BN_WIFI_CONNECT_TIMEOUT_MS 15000
+#endif
+#ifndef BN_WIFI_RETRY_INTERVAL_MS
+#define BN_WIFI_RETRY_INTERVAL_MS 1000
+#endif
+
+#define BN_WIFI_LINK_IDLE       0
+#define BN_WIFI_LINK_CONNECTING 1
+#define BN_WIFI_LINK_BACKOFF    2
+
+/*
+Store and forward. The readings taken while the node is not connected to the host are kept in
+a ring of BN_WIFI_HISTORY_BYTES bytes, each one as the device time in microseconds followed by
+its binary record. When the ring is full the oldest readings make room for the new ones.
+Once the host is back they are replayed next to the live readings, one packet every
+BN_WIFI_HISTORY_REPLAY_INTERVAL_MS: in the binary format with the BN_BINARY_FLAG_HISTORICAL
+flag, in the JSON format as messages with "timestamp_us" and "historical" : true.
+*/
+#ifndef BN_WIFI_HISTORY_BYTES
+#define BN_WIFI_HISTORY_BYTES 4096
+#endif
+#ifndef BN_WIFI_HISTORY_REPLAY_INTERVAL_MS
+#define BN_WIFI_HISTORY_REPLAY_INTERVAL_MS 20
+#endif
+// A historical JSON message takes up to about 195 bytes, this many still fit in one UDP packet
+#ifndef BN_WIFI_HISTORY_MAX_JSON_MESSAGES
+#define BN_WIFI_HISTORY_MAX_JSON_MESSAGES 7
+#endif
+
+// Every BN_WIFI_LINK_STATS_INTERVAL_MS the node sends a "link_stats" message with its counters,
+// the RSSI and the loop timing, for the host to work out the loss rate of the node. The host can
+// also spot the lost, reordered or repeated packets with their sequence numbers: the header
+// sequence number of the binary packets and the "seq" value of the JSON messages, one counter
+// for both.
+#ifndef BN_WIFI_LINK_STATS_INTERVAL_MS
+#define BN_WIFI_LINK_STATS_INTERVAL_MS 5000
+#endif
+#define BN_WIFI_LINK_STATS_MESSAGE_BYTES 512
+
+/*
+Clock sync. The ACKN ends with 'T' and the node time t0 in microseconds u32. A host that keeps
+the clocks in sync replies "ACKH" ['B' version] 'T' t0 t1 t2, where t1 is its time when the ACKN
+arrived and t2 its time when the ACKH left, all u32 little endian in microseconds (see BnClockSync.h).
+While connected the node sends an ACKN every BN_WIFI_CLOCK_SYNC_INTERVAL_MS for this.
+Once in sync the readings carry the host time: the binary packets get BN_BINARY_FLAG_HOST_TIME,
+the JSON messages a "host_timestamp_us" value in place of "timestamp_us".
+*/
+#ifndef BN_WIFI_CLOCK_SYNC_INTERVAL_MS
+#define BN_WIFI_CLOCK_SYNC_INTERVAL_MS 2000
+#endif
+
+struct BnWifiLinkStats {
+  uint32_t sent;            // Packets sent
+  uint32_t send_failed;     // Packets the UDP stack did not take
+  uint32_t dropped;         // Readings dropped before they could go in a packet
+  uint32_t retries;         // Attempts to join the network after a failed one
+  uint32_t loop_count;
+  uint32_t loop_total_us;
+  uint32_t loop_max_us;
+  uint32_t loop_last_us;
+  uint32_t window_start;
+};
+
+struct BnWifiBatchSample {
+  uint32_t timestamp_us;
+  uint8_t record_len;
+  uint8_t record[BN_BINARY_MAX_RECORD_BYTES];
+};
 
 class BnWifiNodeCommunicator {
 public:
   BnWifiNodeCommunicator() :
     wnc_messages_doc(MAX_MESSAGES_LIST_LENGTH * MAX_MESSAGE_BYTES),
-    wnc_actions_doc(MAX_ACTIONS_LIST_LENGTH * MAX_ACTION_BYTES) {
+    wnc_actions_doc(MAX_ACTIONS_LIST_LENGTH * MAX_ACTION_BYTES),
+    wnc_batch_size(BN_WIFI_BATCH_SIZE),
+    wnc_batch_flush_ms(BN_WIFI_BATCH_FLUSH_MS) {
   }
 
   void setConnectionParams(JsonObject &params);
   void init();
   bool checkAllOk();
   void addMessage(JsonObject &message);
+  void addMessage(const String &player, const String &bodypart, BnSensorData &sensorData);
   void sendAllMessages();
+  void setBatching(uint16_t batch_size, uint16_t flush_ms);
   void getActions(JsonArray &actions);
+  // Lowest free heap seen after sending the messages, a steady value means that sending does not allocate
+  uint32_t getFreeHeapMin();
 
 private:
+  bool connectWifi();
   void receiveBytes();
   void sendACKN();
+  void writeACKN();
   bool checkForACKH();
   void checkForActions();
   void checkStatus();
   bool checkForMulticastMessage();
   void saveHostInfo();
   bool hasHostInfo();
+  void updateFreeHeapMin();
+  void sendJsonMessages();
+  bool isBatching();
+  bool isBatchDue(uint16_t num_pending, uint32_t oldest_us);
+  void addBatchSample(BnSensorData &sensorData);
+  void flushBatch();
+  void clearBatch();
+  void addHistorySample(BnSensorData &sensorData);
+  uint16_t historySampleLength();
+  uint16_t popHistorySample(uint8_t entry[]);
+  void replayHistory();
+  void loadNodeNames(const String *names[]);
+  void sendBinaryPacket(uint16_t packet_len, uint8_t flags, uint32_t packet_us);
+  uint32_t recordTime(uint32_t node_us);
+  void addTimestamp(JsonObject &message, uint32_t node_us);
+  void countSent(int end_packet_result);
+  void updateLoopTime();
+  void addLinkStats();
 
   BN_NODE_SPECIFIC_BN_WIFI_NODE_COMMUNICATOR_UDP_OBJ wnc_connector;
   BN_NODE_SPECIFIC_BN_WIFI_NODE_COMMUNICATOR_UDP_OBJ wnc_multicast_connector;
   DynamicJsonDocument wnc_messages_doc;
   JsonArray wnc_messages_list;
+  uint32_t wnc_messages_oldest_us;
   DynamicJsonDocument wnc_actions_doc;
   JsonArray wnc_actions_list;
 
+  uint8_t wnc_binary_packet[BN_BINARY_MAX_PACKET_BYTES];
+  uint16_t wnc_binary_packet_len;
+  uint32_t wnc_binary_packet_us;
+  uint16_t wnc_packet_seq;
+  uint16_t wnc_node_id;
+  bool wnc_binary_messages;
+  uint32_t wnc_free_heap_min;
+
+  BnWifiBatchSample wnc_batch_ring[BN_WIFI_BATCH_MAX_SAMPLES];
+  uint8_t wnc_batch_first;
+  uint8_t wnc_batch_count;
+  uint16_t wnc_batch_size;
+  uint16_t wnc_batch_flush_ms;
+  uint32_t wnc_batch_oldest_us;
+
+  uint8_t wnc_history[BN_WIFI_HISTORY_BYTES];
+  uint16_t wnc_history_first;
+  uint16_t wnc_history_len;
+  uint32_t wnc_history_dropped;
+  uint32_t wnc_history_last_replay;
+
+  BnWifiLinkStats wnc_link_stats;
+
+  BnClockSync wnc_clock_sync;
+  uint32_t wnc_clock_sync_time;
+  uint32_t wnc_received_us;
+
+  uint8_t wnc_wifi_link_state;
+  uint32_t wnc_wifi_link_time;
+
   BnIPConnectionData wnc_connection_data;
   BnIPConnectionData wnc_multicast_data;
   BnStatusLED wnc_status_LED;